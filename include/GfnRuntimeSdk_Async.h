@@ -0,0 +1,521 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+//
+// ===============================================================================================
+//
+// Header-only C++ futures over the asynchronous wrapper APIs
+//
+// ===============================================================================================
+/**
+* @file GfnRuntimeSdk_Async.h
+*
+* Future-based C++ layer over @ref GfnStartStreamAsync and @ref GfnStopStreamAsync
+*/
+///
+/// @page async_apis C++ Futures for Asynchronous Wrapper APIs
+///
+/// @ref GfnStartStreamAsync and @ref GfnStopStreamAsync report completion through a C callback
+/// and a context pointer. This header wraps them in GfnRuntimeSdk::Future objects that can be
+/// waited on, given a timeout, canceled, joined with GfnRuntimeSdk::WhenAll, and continued
+/// with Future::then on an executor of the caller's choosing, so a UI or render thread never
+/// has to block on a stream starting.
+///
+/// An executor is any callable that takes a std::function<void()> and arranges for it to run,
+/// for example by posting it to the UI thread's message loop. GfnRuntimeSdk::InlineExecutor
+/// runs it right away on the thread that completed the future.
+///
+/// @code
+/// GfnRuntimeSdk::StartStreamAsync(input, 300000)
+///     .withTimeout(std::chrono::minutes(1))
+///     .then(postToUiThread, [](const GfnRuntimeSdk::Future<StartStreamResponse>& started)
+///     {
+///         ShowStreamStatus(started.status());
+///     });
+/// @endcode
+///
+/// A future completes exactly once: whichever of the operation, a timeout or a cancel gets
+/// there first decides its status, anything after that is ignored. Canceling or timing out
+/// only stops waiting, the SDK has no way to abort a stream that is starting.
+
+#ifndef GFN_SDK_RUNTIME_ASYNC_H
+#define GFN_SDK_RUNTIME_ASYNC_H
+
+#ifndef __cplusplus
+#error GfnRuntimeSdk_Async.h requires C++17, use the callbacks of the C APIs from C
+#endif
+
+#include "GfnRuntimeSdk_Wrapper.h"
+
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace GfnRuntimeSdk
+{
+    template <typename T>
+    class Future;
+
+    /// @brief Executor that runs continuations on the thread that completed the future
+    struct InlineExecutor
+    {
+        void operator()(std::function<void()> task) const
+        {
+            task();
+        }
+    };
+
+    namespace detail
+    {
+        // Completion status and continuations shared by all copies of a future
+        class StateBase
+        {
+        public:
+            virtual ~StateBase() = default;
+
+            bool ready() const
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_ready;
+            }
+
+            GfnRuntimeError status() const
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_status;
+            }
+
+            GfnRuntimeError wait() const
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this]() { return m_ready; });
+                return m_status;
+            }
+
+            bool waitFor(std::chrono::milliseconds timeout) const
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                return m_done.wait_for(lock, timeout, [this]() { return m_ready; });
+            }
+
+            // Runs fn on the completing thread, or right away when already complete
+            void onComplete(std::function<void()> fn)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_ready)
+                    {
+                        m_continuations.push_back(std::move(fn));
+                        return;
+                    }
+                }
+                fn();
+            }
+
+            // Completes without a value, returns false when already complete
+            bool fail(GfnRuntimeError status)
+            {
+                return settle(status, []() {});
+            }
+
+        protected:
+            template <typename Store>
+            bool settle(GfnRuntimeError status, Store&& store)
+            {
+                std::vector<std::function<void()>> continuations;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_ready)
+                    {
+                        return false;
+                    }
+                    store();
+                    m_status = status;
+                    m_ready = true;
+                    continuations.swap(m_continuations);
+                }
+                m_done.notify_all();
+                for (auto& continuation : continuations)
+                {
+                    continuation();
+                }
+                return true;
+            }
+
+        private:
+            mutable std::mutex m_mutex;
+            mutable std::condition_variable m_done;
+            bool m_ready = false;
+            GfnRuntimeError m_status = gfnSuccess;
+            std::vector<std::function<void()>> m_continuations;
+        };
+
+        template <typename T>
+        class State : public StateBase
+        {
+        public:
+            bool resolve(GfnRuntimeError status, T value)
+            {
+                return settle(status, [&]() { m_value = std::move(value); });
+            }
+
+            // Only read once the state is complete, which is never written again
+            const T& value() const
+            {
+                return m_value;
+            }
+
+        private:
+            T m_value{};
+        };
+
+        template <>
+        class State<void> : public StateBase
+        {
+        public:
+            bool resolve(GfnRuntimeError status)
+            {
+                return fail(status);
+            }
+        };
+
+        template <typename R>
+        struct IsFuture : std::false_type {};
+
+        template <typename U>
+        struct IsFuture<Future<U>> : std::true_type {};
+
+        // Future returned by then() for a continuation returning R
+        template <typename R>
+        struct ContinuationFuture
+        {
+            using type = Future<R>;
+        };
+
+        template <typename U>
+        struct ContinuationFuture<Future<U>>
+        {
+            using type = Future<U>;
+        };
+
+        template <typename U>
+        void forward(const Future<U>& from, const std::shared_ptr<State<U>>& to)
+        {
+            if constexpr (std::is_void_v<U>)
+            {
+                to->resolve(from.status());
+            }
+            else
+            {
+                to->resolve(from.status(), from.value());
+            }
+        }
+
+        template <typename F, typename T, typename U>
+        void runContinuation(F& fn, const Future<T>& source, const std::shared_ptr<State<U>>& next)
+        {
+            using R = std::invoke_result_t<F&, const Future<T>&>;
+            try
+            {
+                if constexpr (IsFuture<R>::value)
+                {
+                    R inner = fn(source);
+                    if (!inner.valid())
+                    {
+                        next->fail(gfnInvalidParameter);
+                        return;
+                    }
+                    inner.onComplete([inner, next]() { forward(inner, next); });
+                }
+                else if constexpr (std::is_void_v<R>)
+                {
+                    fn(source);
+                    next->resolve(gfnSuccess);
+                }
+                else
+                {
+                    next->resolve(gfnSuccess, fn(source));
+                }
+            }
+            catch (...)
+            {
+                next->fail(gfnUnhandledException);
+            }
+        }
+
+        inline void CALLBACK timeoutElapsed(PTP_CALLBACK_INSTANCE, PVOID context, PTP_TIMER timer)
+        {
+            auto* pState = static_cast<std::shared_ptr<StateBase>*>(context);
+            (*pState)->fail(gfnTimedOut);
+            delete pState;
+            CloseThreadpoolTimer(timer);
+        }
+
+        // The timer keeps the state alive until it fires, even when the future completed first
+        inline void armTimeout(const std::shared_ptr<StateBase>& state, std::chrono::milliseconds timeout)
+        {
+            if (state->ready())
+            {
+                return;
+            }
+
+            auto* pContext = new std::shared_ptr<StateBase>(state);
+            PTP_TIMER timer = CreateThreadpoolTimer(&timeoutElapsed, pContext, nullptr);
+            if (timer == nullptr)
+            {
+                delete pContext;
+                state->fail(gfnInternalError);
+                return;
+            }
+
+            // Negative due times are relative, in 100 nanosecond units
+            ULARGE_INTEGER due;
+            due.QuadPart = static_cast<ULONGLONG>(-static_cast<LONGLONG>(timeout.count()) * 10000);
+            FILETIME dueTime = { due.LowPart, due.HighPart };
+            SetThreadpoolTimer(timer, &dueTime, 0, 0);
+        }
+
+        // Owns copies of the input strings until the SDK reports back
+        struct StartStreamOperation
+        {
+            std::shared_ptr<State<StartStreamResponse>> state;
+            std::string authToken;
+            std::string customData;
+            std::string customAuth;
+            StartStreamInput input;
+        };
+
+        inline const char* copyOptional(const char* value, std::string& storage)
+        {
+            if (value == nullptr)
+            {
+                return nullptr;
+            }
+            storage = value;
+            return storage.c_str();
+        }
+
+        inline void GFN_CALLBACK startStreamDone(GfnRuntimeError status, StartStreamResponse* response, void* context)
+        {
+            std::unique_ptr<StartStreamOperation> operation(static_cast<StartStreamOperation*>(context));
+            operation->state->resolve(status, response != nullptr ? *response : StartStreamResponse{});
+        }
+
+        inline void GFN_CALLBACK stopStreamDone(GfnRuntimeError status, void* context)
+        {
+            std::unique_ptr<std::shared_ptr<State<void>>> state(static_cast<std::shared_ptr<State<void>>*>(context));
+            (*state)->resolve(status);
+        }
+    }
+
+    ///
+    /// @brief Result of an asynchronous wrapper API. Copies share the same result.
+    ///
+    /// value() is only meaningful once the future is ready, and holds what the SDK reported even
+    /// when status() is an error. A future canceled with cancel() completes with gfnCanceled, one
+    /// that ran out of time set with withTimeout() with gfnTimedOut.
+    template <typename T>
+    class Future
+    {
+    public:
+        using value_type = T;
+
+        Future() = default;
+
+        explicit Future(std::shared_ptr<detail::State<T>> state) :
+            m_state(std::move(state))
+        {}
+
+        /// False for a default-constructed future, which must not be used otherwise
+        bool valid() const
+        {
+            return m_state != nullptr;
+        }
+
+        bool ready() const
+        {
+            return m_state->ready();
+        }
+
+        /// Blocks until the future is ready and returns its status
+        GfnRuntimeError wait() const
+        {
+            return m_state->wait();
+        }
+
+        /// Blocks for at most timeout, returns whether the future is ready
+        bool waitFor(std::chrono::milliseconds timeout) const
+        {
+            return m_state->waitFor(timeout);
+        }
+
+        GfnRuntimeError status() const
+        {
+            return m_state->status();
+        }
+
+        template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+        const U& value() const
+        {
+            return m_state->value();
+        }
+
+        /// Completes the future with gfnCanceled unless it already completed
+        bool cancel() const
+        {
+            return m_state->fail(gfnCanceled);
+        }
+
+        /// Completes the future with gfnTimedOut unless it completes within timeout. Several
+        /// timeouts can be set on the same future, the first to elapse wins.
+        Future withTimeout(std::chrono::milliseconds timeout) const
+        {
+            detail::armTimeout(m_state, timeout);
+            return *this;
+        }
+
+        /// Runs fn on the thread that completes the future, or right away when it is ready
+        void onComplete(std::function<void()> fn) const
+        {
+            m_state->onComplete(std::move(fn));
+        }
+
+        ///
+        /// Hands fn(const Future&) to executor once this future is ready. The returned future
+        /// completes with what fn returns: the result of the future fn returns, the value fn
+        /// returns, or just gfnSuccess when fn returns nothing. An exception thrown by fn
+        /// completes it with gfnUnhandledException.
+        template <typename Executor, typename F>
+        auto then(Executor executor, F fn) const
+        {
+            using R = std::invoke_result_t<F&, const Future&>;
+            using Next = typename detail::ContinuationFuture<R>::type;
+            auto next = std::make_shared<detail::State<typename Next::value_type>>();
+
+            Future self = *this;
+            m_state->onComplete([executor, fn, self, next]() mutable
+            {
+                executor([fn, self, next]() mutable { detail::runContinuation(fn, self, next); });
+            });
+            return Next(next);
+        }
+
+    private:
+        std::shared_ptr<detail::State<T>> m_state;
+    };
+
+    ///
+    /// @brief Completes once all futures have completed, with the first error among them or
+    /// gfnSuccess
+    template <typename... T>
+    Future<void> WhenAll(const Future<T>&... futures)
+    {
+        auto all = std::make_shared<detail::State<void>>();
+        if constexpr (sizeof...(T) == 0)
+        {
+            all->resolve(gfnSuccess);
+        }
+        else
+        {
+            struct Join
+            {
+                std::atomic<size_t> pending{ sizeof...(T) };
+                std::atomic<int> firstError{ gfnSuccess };
+            };
+            auto join = std::make_shared<Join>();
+            auto arrive = [all, join](GfnRuntimeError status)
+            {
+                if (GFNSDK_FAILED(status))
+                {
+                    int expected = gfnSuccess;
+                    join->firstError.compare_exchange_strong(expected, status);
+                }
+                if (join->pending.fetch_sub(1) == 1)
+                {
+                    all->resolve(static_cast<GfnRuntimeError>(join->firstError.load()));
+                }
+            };
+            (futures.onComplete([arrive, futures]() { arrive(futures.status()); }), ...);
+        }
+        return Future<void>(all);
+    }
+
+    ///
+    /// @brief Calls @ref GfnStartStreamAsync and returns a future for its result. The strings
+    /// in input are copied, so input doesn't need to outlive the call.
+    ///
+    /// @param input                    - Same as for @ref GfnStartStreamAsync
+    /// @param timeoutMs                - Same as for @ref GfnStartStreamAsync
+    inline Future<StartStreamResponse> StartStreamAsync(const StartStreamInput& input, unsigned int timeoutMs)
+    {
+        auto operation = std::make_unique<detail::StartStreamOperation>();
+        auto state = std::make_shared<detail::State<StartStreamResponse>>();
+        operation->state = state;
+        operation->input = input;
+        operation->input.pchAuthToken = detail::copyOptional(input.pchAuthToken, operation->authToken);
+        operation->input.pchCustomData = detail::copyOptional(input.pchCustomData, operation->customData);
+        operation->input.pchCustomAuth = detail::copyOptional(input.pchCustomAuth, operation->customAuth);
+
+        // The callback may run before the call returns, it owns the operation from here on
+        detail::StartStreamOperation* pOperation = operation.release();
+        GfnRuntimeError status = GfnStartStreamAsync(&pOperation->input, &detail::startStreamDone, pOperation, timeoutMs);
+        if (GFNSDK_FAILED(status))
+        {
+            // Not passed on to the SDK, so no callback is coming
+            delete pOperation;
+            state->resolve(status, StartStreamResponse{});
+        }
+        return Future<StartStreamResponse>(state);
+    }
+
+    ///
+    /// @brief Calls @ref GfnStopStreamAsync and returns a future for its result
+    ///
+    /// @param timeoutMs                - Same as for @ref GfnStopStreamAsync
+    inline Future<void> StopStreamAsync(unsigned int timeoutMs)
+    {
+        auto state = std::make_shared<detail::State<void>>();
+        auto* pContext = new std::shared_ptr<detail::State<void>>(state);
+        GfnRuntimeError status = GfnStopStreamAsync(&detail::stopStreamDone, pContext, timeoutMs);
+        if (GFNSDK_FAILED(status))
+        {
+            delete pContext;
+            state->resolve(status);
+        }
+        return Future<void>(state);
+    }
+}
+
+#endif // GFN_SDK_RUNTIME_ASYNC_H
@@ -32,33 +32,51 @@
 #endif
 
 #include <stdio.h>
-
-// Set compile flag GFN_SDK_WRAPPER_LOG to enable simple logging
+#include <stdarg.h>
+#include <string.h>
+
+// Set compile flag GFN_SDK_WRAPPER_LOG to enable logging.
+// Records are captured in binary form (format pointer plus raw arguments) into a lock-free
+// queue and formatted by a background thread, so a log call costs a few stores on the caller.
+// The threshold can be changed at runtime with the GFN_SDK_WRAPPER_LOG_LEVEL environment
+// variable (verbose, info, error or none), read when logging is initialized.
 #ifdef GFN_SDK_WRAPPER_LOG
+    typedef enum gfnLogLevel
+    {
+        gfnLogLevelVerbose = 0,
+        gfnLogLevelInfo,
+        gfnLogLevelError,
+        gfnLogLevelNone
+    } gfnLogLevel;
+    static volatile LONG s_logLevel = gfnLogLevelInfo;
 #   define GFN_SDK_INIT_LOGGING() gfnInitLogging();
 #   define GFN_SDK_DEINIT_LOGGING() gfnDeinitLogging();
-#   define GFN_SDK_LOG(fmt, ...) gfnLog(__FUNCTION__, __LINE__, fmt, ##__VA_ARGS__)
-#   define kGfnLogBufLen 1024
-    typedef struct gfnLogData
-    {
-        char buffer[kGfnLogBufLen];
-        SYSTEMTIME timeBuffer;
-    } gfnLogData;
-    static gfnLogData s_logData;
+#   define GFN_SDK_LOG_AT(level, fmt, ...)                                      \
+    do                                                                          \
+    {                                                                           \
+        if ((LONG)(level) >= s_logLevel)                                        \
+        {                                                                       \
+            gfnLog(level, __FUNCTION__, __LINE__, fmt, ##__VA_ARGS__);          \
+        }                                                                       \
+    } while (0)
+#   define GFN_SDK_LOG(fmt, ...) GFN_SDK_LOG_AT(gfnLogLevelInfo, fmt, ##__VA_ARGS__)
+#   define GFN_SDK_LOG_ERROR(fmt, ...) GFN_SDK_LOG_AT(gfnLogLevelError, fmt, ##__VA_ARGS__)
     static FILE* s_logfile = NULL;
-    static void gfnLog(char const* func, int line, char const* format, ...);
+    static void gfnLog(gfnLogLevel level, char const* func, int line, char const* format, ...);
     static void gfnInitLogging();
     static void gfnDeinitLogging();
 #else
 #   define GFN_SDK_INIT_LOGGING()
 #   define GFN_SDK_DEINIT_LOGGING()
 #   define GFN_SDK_LOG(fmt, ...)
+#   define GFN_SDK_LOG_ERROR(fmt, ...)
 #endif
 bool g_LoggingInitialized = false;
 
 #ifdef _WIN32
 #   include <ShlObj.h>
 #   include <shlwapi.h>
+#   include <intrin.h>
 #   ifdef _WIN64
 #       define GFN_DLL L"GFN.dll"
 #   else
@@ -144,6 +162,154 @@ GfnSdkCloudLibrary* g_pCloudLibrary = NULL;
 wchar_t g_cloudDllPath[MAX_PATH];
 GfnRuntimeError g_cloudLibraryStatus = gfnAPINotInit;
 
+typedef struct GfnSdkClientLibrary_t
+{
+    void* handle;                   // g_gfnSdkModule, owned by GfnInitializeSdkFromPath/GfnShutdownSdk
+    gfnInitializeRuntimeSdkFn InitializeRuntimeSdk;
+    gfnShutdownRuntimeSdkFn ShutdownRuntimeSdk;
+    gfnRegisterStreamStatusCallbackFn RegisterStreamStatusCallback;
+    gfnStartStreamFn StartStream;
+    gfnStartStreamAsyncFn StartStreamAsync;
+    gfnStopStreamFn StopStream;
+    gfnStopStreamAsyncFn StopStreamAsync;
+    gfnTitleExitedFn TitleExited;
+} GfnSdkClientLibrary;
+GfnSdkClientLibrary* g_pClientLibrary = NULL;
+
+// Entry points used by the public APIs. An entry is only set once the API is known to be
+// callable (library loaded, right environment, export present), so a successful call is a
+// single indirect call. A NULL entry sends the call down the checked path, which works out
+// which error to return.
+typedef struct GfnSdkDispatch_t
+{
+    // Client library
+    gfnRegisterStreamStatusCallbackFn RegisterStreamStatusCallback;
+    gfnStartStreamFn StartStream;
+    gfnStartStreamAsyncFn StartStreamAsync;
+    gfnStopStreamFn StopStream;
+    gfnStopStreamAsyncFn StopStreamAsync;
+    gfnTitleExitedFn TitleExited;
+
+    // Cloud library, only set when running in the cloud
+    gfnFreeFn Free;
+    gfnGetClientIpFn GetClientIp;
+    gfnGetClientLanguageCodeFn GetClientLanguageCode;
+    gfnGetClientCountryCodeFn GetClientCountryCode;
+    gfnGetCustomDataFn GetCustomData;
+    gfnGetAuthDataFn GetAuthData;
+    gfnIsTitleAvailableFn IsTitleAvailable;
+    gfnGetTitlesAvailableFn GetTitlesAvailable;
+    gfnGetClientInfoFn GetClientInfo;
+    gfnSetupTitleFn SetupTitle;
+    gfnAppReadyFn AppReady;
+    gfnSetActionZoneFn SetActionZone;
+    gfnRegisterCallbackFn RegisterExitCallback;
+    gfnRegisterCallbackFn RegisterSaveCallback;
+    gfnRegisterCallbackFn RegisterSessionInitCallback;
+    gfnRegisterCallbackFn RegisterPauseCallback;
+    gfnRegisterCallbackFn RegisterInstallCallback;
+    gfnRegisterCallbackFn RegisterClientInfoCallback;
+} GfnSdkDispatch;
+static const GfnSdkDispatch s_uninitializedDispatch = { 0 };
+static GfnSdkDispatch s_resolvedDispatch;
+static const GfnSdkDispatch* volatile g_pDispatch = &s_uninitializedDispatch;
+
+// Wrapper lifetime. Initialization and shutdown run under s_initLock, so threads racing on
+// GfnInitializeSdk queue up behind the first one and find the work done instead of loading the
+// libraries again. Every global above is written under the lock before the dispatch table and
+// then the state are published, so a thread that observes gfnWrapperInitialized sees them fully
+// set up. The API entry points never take the lock: they load g_pDispatch once and call through it.
+// Calls must not race GfnShutdownSdk, which unloads the libraries the table points into.
+typedef enum GfnWrapperState
+{
+    gfnWrapperUninitialized = 0,
+    gfnWrapperInitialized
+} GfnWrapperState;
+static volatile LONG s_wrapperState = gfnWrapperUninitialized;
+static SRWLOCK s_initLock = SRWLOCK_INIT;
+
+// x86 and x64 never reorder a load with later accesses or a store with earlier ones,
+// so there only the compiler has to be kept from moving accesses across these
+static LONG gfnLoadAcquire(volatile LONG* p)
+{
+    LONG value = *p;
+#if defined(_M_IX86) || defined(_M_X64)
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+    return value;
+}
+
+static void gfnStoreRelease(volatile LONG* p, LONG value)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+    *p = value;
+}
+
+// Keeps earlier loads from moving past later ones
+static void gfnReadFence(void)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+}
+
+// Entries are only read through the pointer, which orders them after it on every target
+static const GfnSdkDispatch* gfnLoadDispatch(void)
+{
+    return g_pDispatch;
+}
+
+static void gfnPublishDispatch(const GfnSdkDispatch* pDispatch)
+{
+    InterlockedExchangePointer((PVOID volatile*)&g_pDispatch, (PVOID)pDispatch);
+}
+
+static void gfnFreeClientLibrary(GfnSdkClientLibrary* pClientLibrary)
+{
+    // The module itself is released together with g_gfnSdkModule
+    free(pClientLibrary);
+}
+
+static GfnRuntimeError gfnLoadClientLibrary(HMODULE library, GfnSdkClientLibrary** ppClientLibrary)
+{
+    *ppClientLibrary = NULL;
+
+    GfnSdkClientLibrary* pClientLibrary = (GfnSdkClientLibrary*)malloc(sizeof(GfnSdkClientLibrary));
+    if (pClientLibrary == NULL)
+    {
+        GFN_SDK_LOG_ERROR("ERROR: Unable to allocate memory to hold client function pointers");
+        return gfnUnableToAllocateMemory;
+    }
+
+    pClientLibrary->handle = library;
+    pClientLibrary->InitializeRuntimeSdk = (gfnInitializeRuntimeSdkFn)GetProcAddress(library, "gfnInitializeRuntimeSdk");
+    pClientLibrary->ShutdownRuntimeSdk = (gfnShutdownRuntimeSdkFn)GetProcAddress(library, "gfnShutdownRuntimeSdk");
+    pClientLibrary->RegisterStreamStatusCallback = (gfnRegisterStreamStatusCallbackFn)GetProcAddress(library, "gfnRegisterStreamStatusCallback");
+    pClientLibrary->StartStream = (gfnStartStreamFn)GetProcAddress(library, "gfnStartStream");
+    pClientLibrary->StartStreamAsync = (gfnStartStreamAsyncFn)GetProcAddress(library, "gfnStartStreamAsync");
+    pClientLibrary->StopStream = (gfnStopStreamFn)GetProcAddress(library, "gfnStopStream");
+    pClientLibrary->StopStreamAsync = (gfnStopStreamAsyncFn)GetProcAddress(library, "gfnStopStreamAsync");
+    pClientLibrary->TitleExited = (gfnTitleExitedFn)GetProcAddress(library, "gfnTitleExited");
+
+    if (pClientLibrary->InitializeRuntimeSdk == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Unable to find client initialize function pointer");
+        gfnFreeClientLibrary(pClientLibrary);
+        return gfnAPINotFound;
+    }
+
+    *ppClientLibrary = pClientLibrary;
+    return gfnSuccess;
+}
+
 static void gfnFreeCloudLibrary(GfnSdkCloudLibrary* pCloudLibrary)
 {
 #ifdef _WIN32
@@ -192,17 +358,26 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
     *ppCloudLibrary = NULL;
 
 #ifdef _WIN32
+#ifdef GFN_SDK_ALLOW_UNSIGNED_LIBRARY
+    // Test builds can point the wrapper at a stand-in cloud library
+    DWORD overrideLength = GetEnvironmentVariableW(L"GFN_SDK_CLOUD_LIBRARY_PATH", g_cloudDllPath, MAX_PATH);
+    if (overrideLength > 0 && overrideLength < MAX_PATH)
+    {
+        GFN_SDK_LOG("Using cloud library override");
+    }
+    else
+#endif
     if (SHGetSpecialFolderPathW(NULL, g_cloudDllPath, CSIDL_PROGRAM_FILES, false) == TRUE)
     {
         if (wcscat_s(g_cloudDllPath, MAX_PATH, GFN_DLL_SUBPATH) != 0)
         {
-            GFN_SDK_LOG("FAIL: Unable to concatenate path to Runtime SDK binaries");
+            GFN_SDK_LOG_ERROR("FAIL: Unable to concatenate path to Runtime SDK binaries");
             return gfnInitFailure;
         }
     }
     else
     {
-        GFN_SDK_LOG("FAIL: Unable to get path to Runtime SDK binaries");
+        GFN_SDK_LOG_ERROR("FAIL: Unable to get path to Runtime SDK binaries");
         return gfnInitFailure;
     }
 
@@ -212,7 +387,7 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
         return gfnCloudLibraryNotFound;
     }
 
-#ifdef _DEBUG
+#if defined(_DEBUG) || defined(GFN_SDK_ALLOW_UNSIGNED_LIBRARY)
     HMODULE library = LoadLibraryW(g_cloudDllPath);
 #else
     HMODULE library = gfnSecureLoadCloudLibraryW(g_cloudDllPath, 0);
@@ -223,12 +398,12 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
         DWORD lastError = GetLastError();
         if (lastError == CRYPT_E_NO_MATCH)
         {
-            GFN_SDK_LOG("ERROR: GFN library failed to load due to invalid signature");
+            GFN_SDK_LOG_ERROR("ERROR: GFN library failed to load due to invalid signature");
             return gfnBinarySignatureInvalid;
         }
         else
         {
-            GFN_SDK_LOG("ERROR: GFN library is present but unable to be loaded! LastError=0x%08X", lastError);
+            GFN_SDK_LOG_ERROR("ERROR: GFN library is present but unable to be loaded! LastError=0x%08X", lastError);
             return gfnInitFailure;
         }
     }
@@ -236,7 +411,7 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
     GfnSdkCloudLibrary* pCloudLibrary = (GfnSdkCloudLibrary*)malloc(sizeof(GfnSdkCloudLibrary));
     if (pCloudLibrary == NULL)
     {
-        GFN_SDK_LOG("ERROR: Unable to allocate memory to hold GFN function pointers");
+        GFN_SDK_LOG_ERROR("ERROR: Unable to allocate memory to hold GFN function pointers");
 #ifdef _WIN32
         FreeLibrary(library);
 #endif
@@ -276,7 +451,7 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
 
     if (pCloudLibrary->InitializeRuntimeSdk == NULL && pCloudLibrary->InitializeRuntimeSdkV3 == NULL)
     {
-        GFN_SDK_LOG("Unable to find initialize function pointer");
+        GFN_SDK_LOG_ERROR("Unable to find initialize function pointer");
         gfnFreeCloudLibrary(pCloudLibrary);
         return gfnAPINotFound;
     }
@@ -287,15 +462,11 @@ GfnRuntimeError gfnLoadCloudLibrary(GfnSdkCloudLibrary** ppCloudLibrary)
     return gfnSuccess;
 }
 
-GfnRuntimeError gfnInitializeCloudSdk(void)
+// Initializes a library returned by gfnLoadCloudLibrary, takes ownership of it
+static GfnRuntimeError gfnInitializeLoadedCloudSdk(GfnSdkCloudLibrary* pCloudLibrary, GfnRuntimeError loadStatus)
 {
-    // Already initialized, no need to re-initialize
-    if (g_pCloudLibrary != NULL)
-    {
-        return g_cloudLibraryStatus;
-    }
-
-    g_cloudLibraryStatus = gfnLoadCloudLibrary(&g_pCloudLibrary);
+    g_pCloudLibrary = pCloudLibrary;
+    g_cloudLibraryStatus = loadStatus;
     if (g_cloudLibraryStatus != gfnSuccess)
     {
         return g_cloudLibraryStatus;
@@ -312,7 +483,7 @@ GfnRuntimeError gfnInitializeCloudSdk(void)
     }
     if (GFNSDK_FAILED(g_cloudLibraryStatus))
     {
-        GFN_SDK_LOG("Call to cloud InitializeRuntimeSdk failed: %d", g_cloudLibraryStatus);
+        GFN_SDK_LOG_ERROR("Call to cloud InitializeRuntimeSdk failed: %d", g_cloudLibraryStatus);
         // If init fails, we shouldn't force the host application to hold a loaded reference to the cloud DLL.
         // Instead we will unload to make sure SDK is in a clean state in case the application tried to call
         // the Initialize API again.
@@ -323,11 +494,101 @@ GfnRuntimeError gfnInitializeCloudSdk(void)
     return g_cloudLibraryStatus;
 }
 
-typedef struct _gfnUserContextCallbackWrapper
+GfnRuntimeError gfnInitializeCloudSdk(void)
+{
+    // Already initialized, no need to re-initialize
+    if (g_pCloudLibrary != NULL)
+    {
+        return g_cloudLibraryStatus;
+    }
+
+    GfnSdkCloudLibrary* pCloudLibrary = NULL;
+    GfnRuntimeError loadStatus = gfnLoadCloudLibrary(&pCloudLibrary);
+    return gfnInitializeLoadedCloudSdk(pCloudLibrary, loadStatus);
+}
+
+// Loading the cloud library while the client library is loaded. Both loads are dominated by
+// signature verification, which is file I/O and crypto with nothing shared between the two, so
+// initialization runs the cloud load on a second thread and joins it before either library's
+// initialize entry point is called. The secure loader resolves its crypt entry points lazily,
+// two threads doing so at once store the same values. GFN_SDK_SERIAL_INIT turns this off.
+typedef struct GfnCloudLoad_t
+{
+    HANDLE thread;
+    GfnSdkCloudLibrary* pLibrary;
+    GfnRuntimeError status;
+    bool loaded;
+} GfnCloudLoad;
+
+static DWORD WINAPI gfnCloudLoadThread(LPVOID pParam)
+{
+    GfnCloudLoad* pLoad = (GfnCloudLoad*)pParam;
+    pLoad->status = gfnLoadCloudLibrary(&pLoad->pLibrary);
+    return 0;
+}
+
+// Called under s_initLock, every call must be matched by gfnEndCloudLoad
+static void gfnBeginCloudLoad(GfnCloudLoad* pLoad)
+{
+    memset(pLoad, 0, sizeof(*pLoad));
+    pLoad->status = gfnAPINotInit;
+    if (g_pCloudLibrary != NULL)
+    {
+        // Already initialized, gfnInitializeCloudSdk keeps it
+        pLoad->loaded = true;
+        return;
+    }
+
+#ifndef GFN_SDK_SERIAL_INIT
+    pLoad->thread = CreateThread(NULL, 0, gfnCloudLoadThread, pLoad, 0, NULL);
+    if (pLoad->thread == NULL)
+    {
+        GFN_SDK_LOG("Unable to load the cloud library in parallel, loading it after the client library");
+    }
+#endif
+}
+
+// Waits for the parallel load, or does it now if there was none
+static void gfnEndCloudLoad(GfnCloudLoad* pLoad)
+{
+    if (pLoad->loaded)
+    {
+        return;
+    }
+
+    if (pLoad->thread != NULL)
+    {
+        WaitForSingleObject(pLoad->thread, INFINITE);
+        CloseHandle(pLoad->thread);
+        pLoad->thread = NULL;
+    }
+    else
+    {
+        pLoad->status = gfnLoadCloudLibrary(&pLoad->pLibrary);
+    }
+    pLoad->loaded = true;
+}
+
+// Initializes what gfnEndCloudLoad produced, the counterpart of gfnInitializeCloudSdk
+static GfnRuntimeError gfnInitializeCloudSdkFromLoad(GfnCloudLoad* pLoad)
 {
-    void* fnCallback;
-    void* pOrigUserContext;
-} _gfnUserContextCallbackWrapper;
+    if (g_pCloudLibrary != NULL)
+    {
+        return g_cloudLibraryStatus;
+    }
+    return gfnInitializeLoadedCloudSdk(pLoad->pLibrary, pLoad->status);
+}
+
+// Unloads a library that is no longer going to be initialized
+static void gfnDiscardCloudLoad(GfnCloudLoad* pLoad)
+{
+    gfnEndCloudLoad(pLoad);
+    if (pLoad->pLibrary != NULL && pLoad->pLibrary != g_pCloudLibrary)
+    {
+        gfnFreeCloudLibrary(pLoad->pLibrary);
+    }
+    pLoad->pLibrary = NULL;
+}
 
 enum IsCloud{IsCloud_Unknown,IsCloud_Yes,IsCloud_No};
 static enum IsCloud g_isCloud = IsCloud_Unknown;
@@ -337,148 +598,1444 @@ static enum IsCloud g_isCloud = IsCloud_Unknown;
     {                                   \
         return gfnInvalidParameter;     \
     }
-#define CHECK_CLOUD_ENVIRONMENT_IMPL(bUseCache)                                             \
-    if(g_isCloud == IsCloud_Unknown || !bUseCache)                                          \
-    {                                                                                       \
-        if (!g_pCloudLibrary)                                                               \
-        {                                                                                   \
-            return gfnAPINotInit;                                                        \
-        }                                                                                   \
-        if (!g_pCloudLibrary->IsRunningInCloud)                                             \
-        {                                                                                   \
-            GFN_SDK_LOG("Cannot call cloud function: Wrong environment");                   \
-            return gfnCallWrongEnvironment;                                                 \
-        }                                                                                   \
-        g_isCloud = ((bool)g_pCloudLibrary->IsRunningInCloud()) ? IsCloud_Yes : IsCloud_No; \
-    }                                                                                       \
-    if (g_isCloud == IsCloud_No)                                                            \
-    {                                                                                       \
-        GFN_SDK_LOG("Cannot call cloud function: Wrong environment");                       \
-        return gfnCallWrongEnvironment;                                                     \
-    }
-#define CHECK_CLOUD_ENVIRONMENT() CHECK_CLOUD_ENVIRONMENT_IMPL(true)
+// g_isCloud is settled during initialization, see gfnResolveDispatch
+#define CHECK_CLOUD_ENVIRONMENT()                                           \
+    if (!g_pCloudLibrary)                                                   \
+    {                                                                       \
+        return gfnAPINotInit;                                               \
+    }                                                                       \
+    if (g_isCloud != IsCloud_Yes)                                           \
+    {                                                                       \
+        GFN_SDK_LOG("Cannot call cloud function: Wrong environment");       \
+        return gfnCallWrongEnvironment;                                     \
+    }
 #define CHECK_CLOUD_API_AVAILABLE(Fn)                                       \
     if (g_pCloudLibrary->Fn == NULL)                                        \
     {                                                                       \
         GFN_SDK_LOG("Cannot call cloud function %s: API not found", #Fn);   \
         return gfnAPINotFound;                                              \
     }
+// Slow path for a cloud API that has no dispatch entry, returns the reason it is unavailable
+// Declares pDispatch for the rest of the calling function.
+#define RESOLVE_CLOUD_API(Fn)                                           \
+    const GfnSdkDispatch* pDispatch = gfnLoadDispatch();                \
+    if (pDispatch->Fn == NULL)                                          \
+    {                                                                   \
+        if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized)   \
+        {                                                               \
+            return gfnAPINotInit;                                       \
+        }                                                               \
+        CHECK_CLOUD_ENVIRONMENT();                                      \
+        CHECK_CLOUD_API_AVAILABLE(Fn);                                  \
+        return gfnAPINotInit;                                           \
+    }
 #define DELEGATE_TO_CLOUD_LIBRARY(Fn, ...)                              \
-    CHECK_CLOUD_API_AVAILABLE(Fn);                                      \
-    return gfnTranslateCloudStatus(g_pCloudLibrary->Fn(__VA_ARGS__));
+    RESOLVE_CLOUD_API(Fn);                                              \
+    GFN_BEGIN_LIBRARY_CALL();                                           \
+    GfnRuntimeError libraryStatus = pDispatch->Fn(__VA_ARGS__);         \
+    GFN_END_LIBRARY_CALL(Fn);                                           \
+    return gfnTranslateCloudStatus(libraryStatus);
+#define RESOLVE_CLIENT_API(Fn)                                          \
+    const GfnSdkDispatch* pDispatch = gfnLoadDispatch();                \
+    if (pDispatch->Fn == NULL)                                          \
+    {                                                                   \
+        if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized || \
+            g_pClientLibrary == NULL)                                   \
+        {                                                               \
+            return gfnAPINotInit;                                       \
+        }                                                               \
+        return gfnAPINotFound;                                          \
+    }
+
+// Callback registry. The SDK libraries keep one callback per event, so the wrapper registers a
+// single trampoline per event with them the first time anyone subscribes, and fans the event out to
+// up to GFN_MAX_CALLBACK_SUBSCRIBERS subscribers from there. Subscriber lists are copy-on-write:
+// a writer claims a spare version of the list, fills it from the published one with its change
+// applied and swaps it in with a compare-exchange, starting over if another writer got there
+// first. Readers pin the version they load with a reader count only while copying it out, so no
+// user callback ever runs under a lock, and a replaced version becomes spare again once its
+// count drops to zero. Nothing is allocated, registering again reuses the same storage.
+#define GFN_MAX_CALLBACK_SUBSCRIBERS 8
+#define GFN_SUBSCRIBER_LIST_VERSIONS 4
+#define GFN_CALLBACK_EVENT_BITS 4
+#define GFN_CALLBACK_SERIAL_MASK 0x0FFFFFFF
+#define GFN_LEGACY_CALLBACK_HANDLE 0    // the one callback per event set through GfnRegister*Callback
+
+typedef enum GfnCallbackEvent
+{
+    gfnCallbackEventExit = 0,
+    gfnCallbackEventPause,
+    gfnCallbackEventInstall,
+    gfnCallbackEventSave,
+    gfnCallbackEventSessionInit,
+    gfnCallbackEventClientInfo,
+    gfnCallbackEventStreamStatus,
+    gfnCallbackEventCount
+} GfnCallbackEvent;
+
+typedef enum GfnCallbackHookState
+{
+    gfnCallbackUnhooked = 0,
+    gfnCallbackHooking,
+    gfnCallbackHooked
+} GfnCallbackHookState;
 
-GfnRuntimeError GfnInitializeSdk(GfnDisplayLanguage language)
+typedef struct GfnSubscriber_t
 {
-    // If "client" SDK is already initialized, then we're good to go.
-    // "server" SDK may or may not be initialized depending on mode.
-    GfnRuntimeError clientStatus = gfnSuccess;
+    void* callback;
+    void* pUserContext;
+    GfnCallbackHandle handle;
+} GfnSubscriber;
 
-    if (!g_LoggingInitialized)
+typedef struct GfnSubscriberList_t
+{
+    volatile LONG readers;
+    volatile LONG claimed;          // published, being written or waiting for readers
+    unsigned int count;
+    GfnSubscriber subscribers[GFN_MAX_CALLBACK_SUBSCRIBERS];
+} GfnSubscriberList;
+
+typedef struct GfnCallbackRegistry_t
+{
+    GfnSubscriberList* volatile current;    // NULL until the first subscriber
+    volatile LONG hookState;
+    GfnSubscriberList versions[GFN_SUBSCRIBER_LIST_VERSIONS];
+} GfnCallbackRegistry;
+
+static GfnCallbackRegistry s_callbackRegistry[gfnCallbackEventCount];
+static volatile LONG s_lastCallbackSerial = 0;
+
+static GfnSubscriberList* gfnPinSubscribers(GfnCallbackRegistry* pRegistry)
+{
+    for (;;)
     {
-        GFN_SDK_INIT_LOGGING();
-        g_LoggingInitialized = true;
+        GfnSubscriberList* pList = pRegistry->current;
+        if (pList == NULL)
+        {
+            return NULL;
+        }
+        // Full barrier, a swap that happened before the pin is visible to the check below
+        InterlockedIncrement(&pList->readers);
+        if (pRegistry->current == pList)
+        {
+            return pList;
+        }
+        InterlockedDecrement(&pList->readers);
     }
+}
 
-
-    if (g_gfnSdkModule != NULL)
+static void gfnUnpinSubscribers(GfnSubscriberList* pList)
+{
+    if (pList != NULL)
     {
-        GFN_SDK_LOG("Client library already initialized, no need to initialize again");
+        InterlockedDecrement(&pList->readers);
     }
-    else
+}
+
+static GfnSubscriberList* gfnClaimSubscriberList(GfnCallbackRegistry* pRegistry)
+{
+    for (;;)
     {
-        wchar_t* filename = (wchar_t*)malloc(sizeof(wchar_t) * MAX_PATH);
-        if (!filename)
+        for (int i = 0; i < GFN_SUBSCRIBER_LIST_VERSIONS; ++i)
         {
-            return gfnInternalError;
+            GfnSubscriberList* pList = &pRegistry->versions[i];
+            if (pList->claimed == 0 && InterlockedCompareExchange(&pList->claimed, 1, 0) == 0)
+            {
+                return pList;
+            }
         }
-        DWORD pathSize = GetModuleFileNameW(NULL, filename, MAX_PATH);
-        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+        // Every version is in use by a racing writer, one frees up as soon as its readers are done
+        YieldProcessor();
+    }
+}
+
+// Makes a replaced version spare again once the readers that pinned it before the swap are done
+static void gfnRetireSubscriberList(GfnSubscriberList* pList)
+{
+    while (gfnLoadAcquire(&pList->readers) != 0)
+    {
+        YieldProcessor();
+    }
+    gfnStoreRelease(&pList->claimed, 0);
+}
+
+// Adds pAdd, or removes the subscriber with removeHandle when pAdd is NULL. A legacy subscriber
+// replaces the previous legacy one instead of taking another slot.
+static GfnRuntimeError gfnUpdateSubscribers(GfnCallbackEvent event, const GfnSubscriber* pAdd, GfnCallbackHandle removeHandle)
+{
+    GfnCallbackRegistry* pRegistry = &s_callbackRegistry[event];
+    for (;;)
+    {
+        GfnSubscriberList* pNext = gfnClaimSubscriberList(pRegistry);
+        GfnSubscriberList* pPrevious = gfnPinSubscribers(pRegistry);
+        GfnRuntimeError status = gfnSuccess;
+        bool removed = false;
+
+        pNext->count = 0;
+        for (unsigned int i = 0; pPrevious != NULL && i < pPrevious->count; ++i)
         {
-            free(filename);
-            filename = (wchar_t*)malloc(sizeof(wchar_t) * (pathSize + 1)); //Room for \0
-            if (!filename)
+            const GfnSubscriber* pSubscriber = &pPrevious->subscribers[i];
+            if (pAdd == NULL && pSubscriber->handle == removeHandle)
             {
-                return gfnInternalError;
+                removed = true;
+                continue;
             }
-            pathSize = GetModuleFileNameW(NULL, filename, pathSize + 1);
+            if (pAdd != NULL && pAdd->handle == GFN_LEGACY_CALLBACK_HANDLE && pSubscriber->handle == GFN_LEGACY_CALLBACK_HANDLE)
+            {
+                continue;
+            }
+            pNext->subscribers[pNext->count++] = *pSubscriber;
         }
 
-        wchar_t* lastSepPos = wcsrchr(filename, L'\\');
-        size_t pathLength = lastSepPos - filename + 1;
-        size_t dllPathLength = pathLength + 18; // "GfnRuntimeSdk.dll\0"
-        wchar_t* dllPath = (wchar_t*)malloc(sizeof(wchar_t) * dllPathLength);
-        if (!dllPath)
+        if (pAdd != NULL)
         {
-            free(filename);
-            return gfnInternalError;
+            if (pNext->count == GFN_MAX_CALLBACK_SUBSCRIBERS)
+            {
+                GFN_SDK_LOG_ERROR("No room for another subscriber to callback event %d", event);
+                status = gfnUnableToAllocateMemory;
+            }
+            else
+            {
+                pNext->subscribers[pNext->count++] = *pAdd;
+            }
+        }
+        else if (!removed)
+        {
+            status = gfnInvalidParameter;
         }
-        wcsncpy_s(dllPath, dllPathLength, filename, _TRUNCATE);
-
-        dllPath[pathLength] = L'\0';
-        free(filename);
-        wcsncat_s(dllPath, dllPathLength, L"GfnRuntimeSdk.dll", 17);
 
-        char* sdkLibPath = (char*)malloc(dllPathLength * sizeof(char));
-        if (!sdkLibPath)
+        if (GFNSDK_FAILED(status))
         {
-            free(dllPath);
-            return gfnInternalError;
+            gfnUnpinSubscribers(pPrevious);
+            gfnStoreRelease(&pNext->claimed, 0);
+            return status;
         }
-        int outSize = (int)dllPathLength * sizeof(char);
-        if (!GfnWideToUtf8(dllPath, sdkLibPath, outSize))
+
+        // The pin keeps pPrevious from being recycled, so it can't come back as current meanwhile
+        bool swapped = (InterlockedCompareExchangePointer((PVOID volatile*)&pRegistry->current, pNext, pPrevious) == pPrevious);
+        gfnUnpinSubscribers(pPrevious);
+        if (swapped)
         {
-            GFN_SDK_LOG("Invalid client library path");
-            free(sdkLibPath);
-            free(dllPath);
-            return gfnInternalError;
+            if (pPrevious != NULL)
+            {
+                gfnRetireSubscriberList(pPrevious);
+            }
+            return gfnSuccess;
         }
-        clientStatus = GfnInitializeSdkFromPath(language, sdkLibPath);
-        free(sdkLibPath);
-        free(dllPath);
+        gfnStoreRelease(&pNext->claimed, 0);
     }
+}
 
-    if (GFNSDK_FAILED(clientStatus))
+static void gfnInvokeSubscribers(GfnCallbackEvent event, void* pData)
+{
+    GfnSubscriber subscribers[GFN_MAX_CALLBACK_SUBSCRIBERS];
+    unsigned int count = 0;
+
+    GfnSubscriberList* pList = gfnPinSubscribers(&s_callbackRegistry[event]);
+    if (pList != NULL)
     {
-        GFN_SDK_LOG("Initialization failed: %d", clientStatus);
-        GfnShutdownSdk();
+        count = pList->count;
+        memcpy(subscribers, pList->subscribers, count * sizeof(GfnSubscriber));
+        gfnUnpinSubscribers(pList);
     }
 
-    return clientStatus;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        void* pUserContext = subscribers[i].pUserContext;
+        switch (event)
+        {
+        case gfnCallbackEventExit:
+            ((ExitCallbackSig)subscribers[i].callback)(pUserContext);
+            break;
+        case gfnCallbackEventPause:
+            ((PauseCallbackSig)subscribers[i].callback)(pUserContext);
+            break;
+        case gfnCallbackEventInstall:
+            ((InstallCallbackSig)subscribers[i].callback)((const TitleInstallationInformation*)pData, pUserContext);
+            break;
+        case gfnCallbackEventSave:
+            ((SaveCallbackSig)subscribers[i].callback)(pUserContext);
+            break;
+        case gfnCallbackEventSessionInit:
+            ((SessionInitCallbackSig)subscribers[i].callback)((const char*)pData, pUserContext);
+            break;
+        case gfnCallbackEventClientInfo:
+            ((ClientInfoCallbackSig)subscribers[i].callback)((GfnClientInfoUpdateData*)pData, pUserContext);
+            break;
+        case gfnCallbackEventStreamStatus:
+            ((StreamStatusCallbackSig)subscribers[i].callback)((GfnStreamStatus)(ULONG_PTR)pData, pUserContext);
+            break;
+        default:
+            break;
+        }
+    }
 }
 
-GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char* sdkLibraryPath)
+static void gfnDeliverEvent(GfnCallbackEvent event, void* pData);
+static void GFN_CALLBACK _gfnClientInfoSnapshotCallback(int status, void* updateData, void* pContext);
+static void GFN_CALLBACK _gfnSessionInitSnapshotCallback(int status, void* pData, void* pContext);
+
+// Registered with the cloud library for every event but client info, the context carries the event
+static void GFN_CALLBACK _gfnCallbackTrampoline(int status, void* pData, void* pContext)
 {
-    // If "client" library is already initialized, then we're good to go.
-    if (g_gfnSdkModule != NULL)
+    (void)status;
+    gfnDeliverEvent((GfnCallbackEvent)(ULONG_PTR)pContext, pData);
+}
+
+static GfnApplicationCallbackResult GFN_CALLBACK _gfnStreamStatusTrampoline(GfnStreamStatus status, void* pContext)
+{
+    (void)pContext;
+    gfnDeliverEvent(gfnCallbackEventStreamStatus, (void*)(ULONG_PTR)status);
+    return crCallbackSuccess;
+}
+
+static GfnRuntimeError gfnRegisterTrampoline(const GfnSdkDispatch* pDispatch, GfnCallbackEvent event)
+{
+    void* pContext = (void*)(ULONG_PTR)event;
+    switch (event)
+    {
+    case gfnCallbackEventExit:
+        return gfnTranslateCloudStatus(pDispatch->RegisterExitCallback(&_gfnCallbackTrampoline, pContext));
+    case gfnCallbackEventPause:
+        return gfnTranslateCloudStatus(pDispatch->RegisterPauseCallback(&_gfnCallbackTrampoline, pContext));
+    case gfnCallbackEventInstall:
+        return gfnTranslateCloudStatus(pDispatch->RegisterInstallCallback(&_gfnCallbackTrampoline, pContext));
+    case gfnCallbackEventSave:
+        return gfnTranslateCloudStatus(pDispatch->RegisterSaveCallback(&_gfnCallbackTrampoline, pContext));
+    case gfnCallbackEventSessionInit:
+        // Normally already hooked by the client info snapshot during initialization
+        return gfnTranslateCloudStatus(pDispatch->RegisterSessionInitCallback(&_gfnSessionInitSnapshotCallback, pContext));
+    case gfnCallbackEventClientInfo:
+        // Normally already hooked by the client info snapshot during initialization
+        return gfnTranslateCloudStatus(pDispatch->RegisterClientInfoCallback(&_gfnClientInfoSnapshotCallback, pContext));
+    case gfnCallbackEventStreamStatus:
+        return pDispatch->RegisterStreamStatusCallback(&_gfnStreamStatusTrampoline, pContext);
+    default:
+        return gfnInvalidParameter;
+    }
+}
+
+// Registers the trampoline for the event with its library unless that already happened.
+// Threads subscribing at the same time wait for the registration in flight instead of repeating it.
+static GfnRuntimeError gfnHookCallbackEvent(const GfnSdkDispatch* pDispatch, GfnCallbackEvent event)
+{
+    GfnCallbackRegistry* pRegistry = &s_callbackRegistry[event];
+    for (;;)
     {
-        GFN_SDK_LOG("Client library already initialized, no need to initialize again");
-        return gfnSuccess;
+        LONG state = gfnLoadAcquire(&pRegistry->hookState);
+        if (state == gfnCallbackHooked)
+        {
+            return gfnSuccess;
+        }
+        if (state == gfnCallbackUnhooked &&
+            InterlockedCompareExchange(&pRegistry->hookState, gfnCallbackHooking, gfnCallbackUnhooked) == gfnCallbackUnhooked)
+        {
+            GfnRuntimeError status = gfnRegisterTrampoline(pDispatch, event);
+            gfnStoreRelease(&pRegistry->hookState, GFNSDK_SUCCEEDED(status) ? gfnCallbackHooked : gfnCallbackUnhooked);
+            return status;
+        }
+        YieldProcessor();
     }
+}
 
-    GfnRuntimeError clientStatus = gfnSuccess;
-    if (!g_LoggingInitialized)
+// The subscriber goes in before the hook, so an event fired right after registration reaches it.
+// pHandle is NULL for the legacy registration functions.
+static GfnRuntimeError gfnSubscribeCallback(const GfnSdkDispatch* pDispatch, GfnCallbackEvent event,
+    void* callback, void* pUserContext, GfnCallbackHandle* pHandle)
+{
+    GfnSubscriber subscriber;
+    subscriber.callback = callback;
+    subscriber.pUserContext = pUserContext;
+    subscriber.handle = GFN_LEGACY_CALLBACK_HANDLE;
+    if (pHandle != NULL)
+    {
+        LONG serial;
+        do
+        {
+            serial = InterlockedIncrement(&s_lastCallbackSerial) & GFN_CALLBACK_SERIAL_MASK;
+        } while (serial == 0);
+        subscriber.handle = ((GfnCallbackHandle)serial << GFN_CALLBACK_EVENT_BITS) | (GfnCallbackHandle)event;
+    }
+
+    GfnRuntimeError status = gfnUpdateSubscribers(event, &subscriber, GFN_LEGACY_CALLBACK_HANDLE);
+    if (GFNSDK_FAILED(status))
     {
-        GFN_SDK_INIT_LOGGING();
-        g_LoggingInitialized = true;
+        return status;
     }
 
-    if (sdkLibraryPath == NULL)
+    status = gfnHookCallbackEvent(pDispatch, event);
+    if (GFNSDK_FAILED(status))
     {
-        GFN_SDK_LOG("Invalid SDK library path");
-        return gfnInvalidParameter;
+        gfnUpdateSubscribers(event, NULL, subscriber.handle);
+        return status;
     }
 
-    size_t libPathSize = strlen(sdkLibraryPath) + 1;
-    wchar_t* wSdkLibraryPath = (wchar_t*)malloc(libPathSize * sizeof(wchar_t));
-    if (!wSdkLibraryPath)
+    if (pHandle != NULL)
     {
-        GFN_SDK_LOG("Failed to allocate for SDK library path");
-        return gfnUnableToAllocateMemory;
+        *pHandle = subscriber.handle;
+    }
+    return gfnSuccess;
+}
+
+// Called under s_initLock once neither library can deliver events anymore.
+// Subscriptions and their handles don't outlive the libraries they were hooked into.
+static void gfnResetCallbackRegistry(void)
+{
+    memset(&s_callbackRegistry, 0, sizeof(s_callbackRegistry));
+}
+
+// Queued callback delivery. By default subscribers run on the SDK thread that raised the event,
+// see GfnSetCallbackDelivery for the alternative. Queued events go into a bounded multi-producer
+// queue (D. Vyukov, as used by the logger) with a copy of their data, and come out on whichever
+// thread dispatches: the application's through GfnDispatchCallbacks, or a wrapper thread. Client
+// info and stream status updates only describe the latest state, so while one is still waiting
+// a newer one replaces it in its mailbox instead of taking another queue slot. A full queue, or a
+// copy that can't be allocated, delivers on the SDK thread rather than losing the event.
+#define GFN_EVENT_QUEUE_SIZE 256        // must be a power of two
+
+typedef struct GfnEventPayload_t
+{
+    void* pValue;                               // data that fits in a pointer, e.g. the stream status
+    char* pStrings;                             // owned copy of the strings the data points to
+    TitleInstallationInformation installation;
+    GfnClientInfoUpdateData clientInfo;
+} GfnEventPayload;
+
+typedef struct GfnQueuedEvent_t
+{
+    volatile LONG sequence;
+    GfnCallbackEvent event;
+    bool inMailbox;             // the payload waits in s_eventMailboxes[event]
+    LONGLONG enqueuedAt;
+    GfnEventPayload payload;
+} GfnQueuedEvent;
+
+typedef struct GfnEventMailbox_t
+{
+    SRWLOCK lock;
+    bool pending;
+    LONGLONG enqueuedAt;        // of the oldest update merged into the payload
+    GfnEventPayload payload;
+} GfnEventMailbox;
+
+typedef struct GfnDeliveryCounters_t
+{
+    volatile LONGLONG queued;
+    volatile LONGLONG delivered;
+    volatile LONGLONG coalesced;
+    volatile LONGLONG overflowed;
+    volatile LONGLONG lastLatencyUs;
+    volatile LONGLONG maxLatencyUs;
+    volatile LONGLONG totalLatencyUs;
+} GfnDeliveryCounters;
+
+static GfnQueuedEvent s_eventQueue[GFN_EVENT_QUEUE_SIZE];
+static volatile LONG s_eventEnqueuePos = 0;
+static LONG s_eventDequeuePos = 0;              // owned by whoever holds s_eventDispatching
+static volatile LONG s_eventDispatching = 0;
+static volatile LONG s_eventQueueReady = 0;     // written under s_initLock
+static GfnEventMailbox s_eventMailboxes[gfnCallbackEventCount];    // zeroed locks are initialized SRW locks
+static GfnDeliveryCounters s_deliveryCounters;
+static LONGLONG s_performanceFrequency = 0;     // written under s_initLock during the first initialization
+
+static volatile LONG s_callbackDelivery = gfnCallbackDeliveryImmediate;
+static volatile LONG s_deliveryStopping = 0;
+static HANDLE s_deliveryWake = NULL;            // written under s_initLock, lives until shutdown
+static HANDLE s_deliveryThread = NULL;          // written under s_initLock
+static DWORD s_deliveryThreadId = 0;
+
+static LONGLONG gfnPerformanceCounter(void)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static LONGLONG gfnReadCounter(volatile LONGLONG* pCounter)
+{
+    // Also atomic on 32-bit targets
+    return InterlockedCompareExchange64(pCounter, 0, 0);
+}
+
+static bool gfnIsCoalescedEvent(GfnCallbackEvent event)
+{
+    return event == gfnCallbackEventClientInfo || event == gfnCallbackEventStreamStatus;
+}
+
+// Copies count strings into a single allocation, NULL entries stay NULL
+static char* gfnCopyStrings(const char* const* values, const char** copies, int count)
+{
+    size_t total = 1;
+    for (int i = 0; i < count; ++i)
+    {
+        total += (values[i] != NULL) ? strlen(values[i]) + 1 : 0;
+    }
+
+    char* block = (char*)malloc(total);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    char* cursor = block;
+    for (int i = 0; i < count; ++i)
+    {
+        copies[i] = NULL;
+        if (values[i] != NULL)
+        {
+            size_t length = strlen(values[i]) + 1;
+            memcpy(cursor, values[i], length);
+            copies[i] = cursor;
+            cursor += length;
+        }
+    }
+    return block;
+}
+
+// Takes a copy of everything pData refers to, the library only keeps it alive during the call
+static bool gfnCapturePayload(GfnCallbackEvent event, void* pData, GfnEventPayload* pPayload)
+{
+    memset(pPayload, 0, sizeof(*pPayload));
+    switch (event)
+    {
+    case gfnCallbackEventInstall:
+        if (pData != NULL)
+        {
+            const TitleInstallationInformation* pInfo = (const TitleInstallationInformation*)pData;
+            const char* values[3] = { pInfo->pchPlatformAppId, pInfo->pchBuildPath, pInfo->pchMetadataPath };
+            const char* copies[3];
+            pPayload->pStrings = gfnCopyStrings(values, copies, 3);
+            if (pPayload->pStrings == NULL)
+            {
+                return false;
+            }
+            pPayload->installation.pchPlatformAppId = copies[0];
+            pPayload->installation.pchBuildPath = copies[1];
+            pPayload->installation.pchMetadataPath = copies[2];
+            pPayload->pValue = pPayload;    // marks that there is data, see gfnPayloadData
+        }
+        return true;
+    case gfnCallbackEventSessionInit:
+        if (pData != NULL)
+        {
+            const char* value = (const char*)pData;
+            const char* copy;
+            pPayload->pStrings = gfnCopyStrings(&value, &copy, 1);
+            return pPayload->pStrings != NULL;
+        }
+        return true;
+    case gfnCallbackEventClientInfo:
+        if (pData != NULL)
+        {
+            pPayload->clientInfo = *(const GfnClientInfoUpdateData*)pData;
+            pPayload->pValue = pPayload;
+        }
+        return true;
+    default:
+        pPayload->pValue = pData;
+        return true;
+    }
+}
+
+static void* gfnPayloadData(GfnCallbackEvent event, GfnEventPayload* pPayload)
+{
+    switch (event)
+    {
+    case gfnCallbackEventInstall:
+        return pPayload->pValue != NULL ? &pPayload->installation : NULL;
+    case gfnCallbackEventSessionInit:
+        return pPayload->pStrings;
+    case gfnCallbackEventClientInfo:
+        return pPayload->pValue != NULL ? &pPayload->clientInfo : NULL;
+    default:
+        return pPayload->pValue;
+    }
+}
+
+// Whether pNext makes the waiting pPending pointless to deliver
+static bool gfnSupersedes(GfnCallbackEvent event, const GfnEventPayload* pPending, const GfnEventPayload* pNext)
+{
+    if (event == gfnCallbackEventClientInfo)
+    {
+        // Only an update of the same kind replaces what it carries
+        return pPending->pValue != NULL && pNext->pValue != NULL &&
+            pPending->clientInfo.updateType == pNext->clientInfo.updateType;
+    }
+    return true;
+}
+
+static bool gfnEnqueueEvent(GfnCallbackEvent event, bool inMailbox, const GfnEventPayload* pPayload, LONGLONG enqueuedAt)
+{
+    GfnQueuedEvent* pSlot = NULL;
+    LONG pos = gfnLoadAcquire(&s_eventEnqueuePos);
+    for (;;)
+    {
+        GfnQueuedEvent* pCandidate = &s_eventQueue[pos & (GFN_EVENT_QUEUE_SIZE - 1)];
+        LONG diff = gfnLoadAcquire(&pCandidate->sequence) - pos;
+        if (diff == 0)
+        {
+            LONG previous = InterlockedCompareExchange(&s_eventEnqueuePos, pos + 1, pos);
+            if (previous == pos)
+            {
+                pSlot = pCandidate;
+                break;
+            }
+            pos = previous;
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = gfnLoadAcquire(&s_eventEnqueuePos);
+        }
+    }
+
+    pSlot->event = event;
+    pSlot->inMailbox = inMailbox;
+    pSlot->enqueuedAt = enqueuedAt;
+    if (pPayload != NULL)
+    {
+        pSlot->payload = *pPayload;
+    }
+    gfnStoreRelease(&pSlot->sequence, pos + 1);
+    InterlockedIncrement64(&s_deliveryCounters.queued);
+    return true;
+}
+
+// Returns false when the event has to be delivered on the calling thread instead
+static bool gfnQueueEvent(GfnCallbackEvent event, void* pData)
+{
+    GfnEventPayload payload;
+    if (!gfnCapturePayload(event, pData, &payload))
+    {
+        return false;
+    }
+
+    LONGLONG now = gfnPerformanceCounter();
+    bool queued;
+    if (gfnIsCoalescedEvent(event))
+    {
+        GfnEventMailbox* pMailbox = &s_eventMailboxes[event];
+        AcquireSRWLockExclusive(&pMailbox->lock);
+        if (pMailbox->pending && gfnSupersedes(event, &pMailbox->payload, &payload))
+        {
+            pMailbox->payload = payload;
+            ReleaseSRWLockExclusive(&pMailbox->lock);
+            InterlockedIncrement64(&s_deliveryCounters.coalesced);
+            return true;
+        }
+        if (pMailbox->pending)
+        {
+            // Still waiting and not superseded, this one travels on its own
+            ReleaseSRWLockExclusive(&pMailbox->lock);
+            queued = gfnEnqueueEvent(event, false, &payload, now);
+        }
+        else
+        {
+            // Enqueued under the lock so the slot and the mailbox go pending together
+            queued = gfnEnqueueEvent(event, true, NULL, now);
+            if (queued)
+            {
+                pMailbox->pending = true;
+                pMailbox->enqueuedAt = now;
+                pMailbox->payload = payload;
+            }
+            ReleaseSRWLockExclusive(&pMailbox->lock);
+        }
+    }
+    else
+    {
+        queued = gfnEnqueueEvent(event, false, &payload, now);
+    }
+
+    if (!queued)
+    {
+        free(payload.pStrings);
+        InterlockedIncrement64(&s_deliveryCounters.overflowed);
+    }
+    return queued;
+}
+
+static void gfnRecordDeliveryLatency(LONGLONG enqueuedAt)
+{
+    LONGLONG latencyUs = (gfnPerformanceCounter() - enqueuedAt) * 1000000 / s_performanceFrequency;
+
+    // Only the dispatching thread writes these
+    InterlockedExchange64(&s_deliveryCounters.lastLatencyUs, latencyUs);
+    if (latencyUs > s_deliveryCounters.maxLatencyUs)
+    {
+        InterlockedExchange64(&s_deliveryCounters.maxLatencyUs, latencyUs);
+    }
+    InterlockedExchangeAdd64(&s_deliveryCounters.totalLatencyUs, latencyUs);
+    InterlockedIncrement64(&s_deliveryCounters.delivered);
+}
+
+static bool gfnIsEventReady(LONG pos)
+{
+    return gfnLoadAcquire(&s_eventQueue[pos & (GFN_EVENT_QUEUE_SIZE - 1)].sequence) == pos + 1;
+}
+
+// Called by the thread holding s_eventDispatching
+static unsigned int gfnDispatchOwnedEvents(unsigned int limit, bool invoke)
+{
+    unsigned int dispatched = 0;
+    while (dispatched < limit)
+    {
+        GfnQueuedEvent* pSlot = &s_eventQueue[s_eventDequeuePos & (GFN_EVENT_QUEUE_SIZE - 1)];
+        if (gfnLoadAcquire(&pSlot->sequence) != s_eventDequeuePos + 1)
+        {
+            break;
+        }
+
+        GfnCallbackEvent event = pSlot->event;
+        bool inMailbox = pSlot->inMailbox;
+        LONGLONG enqueuedAt = pSlot->enqueuedAt;
+        GfnEventPayload payload = pSlot->payload;
+        gfnStoreRelease(&pSlot->sequence, s_eventDequeuePos + GFN_EVENT_QUEUE_SIZE);
+        ++s_eventDequeuePos;
+
+        if (inMailbox)
+        {
+            GfnEventMailbox* pMailbox = &s_eventMailboxes[event];
+            AcquireSRWLockExclusive(&pMailbox->lock);
+            payload = pMailbox->payload;
+            enqueuedAt = pMailbox->enqueuedAt;
+            pMailbox->pending = false;
+            ReleaseSRWLockExclusive(&pMailbox->lock);
+        }
+
+        if (invoke)
+        {
+            gfnRecordDeliveryLatency(enqueuedAt);
+            gfnInvokeSubscribers(event, gfnPayloadData(event, &payload));
+        }
+        free(payload.pStrings);
+        ++dispatched;
+    }
+    return dispatched;
+}
+
+// Delivers up to maxEvents queued events, all that are queued right now when 0. A thread that
+// finds another one dispatching, or calls in from a callback being dispatched, gets 0 back.
+static unsigned int gfnDispatchQueuedEvents(unsigned int maxEvents, bool invoke)
+{
+    unsigned int limit = (maxEvents == 0) ? GFN_EVENT_QUEUE_SIZE : maxEvents;
+    unsigned int dispatched = 0;
+    while (dispatched < limit && InterlockedCompareExchange(&s_eventDispatching, 1, 0) == 0)
+    {
+        dispatched += gfnDispatchOwnedEvents(limit - dispatched, invoke);
+
+        // A full barrier, so an event published after the last check is either seen below or its
+        // producer's own attempt to dispatch finds the flag cleared
+        InterlockedExchange(&s_eventDispatching, 0);
+        if (!gfnIsEventReady(s_eventDequeuePos))
+        {
+            break;
+        }
+    }
+    return dispatched;
+}
+
+static void gfnDeliverEvent(GfnCallbackEvent event, void* pData)
+{
+    LONG delivery = gfnLoadAcquire(&s_callbackDelivery);
+    if (delivery != gfnCallbackDeliveryImmediate && gfnQueueEvent(event, pData))
+    {
+        // Orders the publication of the event before reading the mode again, GfnSetCallbackDelivery
+        // changes the mode before draining
+        MemoryBarrier();
+        delivery = gfnLoadAcquire(&s_callbackDelivery);
+        if (delivery == gfnCallbackDeliveryWrapperThread)
+        {
+            SetEvent(s_deliveryWake);
+        }
+        else if (delivery == gfnCallbackDeliveryImmediate)
+        {
+            // Delivery changed while this was queued and the change may have drained the queue
+            // already, nobody else would pick it up
+            gfnDispatchQueuedEvents(0, true);
+        }
+        return;
+    }
+    gfnInvokeSubscribers(event, pData);
+}
+
+static DWORD WINAPI gfnCallbackDeliveryThread(LPVOID unused)
+{
+    UNREFERENCED_PARAMETER(unused);
+    while (!gfnLoadAcquire(&s_deliveryStopping))
+    {
+        WaitForSingleObject(s_deliveryWake, INFINITE);
+        while (gfnDispatchQueuedEvents(0, true) != 0)
+        {
+        }
+    }
+    gfnDispatchQueuedEvents(0, true);
+    return 0;
+}
+
+// Called under s_initLock. The thread delivers what is still queued before it exits.
+static void gfnStopDeliveryThread(void)
+{
+    if (s_deliveryThread == NULL)
+    {
+        return;
+    }
+
+    gfnStoreRelease(&s_deliveryStopping, 1);
+    SetEvent(s_deliveryWake);
+    WaitForSingleObject(s_deliveryThread, INFINITE);
+    CloseHandle(s_deliveryThread);
+    s_deliveryThread = NULL;
+    s_deliveryThreadId = 0;
+}
+
+// Called under s_initLock. SDK threads may still be signalling the wake event of an earlier
+// thread, so the event is kept and only closed by gfnResetCallbackDelivery.
+static GfnRuntimeError gfnStartDeliveryThread(void)
+{
+    s_deliveryStopping = 0;
+    if (s_deliveryWake == NULL)
+    {
+        s_deliveryWake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    }
+    s_deliveryThread = s_deliveryWake ? CreateThread(NULL, 0, gfnCallbackDeliveryThread, NULL, 0, &s_deliveryThreadId) : NULL;
+    if (s_deliveryThread == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Unable to start the callback delivery thread. LastError=0x%08X", GetLastError());
+        return gfnInternalError;
+    }
+    return gfnSuccess;
+}
+
+// Called under s_initLock once neither library can raise events anymore. What is still queued
+// is dropped, delivery goes back to immediate for the next initialization.
+static void gfnResetCallbackDelivery(void)
+{
+    gfnStoreRelease(&s_callbackDelivery, gfnCallbackDeliveryImmediate);
+    gfnStopDeliveryThread();
+    if (s_eventQueueReady)
+    {
+        while (gfnDispatchQueuedEvents(0, false) != 0)
+        {
+        }
+    }
+    if (s_deliveryWake != NULL)
+    {
+        CloseHandle(s_deliveryWake);
+        s_deliveryWake = NULL;
+    }
+}
+
+// Per-API statistics. Each tracked API counts its calls on entry, and the calls it passes on to an
+// SDK library are timed into a histogram of power-of-two microsecond buckets. Counters are sharded
+// by thread so threads calling the same API mostly update different cache lines, and
+// GfnGetWrapperStats adds the shards up. Building with GFN_SDK_WRAPPER_NO_STATS compiles it out.
+#ifndef GFN_SDK_WRAPPER_NO_STATS
+#define GFN_STATS_SHARDS 8      // must be a power of two
+
+typedef struct GfnApiCounters_t
+{
+    volatile LONGLONG calls;
+    volatile LONGLONG libraryCalls;
+    volatile LONGLONG totalLatencyUs;
+    volatile LONGLONG maxLatencyUs;
+    volatile LONGLONG histogram[GFN_WRAPPER_LATENCY_BUCKETS];
+} GfnApiCounters;
+
+typedef struct __declspec(align(64)) GfnStatsShard_t
+{
+    GfnApiCounters apis[gfnWrapperApiCount];
+} GfnStatsShard;
+
+static GfnStatsShard s_statsShards[GFN_STATS_SHARDS];
+
+static GfnApiCounters* gfnApiCounters(GfnWrapperApi api)
+{
+    // Thread ids are multiples of four
+    return &s_statsShards[(GetCurrentThreadId() >> 2) & (GFN_STATS_SHARDS - 1)].apis[api];
+}
+
+static void gfnCountCall(GfnWrapperApi api)
+{
+    InterlockedIncrement64(&gfnApiCounters(api)->calls);
+}
+
+static void gfnRecordLibraryCall(GfnWrapperApi api, LONGLONG start)
+{
+    LONGLONG latencyUs = (gfnPerformanceCounter() - start) * 1000000 / s_performanceFrequency;
+    int bucket = 0;
+    while (bucket < GFN_WRAPPER_LATENCY_BUCKETS - 1 && latencyUs >= (1LL << bucket))
+    {
+        ++bucket;
+    }
+
+    GfnApiCounters* pCounters = gfnApiCounters(api);
+    InterlockedIncrement64(&pCounters->libraryCalls);
+    InterlockedExchangeAdd64(&pCounters->totalLatencyUs, latencyUs);
+    InterlockedIncrement64(&pCounters->histogram[bucket]);
+    LONGLONG max = pCounters->maxLatencyUs;
+    while (latencyUs > max)
+    {
+        LONGLONG seen = InterlockedCompareExchange64(&pCounters->maxLatencyUs, latencyUs, max);
+        if (seen == max)
+        {
+            break;
+        }
+        max = seen;
+    }
+}
+
+static void gfnSumWrapperStats(GfnWrapperStats* pStats)
+{
+    memset(pStats, 0, sizeof(*pStats));
+    for (int shard = 0; shard < GFN_STATS_SHARDS; ++shard)
+    {
+        for (int api = 0; api < gfnWrapperApiCount; ++api)
+        {
+            GfnApiCounters* pCounters = &s_statsShards[shard].apis[api];
+            GfnWrapperApiStats* pApi = &pStats->apis[api];
+            pApi->calls += (unsigned long long)gfnReadCounter(&pCounters->calls);
+            pApi->libraryCalls += (unsigned long long)gfnReadCounter(&pCounters->libraryCalls);
+            pApi->totalLatencyUs += (unsigned long long)gfnReadCounter(&pCounters->totalLatencyUs);
+            unsigned long long max = (unsigned long long)gfnReadCounter(&pCounters->maxLatencyUs);
+            pApi->maxLatencyUs = max > pApi->maxLatencyUs ? max : pApi->maxLatencyUs;
+            for (int bucket = 0; bucket < GFN_WRAPPER_LATENCY_BUCKETS; ++bucket)
+            {
+                pApi->latencyHistogram[bucket] += (unsigned long long)gfnReadCounter(&pCounters->histogram[bucket]);
+            }
+        }
+    }
+}
+
+#ifdef GFN_SDK_WRAPPER_LOG
+static const char* const s_wrapperApiNames[gfnWrapperApiCount] =
+{
+    "GfnGetClientIpV4",
+    "GfnGetClientLanguageCode",
+    "GfnGetClientCountryCode",
+    "GfnGetClientInfo",
+    "GfnGetCustomData",
+    "GfnGetAuthData",
+    "GfnIsTitleAvailable",
+    "GfnGetTitlesAvailable",
+    "GfnSetupTitle",
+    "GfnAppReady",
+    "GfnSetActionZone",
+    "GfnFree",
+    "GfnStartStream",
+    "GfnStartStreamAsync",
+    "GfnStopStream",
+    "GfnStopStreamAsync",
+    "GfnTitleExited"
+};
+
+// Called from the log writer thread every GFN_SDK_WRAPPER_STATS_INTERVAL seconds
+static void gfnLogWrapperStats(void)
+{
+    GfnWrapperStats stats;
+    gfnSumWrapperStats(&stats);
+    for (int api = 0; api < gfnWrapperApiCount; ++api)
+    {
+        const GfnWrapperApiStats* pApi = &stats.apis[api];
+        if (pApi->calls != 0)
+        {
+            GFN_SDK_LOG("%s: calls=%llu libraryCalls=%llu avgUs=%llu maxUs=%llu", s_wrapperApiNames[api],
+                pApi->calls, pApi->libraryCalls, pApi->libraryCalls ? pApi->totalLatencyUs / pApi->libraryCalls : 0ULL, pApi->maxLatencyUs);
+        }
+    }
+}
+#endif
+
+#define GFN_COUNT_CALL(Fn) gfnCountCall(gfnWrapperApi##Fn)
+#define GFN_BEGIN_LIBRARY_CALL() LONGLONG libraryCallStart = gfnPerformanceCounter()
+#define GFN_END_LIBRARY_CALL(Fn) gfnRecordLibraryCall(gfnWrapperApi##Fn, libraryCallStart)
+#else
+#define GFN_COUNT_CALL(Fn)
+#define GFN_BEGIN_LIBRARY_CALL()
+#define GFN_END_LIBRARY_CALL(Fn)
+#endif
+
+// Client info snapshot. Client info only changes when the cloud library reports it through the
+// client info callback, so the wrapper registers its own callback at initialization, keeps a copy
+// and answers GfnGetClientInfo, GfnGetClientIpV4, GfnGetClientLanguageCode and
+// GfnGetClientCountryCode from it without calling into the library. The copy is published with a
+// seqlock: writers (init and the callback, serialized by s_clientInfoLock) make the sequence odd,
+// update and make it even again; readers copy and retry if the sequence moved. Fields the library
+// failed to provide are left out, those calls still go to the library and return its error.
+// The callback only reports OS changes, the other fields change when a client connects to a title
+// that was launched ahead of the session. Session init therefore clears the copy, and the next
+// reader asks the library again.
+#define GFN_CLIENT_STRING_POOL_SIZE 16
+#define GFN_CLIENT_STRING_SIZE IP_V6_SIZE
+#define GFN_CLIENT_INFO_READ_ATTEMPTS 64
+
+typedef struct GfnClientInfoSnapshot_t
+{
+    bool hasInfo;
+    bool hasIp;
+    bool hasLanguageCode;
+    bool hasCountryCode;
+    GfnClientInfo info;
+    const char* ip;                 // in s_clientStringPool
+    const char* languageCode;       // in s_clientStringPool
+    char countryCode[CC_SIZE];
+} GfnClientInfoSnapshot;
+
+static GfnClientInfoSnapshot s_clientInfoSnapshot;
+static volatile LONG s_clientInfoSequence = 0;
+static SRWLOCK s_clientInfoLock = SRWLOCK_INIT;
+static LONG s_clientInfoUpdates = 0;                  // guarded by s_clientInfoLock
+static LONG s_clientInfoSessions = 0;                 // guarded by s_clientInfoLock
+static volatile LONG s_clientInfoStale = 0;
+static volatile LONG s_clientInfoSubscribed = 0;      // written under s_initLock
+
+// Strings returned by GfnGetClientIpV4 and GfnGetClientLanguageCode. Slots are never reused, so a
+// returned pointer stays valid for the life of the process and GfnFree only has to recognize it.
+static char s_clientStringPool[GFN_CLIENT_STRING_POOL_SIZE][GFN_CLIENT_STRING_SIZE];
+static unsigned int s_clientStringPoolUsed = 0;      // guarded by s_clientInfoLock
+
+static bool gfnIsClientString(const char* value)
+{
+    const char* pool = &s_clientStringPool[0][0];
+    return value >= pool && value < pool + sizeof(s_clientStringPool);
+}
+
+// Returns NULL when the value doesn't fit or the pool is exhausted, the caller then leaves the field out
+static const char* gfnInternClientString(const char* value)
+{
+    if (value == NULL || strlen(value) >= GFN_CLIENT_STRING_SIZE)
+    {
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < s_clientStringPoolUsed; ++i)
+    {
+        if (strcmp(s_clientStringPool[i], value) == 0)
+        {
+            return s_clientStringPool[i];
+        }
+    }
+
+    if (s_clientStringPoolUsed == GFN_CLIENT_STRING_POOL_SIZE)
+    {
+        return NULL;
+    }
+
+    strcpy_s(s_clientStringPool[s_clientStringPoolUsed], GFN_CLIENT_STRING_SIZE, value);
+    return s_clientStringPool[s_clientStringPoolUsed++];
+}
+
+// Called with s_clientInfoLock held exclusively
+static void gfnPublishClientInfo(const GfnClientInfoSnapshot* pSnapshot)
+{
+    InterlockedIncrement(&s_clientInfoSequence);
+    memcpy(&s_clientInfoSnapshot, pSnapshot, sizeof(s_clientInfoSnapshot));
+    InterlockedIncrement(&s_clientInfoSequence);
+}
+
+static void gfnRefreshClientInfo(void);
+
+// Returns false when no consistent copy could be taken, the caller then asks the library
+static bool gfnReadClientInfo(GfnClientInfoSnapshot* pSnapshot)
+{
+    if (gfnLoadAcquire(&s_clientInfoStale) && gfnLoadAcquire(&s_clientInfoSubscribed) &&
+        InterlockedCompareExchange(&s_clientInfoStale, 0, 1) == 1)
+    {
+        gfnRefreshClientInfo();
+    }
+
+    for (int attempt = 0; attempt < GFN_CLIENT_INFO_READ_ATTEMPTS; ++attempt)
+    {
+        LONG sequence = gfnLoadAcquire(&s_clientInfoSequence);
+        if ((sequence & 1) == 0)
+        {
+            memcpy(pSnapshot, &s_clientInfoSnapshot, sizeof(*pSnapshot));
+            gfnReadFence();
+            if (s_clientInfoSequence == sequence)
+            {
+                return true;
+            }
+        }
+        YieldProcessor();
+    }
+    return false;
+}
+
+// Copies a string returned by the cloud library and releases the original.
+// Returns false when the call failed or the value doesn't fit.
+static bool gfnCopyCloudString(gfnGetClientIpFn getString, char* buffer)
+{
+    const char* value = NULL;
+    if (getString == NULL || g_pCloudLibrary->Free == NULL ||
+        GFNSDK_FAILED(gfnTranslateCloudStatus(getString(&value))) || value == NULL)
+    {
+        return false;
+    }
+
+    bool copied = (strlen(value) < GFN_CLIENT_STRING_SIZE && strcpy_s(buffer, GFN_CLIENT_STRING_SIZE, value) == 0);
+    g_pCloudLibrary->Free(&value);
+    return copied;
+}
+
+// Asks the cloud library for everything once. Runs without s_clientInfoLock held so the library
+// is free to deliver callbacks meanwhile, an update that lands in between wins over what was read,
+// and a session that starts in between makes what was read stale.
+static void gfnRefreshClientInfo(void)
+{
+    GfnClientInfoSnapshot snapshot;
+    char ip[GFN_CLIENT_STRING_SIZE];
+    char languageCode[GFN_CLIENT_STRING_SIZE];
+
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    AcquireSRWLockShared(&s_clientInfoLock);
+    LONG updates = s_clientInfoUpdates;
+    LONG sessions = s_clientInfoSessions;
+    ReleaseSRWLockShared(&s_clientInfoLock);
+
+    if (g_pCloudLibrary->GetClientInfo != NULL)
+    {
+        snapshot.info.version = GfnClientInfoVersion;
+        snapshot.hasInfo = GFNSDK_SUCCEEDED(gfnTranslateCloudStatus(g_pCloudLibrary->GetClientInfo(&snapshot.info)));
+    }
+    if (g_pCloudLibrary->GetClientCountryCode != NULL)
+    {
+        snapshot.hasCountryCode = GFNSDK_SUCCEEDED(gfnTranslateCloudStatus(
+            g_pCloudLibrary->GetClientCountryCode(snapshot.countryCode, CC_SIZE)));
+    }
+    bool hasIp = gfnCopyCloudString(g_pCloudLibrary->GetClientIp, ip);
+    bool hasLanguageCode = gfnCopyCloudString(g_pCloudLibrary->GetClientLanguageCode, languageCode);
+
+    AcquireSRWLockExclusive(&s_clientInfoLock);
+    if (s_clientInfoSessions != sessions)
+    {
+        // The session init callback left the copy cleared and stale, the next reader tries again
+        ReleaseSRWLockExclusive(&s_clientInfoLock);
+        return;
+    }
+    snapshot.ip = hasIp ? gfnInternClientString(ip) : NULL;
+    snapshot.hasIp = (snapshot.ip != NULL);
+    snapshot.languageCode = hasLanguageCode ? gfnInternClientString(languageCode) : NULL;
+    snapshot.hasLanguageCode = (snapshot.languageCode != NULL);
+    if (s_clientInfoUpdates != updates && s_clientInfoSnapshot.hasInfo)
+    {
+        snapshot.info.osType = s_clientInfoSnapshot.info.osType;
+    }
+    gfnPublishClientInfo(&snapshot);
+    ReleaseSRWLockExclusive(&s_clientInfoLock);
+}
+
+static void GFN_CALLBACK _gfnClientInfoSnapshotCallback(int status, void* updateData, void* pContext)
+{
+    (void)status;
+    (void)pContext;
+    GFN_SDK_LOG("ClientInfo update received");
+
+    GfnClientInfoUpdateData* pUpdate = (GfnClientInfoUpdateData*)updateData;
+    if (pUpdate == NULL)
+    {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&s_clientInfoLock);
+    GfnClientInfoSnapshot snapshot = s_clientInfoSnapshot;
+    if (pUpdate->updateType == gfnOs)
+    {
+        snapshot.info.osType = pUpdate->data.osType;
+    }
+    else
+    {
+        // Unknown to this wrapper version, stop answering from the copy
+        snapshot.hasInfo = false;
+    }
+    s_clientInfoUpdates++;
+    gfnPublishClientInfo(&snapshot);
+    ReleaseSRWLockExclusive(&s_clientInfoLock);
+
+    gfnDeliverEvent(gfnCallbackEventClientInfo, pUpdate);
+}
+
+static void GFN_CALLBACK _gfnSessionInitSnapshotCallback(int status, void* pData, void* pContext)
+{
+    (void)status;
+    (void)pContext;
+
+    // Calls go to the library until a reader has fetched the connected client's info. That
+    // doesn't happen here, the library is in the middle of raising the event.
+    GfnClientInfoSnapshot empty;
+    memset(&empty, 0, sizeof(empty));
+
+    AcquireSRWLockExclusive(&s_clientInfoLock);
+    s_clientInfoSessions++;
+    gfnPublishClientInfo(&empty);
+    ReleaseSRWLockExclusive(&s_clientInfoLock);
+    gfnStoreRelease(&s_clientInfoStale, 1);
+
+    gfnDeliverEvent(gfnCallbackEventSessionInit, pData);
+}
+
+// Called under s_initLock once the cloud library is known to be usable
+static void gfnSubscribeClientInfo(void)
+{
+    // Without session init the copy would never learn about a client connecting to a pre-launched title
+    void* pSessionInitContext = (void*)(ULONG_PTR)gfnCallbackEventSessionInit;
+    if (g_pCloudLibrary->RegisterSessionInitCallback == NULL ||
+        GFNSDK_FAILED(gfnTranslateCloudStatus(g_pCloudLibrary->RegisterSessionInitCallback(&_gfnSessionInitSnapshotCallback, pSessionInitContext))) ||
+        g_pCloudLibrary->RegisterClientInfoCallback == NULL ||
+        GFNSDK_FAILED(gfnTranslateCloudStatus(g_pCloudLibrary->RegisterClientInfoCallback(&_gfnClientInfoSnapshotCallback, NULL))))
+    {
+        GFN_SDK_LOG("Unable to register for ClientInfo updates, client info calls go to the cloud library");
+        return;
+    }
+
+    // Application callbacks are fanned out from the snapshot callbacks
+    gfnStoreRelease(&s_callbackRegistry[gfnCallbackEventSessionInit].hookState, gfnCallbackHooked);
+    gfnStoreRelease(&s_callbackRegistry[gfnCallbackEventClientInfo].hookState, gfnCallbackHooked);
+    gfnRefreshClientInfo();
+    gfnStoreRelease(&s_clientInfoSubscribed, 1);
+}
+
+// Called under s_initLock before the cloud library is unloaded
+static void gfnUnsubscribeClientInfo(void)
+{
+    GfnClientInfoSnapshot empty;
+    memset(&empty, 0, sizeof(empty));
+
+    AcquireSRWLockExclusive(&s_clientInfoLock);
+    gfnPublishClientInfo(&empty);
+    ReleaseSRWLockExclusive(&s_clientInfoLock);
+
+    gfnStoreRelease(&s_clientInfoSubscribed, 0);
+    gfnStoreRelease(&s_clientInfoStale, 0);
+}
+
+// Called under s_initLock once initialization succeeded, publishes the resolved entry points
+static void gfnResolveDispatch(void)
+{
+    memset(&s_resolvedDispatch, 0, sizeof(s_resolvedDispatch));
+
+    if (g_pClientLibrary != NULL)
+    {
+        s_resolvedDispatch.RegisterStreamStatusCallback = g_pClientLibrary->RegisterStreamStatusCallback;
+        s_resolvedDispatch.StartStream = g_pClientLibrary->StartStream;
+        s_resolvedDispatch.StartStreamAsync = g_pClientLibrary->StartStreamAsync;
+        s_resolvedDispatch.StopStream = g_pClientLibrary->StopStream;
+        s_resolvedDispatch.StopStreamAsync = g_pClientLibrary->StopStreamAsync;
+        s_resolvedDispatch.TitleExited = g_pClientLibrary->TitleExited;
+    }
+
+    if (g_pCloudLibrary != NULL && g_pCloudLibrary->IsRunningInCloud != NULL)
+    {
+        g_isCloud = ((bool)g_pCloudLibrary->IsRunningInCloud()) ? IsCloud_Yes : IsCloud_No;
+    }
+
+    if (g_isCloud == IsCloud_Yes)
+    {
+        s_resolvedDispatch.Free = g_pCloudLibrary->Free;
+        s_resolvedDispatch.GetClientIp = g_pCloudLibrary->GetClientIp;
+        s_resolvedDispatch.GetClientLanguageCode = g_pCloudLibrary->GetClientLanguageCode;
+        s_resolvedDispatch.GetClientCountryCode = g_pCloudLibrary->GetClientCountryCode;
+        s_resolvedDispatch.GetCustomData = g_pCloudLibrary->GetCustomData;
+        s_resolvedDispatch.GetAuthData = g_pCloudLibrary->GetAuthData;
+        s_resolvedDispatch.IsTitleAvailable = g_pCloudLibrary->IsTitleAvailable;
+        s_resolvedDispatch.GetTitlesAvailable = g_pCloudLibrary->GetTitlesAvailable;
+        s_resolvedDispatch.GetClientInfo = g_pCloudLibrary->GetClientInfo;
+        s_resolvedDispatch.SetupTitle = g_pCloudLibrary->SetupTitle;
+        s_resolvedDispatch.AppReady = g_pCloudLibrary->AppReady;
+        s_resolvedDispatch.SetActionZone = g_pCloudLibrary->SetActionZone;
+        s_resolvedDispatch.RegisterExitCallback = g_pCloudLibrary->RegisterExitCallback;
+        s_resolvedDispatch.RegisterSaveCallback = g_pCloudLibrary->RegisterSaveCallback;
+        s_resolvedDispatch.RegisterSessionInitCallback = g_pCloudLibrary->RegisterSessionInitCallback;
+        s_resolvedDispatch.RegisterPauseCallback = g_pCloudLibrary->RegisterPauseCallback;
+        s_resolvedDispatch.RegisterInstallCallback = g_pCloudLibrary->RegisterInstallCallback;
+        s_resolvedDispatch.RegisterClientInfoCallback = g_pCloudLibrary->RegisterClientInfoCallback;
+
+        gfnSubscribeClientInfo();
+    }
+
+    gfnPublishDispatch(&s_resolvedDispatch);
+}
+
+static GfnRuntimeError gfnInitializeSdkFromPathLocked(GfnDisplayLanguage language, const char* sdkLibraryPath);
+static GfnRuntimeError gfnShutdownSdkLocked(void);
+
+static GfnRuntimeError gfnInitializeSdkLocked(GfnDisplayLanguage language)
+{
+    // If "client" SDK is already initialized, then we're good to go.
+    // "server" SDK may or may not be initialized depending on mode.
+    GfnRuntimeError clientStatus = gfnSuccess;
+
+    if (!g_LoggingInitialized)
+    {
+        GFN_SDK_INIT_LOGGING();
+        g_LoggingInitialized = true;
+    }
+
+
+    if (s_wrapperState == gfnWrapperInitialized)
+    {
+        GFN_SDK_LOG("Client library already initialized, no need to initialize again");
+    }
+    else
+    {
+        wchar_t* filename = (wchar_t*)malloc(sizeof(wchar_t) * MAX_PATH);
+        if (!filename)
+        {
+            return gfnInternalError;
+        }
+        DWORD pathSize = GetModuleFileNameW(NULL, filename, MAX_PATH);
+        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+        {
+            free(filename);
+            filename = (wchar_t*)malloc(sizeof(wchar_t) * (pathSize + 1)); //Room for \0
+            if (!filename)
+            {
+                return gfnInternalError;
+            }
+            pathSize = GetModuleFileNameW(NULL, filename, pathSize + 1);
+        }
+
+        wchar_t* lastSepPos = wcsrchr(filename, L'\\');
+        size_t pathLength = lastSepPos - filename + 1;
+        size_t dllPathLength = pathLength + 18; // "GfnRuntimeSdk.dll\0"
+        wchar_t* dllPath = (wchar_t*)malloc(sizeof(wchar_t) * dllPathLength);
+        if (!dllPath)
+        {
+            free(filename);
+            return gfnInternalError;
+        }
+        wcsncpy_s(dllPath, dllPathLength, filename, _TRUNCATE);
+
+        dllPath[pathLength] = L'\0';
+        free(filename);
+        wcsncat_s(dllPath, dllPathLength, L"GfnRuntimeSdk.dll", 17);
+
+        char* sdkLibPath = (char*)malloc(dllPathLength * sizeof(char));
+        if (!sdkLibPath)
+        {
+            free(dllPath);
+            return gfnInternalError;
+        }
+        int outSize = (int)dllPathLength * sizeof(char);
+        if (!GfnWideToUtf8(dllPath, sdkLibPath, outSize))
+        {
+            GFN_SDK_LOG_ERROR("Invalid client library path");
+            free(sdkLibPath);
+            free(dllPath);
+            return gfnInternalError;
+        }
+        clientStatus = gfnInitializeSdkFromPathLocked(language, sdkLibPath);
+        free(sdkLibPath);
+        free(dllPath);
+    }
+
+    if (GFNSDK_FAILED(clientStatus))
+    {
+        GFN_SDK_LOG_ERROR("Initialization failed: %d", clientStatus);
+        gfnShutdownSdkLocked();
+    }
+
+    return clientStatus;
+}
+
+GfnRuntimeError GfnInitializeSdk(GfnDisplayLanguage language)
+{
+    // Steady state, nothing to wait for
+    if (gfnLoadAcquire(&s_wrapperState) == gfnWrapperInitialized)
+    {
+        return gfnSuccess;
+    }
+
+    AcquireSRWLockExclusive(&s_initLock);
+    GfnRuntimeError status = gfnInitializeSdkLocked(language);
+    ReleaseSRWLockExclusive(&s_initLock);
+    return status;
+}
+
+typedef struct GfnInitializeSdkRequest_t
+{
+    GfnDisplayLanguage language;
+    GfnInitializeSdkCallbackSig callback;
+    void* pUserContext;
+} GfnInitializeSdkRequest;
+
+static DWORD WINAPI gfnInitializeSdkThread(LPVOID pParam)
+{
+    GfnInitializeSdkRequest request = *(GfnInitializeSdkRequest*)pParam;
+    free(pParam);
+
+    GfnRuntimeError status = GfnInitializeSdk(request.language);
+    request.callback(status, request.pUserContext);
+    return 0;
+}
+
+GfnRuntimeError GfnInitializeSdkAsync(GfnDisplayLanguage language, GfnInitializeSdkCallbackSig callback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(callback);
+
+    GfnInitializeSdkRequest* pRequest = (GfnInitializeSdkRequest*)malloc(sizeof(GfnInitializeSdkRequest));
+    if (pRequest == NULL)
+    {
+        return gfnUnableToAllocateMemory;
+    }
+    pRequest->language = language;
+    pRequest->callback = callback;
+    pRequest->pUserContext = pUserContext;
+
+    HANDLE thread = CreateThread(NULL, 0, gfnInitializeSdkThread, pRequest, 0, NULL);
+    if (thread == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Unable to start asynchronous initialization. LastError=0x%08X", GetLastError());
+        free(pRequest);
+        return gfnInternalError;
+    }
+    CloseHandle(thread);
+    return gfnSuccess;
+}
+
+static GfnRuntimeError gfnInitializeSdkFromPathLocked(GfnDisplayLanguage language, const char* sdkLibraryPath)
+{
+    // If "client" library is already initialized, then we're good to go.
+    if (s_wrapperState == gfnWrapperInitialized)
+    {
+        GFN_SDK_LOG("Client library already initialized, no need to initialize again");
+        return gfnSuccess;
+    }
+
+    GfnRuntimeError clientStatus = gfnSuccess;
+    if (!g_LoggingInitialized)
+    {
+        GFN_SDK_INIT_LOGGING();
+        g_LoggingInitialized = true;
+    }
+
+    if (s_performanceFrequency == 0)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        s_performanceFrequency = frequency.QuadPart;
+    }
+
+    if (sdkLibraryPath == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Invalid SDK library path");
+        return gfnInvalidParameter;
+    }
+
+    size_t libPathSize = strlen(sdkLibraryPath) + 1;
+    wchar_t* wSdkLibraryPath = (wchar_t*)malloc(libPathSize * sizeof(wchar_t));
+    if (!wSdkLibraryPath)
+    {
+        GFN_SDK_LOG_ERROR("Failed to allocate for SDK library path");
+        return gfnUnableToAllocateMemory;
     }
     int outSize = (int)libPathSize * sizeof(wchar_t);
     if (!GfnUtf8ToWide(sdkLibraryPath, wSdkLibraryPath, outSize))
     {
-        GFN_SDK_LOG("Failed to convert SDK library path");
+        GFN_SDK_LOG_ERROR("Failed to convert SDK library path");
         free(wSdkLibraryPath);
         return gfnInternalError;
     }
@@ -487,11 +2044,14 @@ GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char
     wchar_t* lastSepPos = (lastBackSepPos != NULL && lastBackSepPos > lastForeSepPos) ? lastBackSepPos : lastForeSepPos;
     if (_wcsicmp((lastBackSepPos == NULL && lastForeSepPos == NULL) ? wSdkLibraryPath : lastSepPos + 1, L"GfnRuntimeSdk.dll") != 0)
     {
-        GFN_SDK_LOG("Invalid SDK library name");
+        GFN_SDK_LOG_ERROR("Invalid SDK library name");
         free(wSdkLibraryPath);
         return gfnInvalidParameter;
     }
 
+    GfnCloudLoad cloudLoad;
+    gfnBeginCloudLoad(&cloudLoad);
+
     if (PathFileExistsW(wSdkLibraryPath) == FALSE)
     {
         clientStatus = gfnClientLibraryNotFound;
@@ -503,12 +2063,12 @@ GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char
         // For security reasons, it is preferred to check the digital signature before loading the DLL.
         // Such code is not provided here to reduce code complexity and library size, and in favor of
         // any internal libraries built for this purpose.
-#ifdef _DEBUG
+#if defined(_DEBUG) || defined(GFN_SDK_ALLOW_UNSIGNED_LIBRARY)
         g_gfnSdkModule = LoadLibraryW(wSdkLibraryPath);
         free(wSdkLibraryPath);
         if (g_gfnSdkModule == NULL)
         {
-            GFN_SDK_LOG("Not able to load SDK library. LastError=0x%08X", GetLastError());
+            GFN_SDK_LOG_ERROR("Not able to load SDK library. LastError=0x%08X", GetLastError());
             clientStatus = gfnClientLibraryNotFound;
         }
 #else
@@ -516,53 +2076,55 @@ GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char
         free(wSdkLibraryPath);
         if (g_gfnSdkModule == NULL)
         {
-            GFN_SDK_LOG("Not able to securely load SDK library. LastError=0x%08X", GetLastError());
+            GFN_SDK_LOG_ERROR("Not able to securely load SDK library. LastError=0x%08X", GetLastError());
             clientStatus = gfnBinarySignatureInvalid;
         }
 #endif
         else
         {
-            gfnInitializeRuntimeSdkFn fnGfnInitializeRuntimeSdk = (gfnInitializeRuntimeSdkFn)GetProcAddress(g_gfnSdkModule, "gfnInitializeRuntimeSdk");
-            if (fnGfnInitializeRuntimeSdk == NULL)
-            {
-                clientStatus = gfnAPINotFound;
-            }
-            else
-            {
-                clientStatus = (fnGfnInitializeRuntimeSdk)(language);
-            }
+            clientStatus = gfnLoadClientLibrary(g_gfnSdkModule, &g_pClientLibrary);
         }
     }
+
+    // Both libraries are loaded and verified, or failed to be, before either one is initialized
+    gfnEndCloudLoad(&cloudLoad);
+    if (GFNSDK_SUCCEEDED(clientStatus))
+    {
+        clientStatus = g_pClientLibrary->InitializeRuntimeSdk(language);
+    }
     // The gfnClientLibraryNotFound error means client library was not present.
     // This is allowed in the GFN cloud environment for robustness reasons as all API
     // calls are deferred to the cloud library, although this is not a recommended use case.
     // Any other error, including presence of a client library that couldn't be validated, is fatal.
     if (GFNSDK_FAILED(clientStatus) && clientStatus != gfnClientLibraryNotFound)
     {
-        GFN_SDK_LOG("Client SDK library init failed: %d", clientStatus);
-        GfnShutdownSdk();
+        GFN_SDK_LOG_ERROR("Client SDK library init failed: %d", clientStatus);
+        gfnDiscardCloudLoad(&cloudLoad);
+        gfnShutdownSdkLocked();
         return clientStatus;
     }
 
-    // With the client library loaded attempt to load the cloud Sdk library if available (inside GFN only) in order to use it
+    // With the client library initialized, initialize the cloud Sdk library if available (inside GFN only) in order to use it
     // directly for cloud API calls.
-    GfnRuntimeError cloudStatus = gfnInitializeCloudSdk();
+    GfnRuntimeError cloudStatus = gfnInitializeCloudSdkFromLoad(&cloudLoad);
     // gfnCloudLibraryNotFound is allowed, indicating that this is not running in a cloud environment.
     // All other errors are fatal.
     if (GFNSDK_FAILED(cloudStatus) && (cloudStatus != gfnCloudLibraryNotFound))
     {
-        GFN_SDK_LOG("Cloud library init failed: %d", cloudStatus);
-        GfnShutdownSdk();
+        GFN_SDK_LOG_ERROR("Cloud library init failed: %d", cloudStatus);
+        gfnShutdownSdkLocked();
         return cloudStatus;
     }
 
     // If we could find either SDK library, then this is a fatal condition.
     if (clientStatus == gfnClientLibraryNotFound && cloudStatus == gfnCloudLibraryNotFound)
     {
-        GFN_SDK_LOG("Failed to find any valid SDK libraries");
+        GFN_SDK_LOG_ERROR("Failed to find any valid SDK libraries");
         return clientStatus;
     }
 
+    gfnResolveDispatch();
+    gfnStoreRelease(&s_wrapperState, gfnWrapperInitialized);
     GFN_SDK_LOG("Initialization successful");
 
     if (GFNSDK_SUCCEEDED(cloudStatus) && clientStatus == gfnClientLibraryNotFound)
@@ -577,37 +2139,336 @@ GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char
     return gfnSuccess;
 }
 
-GfnRuntimeError GfnShutdownSdk(void)
+GfnRuntimeError GfnInitializeSdkFromPath(GfnDisplayLanguage language, const char* sdkLibraryPath)
+{
+    if (gfnLoadAcquire(&s_wrapperState) == gfnWrapperInitialized)
+    {
+        return gfnSuccess;
+    }
+
+    AcquireSRWLockExclusive(&s_initLock);
+    GfnRuntimeError status = gfnInitializeSdkFromPathLocked(language, sdkLibraryPath);
+    ReleaseSRWLockExclusive(&s_initLock);
+    return status;
+}
+
+// Title availability set. GfnGetTitlesAvailable returns one comma-separated list and
+// GfnIsTitleAvailable costs a call into the cloud library per title, so GfnAreTitlesAvailable
+// answers from an open-addressed hash set built from the list instead. The set is rebuilt once it
+// is older than GFN_TITLE_SET_TTL_MS, or on GfnRefreshTitlesAvailable. Lookups hold s_titleSetLock
+// shared; a rebuild fills the new set without the lock and only swaps it in exclusively.
+#define GFN_TITLE_SET_TTL_MS 60000
+#define GFN_TITLE_SET_MIN_SLOTS 16
+
+// One allocation: the struct, then the slots, the hashes and the list itself
+typedef struct GfnTitleSet_t
+{
+    ULONGLONG builtAt;          // GetTickCount64
+    size_t mask;                // slot count - 1, the slot count is a power of two
+    const char** slots;         // into names, NULL for an empty slot
+    unsigned int* hashes;
+    char* names;                // the list with the separators replaced by terminators
+} GfnTitleSet;
+
+static GfnTitleSet* s_pTitleSet = NULL;             // guarded by s_titleSetLock
+static SRWLOCK s_titleSetLock = SRWLOCK_INIT;
+
+// FNV-1a
+static unsigned int gfnHashTitle(const char* platformAppId)
+{
+    unsigned int hash = 2166136261u;
+    for (; *platformAppId != '\0'; ++platformAppId)
+    {
+        hash ^= (unsigned char)*platformAppId;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool gfnFindTitle(const GfnTitleSet* pSet, const char* platformAppId)
+{
+    unsigned int hash = gfnHashTitle(platformAppId);
+    for (size_t i = hash & pSet->mask; pSet->slots[i] != NULL; i = (i + 1) & pSet->mask)
+    {
+        if (pSet->hashes[i] == hash && strcmp(pSet->slots[i], platformAppId) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void gfnInsertTitle(GfnTitleSet* pSet, const char* platformAppId)
+{
+    unsigned int hash = gfnHashTitle(platformAppId);
+    size_t i = hash & pSet->mask;
+    for (; pSet->slots[i] != NULL; i = (i + 1) & pSet->mask)
+    {
+        if (pSet->hashes[i] == hash && strcmp(pSet->slots[i], platformAppId) == 0)
+        {
+            return;
+        }
+    }
+    pSet->slots[i] = platformAppId;
+    pSet->hashes[i] = hash;
+}
+
+static GfnTitleSet* gfnBuildTitleSet(const char* list)
+{
+    size_t listSize = strlen(list) + 1;
+    size_t count = 1;
+    for (const char* p = list; *p != '\0'; ++p)
+    {
+        count += (*p == ',');
+    }
+
+    // At most half full keeps the probe sequences short
+    size_t slotCount = GFN_TITLE_SET_MIN_SLOTS;
+    while (slotCount < count * 2)
+    {
+        slotCount <<= 1;
+    }
+
+    GfnTitleSet* pSet = (GfnTitleSet*)malloc(sizeof(GfnTitleSet) + slotCount * (sizeof(const char*) + sizeof(unsigned int)) + listSize);
+    if (pSet == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Unable to allocate memory for %zu available titles", count);
+        return NULL;
+    }
+    pSet->builtAt = GetTickCount64();
+    pSet->mask = slotCount - 1;
+    pSet->slots = (const char**)(pSet + 1);
+    pSet->hashes = (unsigned int*)(pSet->slots + slotCount);
+    pSet->names = (char*)(pSet->hashes + slotCount);
+    memset(pSet->slots, 0, slotCount * sizeof(const char*));
+    memcpy(pSet->names, list, listSize);
+
+    for (char* name = pSet->names; name != NULL;)
+    {
+        char* next = strchr(name, ',');
+        if (next != NULL)
+        {
+            *next++ = '\0';
+        }
+
+        while (*name == ' ')
+        {
+            ++name;
+        }
+        size_t length = strlen(name);
+        while (length > 0 && name[length - 1] == ' ')
+        {
+            name[--length] = '\0';
+        }
+        if (length > 0)
+        {
+            gfnInsertTitle(pSet, name);
+        }
+        name = next;
+    }
+    return pSet;
+}
+
+static void gfnSwapTitleSet(GfnTitleSet* pSet)
+{
+    AcquireSRWLockExclusive(&s_titleSetLock);
+    GfnTitleSet* pOld = s_pTitleSet;
+    s_pTitleSet = pSet;
+    ReleaseSRWLockExclusive(&s_titleSetLock);
+
+    // Readers only use the set under the lock, so nobody can still be looking at the old one
+    free(pOld);
+}
+
+static GfnRuntimeError gfnRefreshTitleSet(const GfnSdkDispatch* pDispatch)
+{
+    const char* list = NULL;
+    GfnRuntimeError status = gfnTranslateCloudStatus(pDispatch->GetTitlesAvailable(&list));
+    if (GFNSDK_FAILED(status))
+    {
+        GFN_SDK_LOG_ERROR("Unable to get the available titles: %d", status);
+        return status;
+    }
+
+    GfnTitleSet* pSet = gfnBuildTitleSet(list != NULL ? list : "");
+    if (list != NULL && pDispatch->Free != NULL)
+    {
+        pDispatch->Free(&list);
+    }
+    if (pSet == NULL)
+    {
+        return gfnUnableToAllocateMemory;
+    }
+
+    gfnSwapTitleSet(pSet);
+    return gfnSuccess;
+}
+
+// Signature verdict for the cloud library. Verifying walks the whole certificate chain and takes
+// milliseconds, so the verdict is kept together with the identity of the file it was reached for:
+// volume serial number, file index, size and last write time. While the wrapper is initialized the
+// file stays open without write or delete sharing, so it can't be modified or replaced behind the
+// verdict and later calls only load it. A later initialization that finds the file unchanged
+// reuses the verdict. GfnIsRunningInCloudSecureEx can force a fresh verification.
+typedef enum GfnSignatureVerdict
+{
+    gfnSignatureUnknown = 0,
+    gfnSignatureValid,
+    gfnSignatureInvalid
+} GfnSignatureVerdict;
+
+typedef struct GfnFileIdentity_t
+{
+    DWORD volumeSerialNumber;
+    DWORD fileIndexHigh;
+    DWORD fileIndexLow;
+    DWORD sizeHigh;
+    DWORD sizeLow;
+    FILETIME lastWriteTime;
+} GfnFileIdentity;
+
+static volatile LONG s_cloudSignatureVerdict = gfnSignatureUnknown;    // for the file held in s_cloudLibraryFile
+static SRWLOCK s_cloudSignatureLock = SRWLOCK_INIT;
+static HANDLE s_cloudLibraryFile = INVALID_HANDLE_VALUE;                // guarded by s_cloudSignatureLock
+static GfnFileIdentity s_verifiedIdentity;                              // guarded by s_cloudSignatureLock
+static LONG s_verifiedVerdict = gfnSignatureUnknown;                    // guarded by s_cloudSignatureLock
+
+static bool gfnGetFileIdentity(HANDLE file, GfnFileIdentity* pIdentity)
+{
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(file, &info))
+    {
+        return false;
+    }
+
+    memset(pIdentity, 0, sizeof(*pIdentity));
+    pIdentity->volumeSerialNumber = info.dwVolumeSerialNumber;
+    pIdentity->fileIndexHigh = info.nFileIndexHigh;
+    pIdentity->fileIndexLow = info.nFileIndexLow;
+    pIdentity->sizeHigh = info.nFileSizeHigh;
+    pIdentity->sizeLow = info.nFileSizeLow;
+    pIdentity->lastWriteTime = info.ftLastWriteTime;
+    return true;
+}
+
+static GfnSignatureVerdict gfnCheckCloudLibrarySignature(bool forceRevalidate)
+{
+    LONG verdict = gfnLoadAcquire(&s_cloudSignatureVerdict);
+    if (verdict != gfnSignatureUnknown && !forceRevalidate)
+    {
+        return (GfnSignatureVerdict)verdict;
+    }
+
+    AcquireSRWLockExclusive(&s_cloudSignatureLock);
+    verdict = s_cloudSignatureVerdict;
+    if (verdict == gfnSignatureUnknown || forceRevalidate)
+    {
+        GfnFileIdentity identity;
+        if (s_cloudLibraryFile == INVALID_HANDLE_VALUE && gfnLoadAcquire(&s_wrapperState) == gfnWrapperInitialized)
+        {
+            // Readers are still welcome, the signature check opens the file again
+            s_cloudLibraryFile = CreateFileW(g_cloudDllPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        }
+
+        if (s_cloudLibraryFile == INVALID_HANDLE_VALUE || !gfnGetFileIdentity(s_cloudLibraryFile, &identity))
+        {
+            // Someone else may have it open for writing, nothing to cache, try again next time
+            GFN_SDK_LOG_ERROR("Unable to lock the cloud library for verification. LastError=0x%08X", GetLastError());
+            verdict = gfnSignatureInvalid;
+        }
+        else
+        {
+            if (!forceRevalidate && s_verifiedVerdict != gfnSignatureUnknown &&
+                memcmp(&identity, &s_verifiedIdentity, sizeof(identity)) == 0)
+            {
+                GFN_SDK_LOG("Cloud library unchanged since it was last verified");
+                verdict = s_verifiedVerdict;
+            }
+            else
+            {
+                verdict = gfnCheckLibraryGfnSignatureW(g_cloudDllPath) ? gfnSignatureValid : gfnSignatureInvalid;
+                s_verifiedIdentity = identity;
+                s_verifiedVerdict = verdict;
+            }
+            gfnStoreRelease(&s_cloudSignatureVerdict, verdict);
+        }
+    }
+    ReleaseSRWLockExclusive(&s_cloudSignatureLock);
+    return (GfnSignatureVerdict)verdict;
+}
+
+// Called under s_initLock before the cloud library is unloaded, the verdict for its identity is kept
+static void gfnReleaseCloudLibraryFile(void)
+{
+    AcquireSRWLockExclusive(&s_cloudSignatureLock);
+    if (s_cloudLibraryFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(s_cloudLibraryFile);
+        s_cloudLibraryFile = INVALID_HANDLE_VALUE;
+    }
+    gfnStoreRelease(&s_cloudSignatureVerdict, gfnSignatureUnknown);
+    ReleaseSRWLockExclusive(&s_cloudSignatureLock);
+}
+
+static GfnRuntimeError gfnShutdownSdkLocked(void)
 {
+    // Route every call through the checked path before the libraries go away
+    gfnStoreRelease(&s_wrapperState, gfnWrapperUninitialized);
+    gfnPublishDispatch(&s_uninitializedDispatch);
+
+    gfnUnsubscribeClientInfo();
+    gfnSwapTitleSet(NULL);
     gfnShutDownCloudSdk();
+    gfnReleaseCloudLibraryFile();
 
     if (g_gfnSdkModule == NULL)
     {
         // Not initialized, no need to shutdown
+        gfnResetCallbackDelivery();
+        gfnResetCallbackRegistry();
         return gfnSuccess;
     }
 
-    gfnShutdownRuntimeSdkFn fnGfnShutdownRuntimeSdk = (gfnShutdownRuntimeSdkFn)GetProcAddress(g_gfnSdkModule, "gfnShutdownRuntimeSdk");
-    if (fnGfnShutdownRuntimeSdk == NULL)
-    {
-        return gfnAPINotFound;
+    // No client table means the library never got as far as being initialized, only unload it
+    if (g_pClientLibrary != NULL)
+    {
+        if (g_pClientLibrary->ShutdownRuntimeSdk == NULL)
+        {
+            gfnResetCallbackDelivery();
+            gfnResetCallbackRegistry();
+            return gfnAPINotFound;
+        }
+
+        g_pClientLibrary->ShutdownRuntimeSdk();
+        gfnFreeClientLibrary(g_pClientLibrary);
+        g_pClientLibrary = NULL;
     }
 
-    fnGfnShutdownRuntimeSdk();
-
     FreeLibrary(g_gfnSdkModule);
     g_gfnSdkModule = NULL;
 
+    gfnResetCallbackDelivery();
+    gfnResetCallbackRegistry();
+
     GFN_SDK_DEINIT_LOGGING();
+    g_LoggingInitialized = false;
     return gfnSuccess;
 }
 
+GfnRuntimeError GfnShutdownSdk(void)
+{
+    AcquireSRWLockExclusive(&s_initLock);
+    GfnRuntimeError status = gfnShutdownSdkLocked();
+    ReleaseSRWLockExclusive(&s_initLock);
+    return status;
+}
+
 GfnRuntimeError GfnIsRunningInCloud(bool* runningInCloud)
 {
     CHECK_NULL_PARAM(runningInCloud);
     *runningInCloud = false;
 
-    if (g_pCloudLibrary == NULL && g_gfnSdkModule == NULL)
+    if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized)
     {
         return gfnAPINotInit;
     }
@@ -618,24 +2479,30 @@ GfnRuntimeError GfnIsRunningInCloud(bool* runningInCloud)
         return gfnSuccess;
     }
 
-    if (g_pCloudLibrary->IsRunningInCloud == NULL)
+    // Asked once during initialization, the answer doesn't change for the life of the process
+    if (g_isCloud == IsCloud_Unknown)
     {
         GFN_SDK_LOG("API Not Found");
         return gfnAPINotFound;
     }
 
-    *runningInCloud = (bool)g_pCloudLibrary->IsRunningInCloud();
+    *runningInCloud = (g_isCloud == IsCloud_Yes);
 
     GFN_SDK_LOG("Success: %d", *runningInCloud);
     return gfnSuccess;
 }
 
 GfnRuntimeError GfnIsRunningInCloudSecure(GfnIsRunningInCloudAssurance* assurance)
+{
+    return GfnIsRunningInCloudSecureEx(assurance, false);
+}
+
+GfnRuntimeError GfnIsRunningInCloudSecureEx(GfnIsRunningInCloudAssurance* assurance, bool forceRevalidate)
 {
     CHECK_NULL_PARAM(assurance);
     *assurance = gfnNotCloud;
 
-    if (g_pCloudLibrary == NULL && g_gfnSdkModule == NULL)
+    if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized)
     {
         return gfnAPINotInit;
     }
@@ -646,7 +2513,7 @@ GfnRuntimeError GfnIsRunningInCloudSecure(GfnIsRunningInCloudAssurance* assuranc
         return gfnSuccess;
     }
 
-    if (gfnCheckLibraryGfnSignatureW(g_cloudDllPath) == FALSE)
+    if (gfnCheckCloudLibrarySignature(forceRevalidate) != gfnSignatureValid)
     {
         GFN_SDK_LOG("Cloud library path does not have valid GFN signing, treating as not in cloud");
         return gfnSuccess;
@@ -674,363 +2541,1089 @@ GfnRuntimeError GfnIsRunningInCloudSecure(GfnIsRunningInCloudAssurance* assuranc
 
 GfnRuntimeError GfnFree(const char** data)
 {
+    GFN_COUNT_CALL(Free);
     CHECK_NULL_PARAM(data);
-    CHECK_CLOUD_ENVIRONMENT();
+    // Strings from the client info snapshot are owned by the wrapper
+    if (gfnIsClientString(*data))
+    {
+        *data = NULL;
+        return gfnSuccess;
+    }
     DELEGATE_TO_CLOUD_LIBRARY(Free, data);
 }
 
 GfnRuntimeError GfnGetClientIpV4(const char ** clientIp)
 {
+    GFN_COUNT_CALL(GetClientIp);
     CHECK_NULL_PARAM(clientIp);
-    CHECK_CLOUD_ENVIRONMENT();
+    GfnClientInfoSnapshot snapshot;
+    if (gfnReadClientInfo(&snapshot) && snapshot.hasIp)
+    {
+        *clientIp = snapshot.ip;
+        return gfnSuccess;
+    }
     DELEGATE_TO_CLOUD_LIBRARY(GetClientIp, clientIp);
 }
 
 GfnRuntimeError GfnGetClientLanguageCode(const char** languageCode)
 {
+    GFN_COUNT_CALL(GetClientLanguageCode);
     CHECK_NULL_PARAM(languageCode);
-    CHECK_CLOUD_ENVIRONMENT();
+    GfnClientInfoSnapshot snapshot;
+    if (gfnReadClientInfo(&snapshot) && snapshot.hasLanguageCode)
+    {
+        *languageCode = snapshot.languageCode;
+        return gfnSuccess;
+    }
     DELEGATE_TO_CLOUD_LIBRARY(GetClientLanguageCode, languageCode);
 }
 
 GfnRuntimeError GfnGetClientCountryCode(char* countryCode, unsigned int length)
 {
+    GFN_COUNT_CALL(GetClientCountryCode);
     CHECK_NULL_PARAM(countryCode);
-    CHECK_CLOUD_ENVIRONMENT();
+    GfnClientInfoSnapshot snapshot;
+    // A buffer that is too small is left to the library so the error matches
+    if (length >= CC_SIZE && gfnReadClientInfo(&snapshot) && snapshot.hasCountryCode)
+    {
+        memcpy(countryCode, snapshot.countryCode, CC_SIZE);
+        return gfnSuccess;
+    }
     DELEGATE_TO_CLOUD_LIBRARY(GetClientCountryCode, countryCode, length);
 }
 
 GfnRuntimeError GfnGetCustomData(const char** customData)
 {
+    GFN_COUNT_CALL(GetCustomData);
     CHECK_NULL_PARAM(customData);
-    CHECK_CLOUD_ENVIRONMENT();
     DELEGATE_TO_CLOUD_LIBRARY(GetCustomData, customData);
 }
 
 GfnRuntimeError GfnGetAuthData(const char** authData)
 {
+    GFN_COUNT_CALL(GetAuthData);
     CHECK_NULL_PARAM(authData);
-    CHECK_CLOUD_ENVIRONMENT();
     DELEGATE_TO_CLOUD_LIBRARY(GetAuthData, authData);
 }
 
+// Session snapshot. The cloud library has no call that returns everything at once, so fields
+// already held by the client info snapshot are taken from it and the rest cost one call each.
+// The struct and every string are then copied into a single allocation, released with one
+// GfnFreeSessionSnapshot, and the library's own strings are freed before returning.
+typedef struct GfnSessionString_t
+{
+    const char* value;
+    bool fromLibrary;   // needs to go back to the library's Free
+} GfnSessionString;
+
+static void gfnFetchSessionString(gfnGetClientIpFn getString, GfnSessionString* pString)
+{
+    pString->value = NULL;
+    pString->fromLibrary = false;
+    if (getString == NULL || GFNSDK_FAILED(gfnTranslateCloudStatus(getString(&pString->value))) || pString->value == NULL)
+    {
+        pString->value = NULL;
+        return;
+    }
+    pString->fromLibrary = true;
+}
+
+static const char* gfnPlaceSessionString(const GfnSessionString* pString, char** ppCursor)
+{
+    if (pString->value == NULL)
+    {
+        return NULL;
+    }
+
+    size_t size = strlen(pString->value) + 1;
+    char* placed = *ppCursor;
+    memcpy(placed, pString->value, size);
+    *ppCursor += size;
+    return placed;
+}
+
+GfnRuntimeError GfnGetSessionSnapshot(GfnSessionSnapshot** ppSnapshot)
+{
+    CHECK_NULL_PARAM(ppSnapshot);
+    *ppSnapshot = NULL;
+    // Free is only resolved in the cloud, so this is the one environment check for every field
+    RESOLVE_CLOUD_API(Free);
+
+    GfnClientInfoSnapshot clientInfo;
+    if (!gfnReadClientInfo(&clientInfo))
+    {
+        memset(&clientInfo, 0, sizeof(clientInfo));
+    }
+
+    GfnSessionString ip = { clientInfo.ip, false };
+    GfnSessionString languageCode = { clientInfo.languageCode, false };
+    GfnSessionString customData;
+    GfnSessionString authData;
+    if (!clientInfo.hasIp)
+    {
+        gfnFetchSessionString(pDispatch->GetClientIp, &ip);
+    }
+    if (!clientInfo.hasLanguageCode)
+    {
+        gfnFetchSessionString(pDispatch->GetClientLanguageCode, &languageCode);
+    }
+    gfnFetchSessionString(pDispatch->GetCustomData, &customData);
+    gfnFetchSessionString(pDispatch->GetAuthData, &authData);
+
+    if (!clientInfo.hasCountryCode && pDispatch->GetClientCountryCode != NULL)
+    {
+        clientInfo.hasCountryCode = GFNSDK_SUCCEEDED(gfnTranslateCloudStatus(
+            pDispatch->GetClientCountryCode(clientInfo.countryCode, CC_SIZE)));
+    }
+    if (!clientInfo.hasInfo && pDispatch->GetClientInfo != NULL)
+    {
+        clientInfo.info.version = GfnClientInfoVersion;
+        clientInfo.hasInfo = GFNSDK_SUCCEEDED(gfnTranslateCloudStatus(pDispatch->GetClientInfo(&clientInfo.info)));
+    }
+
+    const GfnSessionString* strings[] = { &ip, &languageCode, &customData, &authData };
+    size_t size = sizeof(GfnSessionSnapshot);
+    for (size_t i = 0; i < _countof(strings); ++i)
+    {
+        size += (strings[i]->value != NULL) ? strlen(strings[i]->value) + 1 : 0;
+    }
+
+    GfnRuntimeError status = gfnSuccess;
+    GfnSessionSnapshot* pSnapshot = (GfnSessionSnapshot*)malloc(size);
+    if (pSnapshot == NULL)
+    {
+        GFN_SDK_LOG_ERROR("Unable to allocate %zu bytes for the session snapshot", size);
+        status = gfnUnableToAllocateMemory;
+    }
+    else
+    {
+        memset(pSnapshot, 0, sizeof(*pSnapshot));
+        char* cursor = (char*)(pSnapshot + 1);
+        pSnapshot->clientIp = gfnPlaceSessionString(&ip, &cursor);
+        pSnapshot->languageCode = gfnPlaceSessionString(&languageCode, &cursor);
+        pSnapshot->customData = gfnPlaceSessionString(&customData, &cursor);
+        pSnapshot->authData = gfnPlaceSessionString(&authData, &cursor);
+        if (clientInfo.hasCountryCode)
+        {
+            memcpy(pSnapshot->countryCode, clientInfo.countryCode, CC_SIZE);
+        }
+        pSnapshot->hasClientInfo = clientInfo.hasInfo;
+        if (clientInfo.hasInfo)
+        {
+            pSnapshot->clientInfo = clientInfo.info;
+        }
+        *ppSnapshot = pSnapshot;
+    }
+
+    for (size_t i = 0; i < _countof(strings); ++i)
+    {
+        if (strings[i]->fromLibrary)
+        {
+            const char* value = strings[i]->value;
+            pDispatch->Free(&value);
+        }
+    }
+    return status;
+}
+
+GfnRuntimeError GfnFreeSessionSnapshot(GfnSessionSnapshot** ppSnapshot)
+{
+    CHECK_NULL_PARAM(ppSnapshot);
+    free(*ppSnapshot);
+    *ppSnapshot = NULL;
+    return gfnSuccess;
+}
+
 GfnRuntimeError GfnIsTitleAvailable(const char* platformAppId, bool* isAvailable)
 {
+    GFN_COUNT_CALL(IsTitleAvailable);
     CHECK_NULL_PARAM(isAvailable);
     *isAvailable = false;
 
     CHECK_NULL_PARAM(platformAppId);
-    CHECK_CLOUD_ENVIRONMENT();
-    CHECK_CLOUD_API_AVAILABLE(IsTitleAvailable);
-    *isAvailable = (bool)g_pCloudLibrary->IsTitleAvailable(platformAppId);
+    RESOLVE_CLOUD_API(IsTitleAvailable);
+    GFN_BEGIN_LIBRARY_CALL();
+    *isAvailable = (bool)pDispatch->IsTitleAvailable(platformAppId);
+    GFN_END_LIBRARY_CALL(IsTitleAvailable);
 
     return gfnSuccess;
 }
 
 GfnRuntimeError GfnGetTitlesAvailable(const char** platformAppIds)
 {
+    GFN_COUNT_CALL(GetTitlesAvailable);
     CHECK_NULL_PARAM(platformAppIds);
-    CHECK_CLOUD_ENVIRONMENT();
     DELEGATE_TO_CLOUD_LIBRARY(GetTitlesAvailable, platformAppIds);
 }
 
+// Caller buffer variants. *pLength holds the size of the buffer on input and receives the size
+// the value needs, terminator included. A NULL buffer only queries the size, a buffer that is too
+// small fails with gfnInvalidParameter and is left untouched.
+static GfnRuntimeError gfnCopyToCallerBuffer(const char* value, char* buffer, unsigned int* pLength)
+{
+    size_t required = strlen(value) + 1;
+    if ((unsigned int)required != required)
+    {
+        return gfnInternalError;
+    }
+
+    unsigned int available = *pLength;
+    *pLength = (unsigned int)required;
+    if (buffer == NULL)
+    {
+        return gfnSuccess;
+    }
+    if (available < required)
+    {
+        GFN_SDK_LOG("Buffer too small: %u bytes, %zu required", available, required);
+        return gfnInvalidParameter;
+    }
+
+    memcpy(buffer, value, required);
+    return gfnSuccess;
+}
+
+// The string the library allocated is released here, so the caller has nothing to free
+static GfnRuntimeError gfnCopyCloudStringToBuffer(const GfnSdkDispatch* pDispatch, gfnGetClientIpFn getString, char* buffer, unsigned int* pLength)
+{
+    const char* value = NULL;
+    GfnRuntimeError status = gfnTranslateCloudStatus(getString(&value));
+    if (GFNSDK_FAILED(status) || value == NULL)
+    {
+        return GFNSDK_FAILED(status) ? status : gfnLibraryCallFailure;
+    }
+
+    status = gfnCopyToCallerBuffer(value, buffer, pLength);
+    if (pDispatch->Free != NULL)
+    {
+        pDispatch->Free(&value);
+    }
+    return status;
+}
+
+GfnRuntimeError GfnGetClientIpV4ToBuffer(char* clientIp, unsigned int* length)
+{
+    CHECK_NULL_PARAM(length);
+    GfnClientInfoSnapshot snapshot;
+    if (gfnReadClientInfo(&snapshot) && snapshot.hasIp)
+    {
+        return gfnCopyToCallerBuffer(snapshot.ip, clientIp, length);
+    }
+    RESOLVE_CLOUD_API(GetClientIp);
+    return gfnCopyCloudStringToBuffer(pDispatch, pDispatch->GetClientIp, clientIp, length);
+}
+
+GfnRuntimeError GfnGetClientLanguageCodeToBuffer(char* languageCode, unsigned int* length)
+{
+    CHECK_NULL_PARAM(length);
+    GfnClientInfoSnapshot snapshot;
+    if (gfnReadClientInfo(&snapshot) && snapshot.hasLanguageCode)
+    {
+        return gfnCopyToCallerBuffer(snapshot.languageCode, languageCode, length);
+    }
+    RESOLVE_CLOUD_API(GetClientLanguageCode);
+    return gfnCopyCloudStringToBuffer(pDispatch, pDispatch->GetClientLanguageCode, languageCode, length);
+}
+
+GfnRuntimeError GfnGetCustomDataToBuffer(char* customData, unsigned int* length)
+{
+    CHECK_NULL_PARAM(length);
+    RESOLVE_CLOUD_API(GetCustomData);
+    return gfnCopyCloudStringToBuffer(pDispatch, pDispatch->GetCustomData, customData, length);
+}
+
+GfnRuntimeError GfnGetAuthDataToBuffer(char* authData, unsigned int* length)
+{
+    CHECK_NULL_PARAM(length);
+    RESOLVE_CLOUD_API(GetAuthData);
+    return gfnCopyCloudStringToBuffer(pDispatch, pDispatch->GetAuthData, authData, length);
+}
+
+GfnRuntimeError GfnGetTitlesAvailableToBuffer(char* platformAppIds, unsigned int* length)
+{
+    CHECK_NULL_PARAM(length);
+    RESOLVE_CLOUD_API(GetTitlesAvailable);
+    return gfnCopyCloudStringToBuffer(pDispatch, pDispatch->GetTitlesAvailable, platformAppIds, length);
+}
+
+GfnRuntimeError GfnAreTitlesAvailable(const char** platformAppIds, size_t count, bool* isAvailable)
+{
+    CHECK_NULL_PARAM(platformAppIds);
+    CHECK_NULL_PARAM(isAvailable);
+    memset(isAvailable, 0, count * sizeof(bool));
+    RESOLVE_CLOUD_API(GetTitlesAvailable);
+
+    AcquireSRWLockShared(&s_titleSetLock);
+    bool stale = (s_pTitleSet == NULL || GetTickCount64() - s_pTitleSet->builtAt >= GFN_TITLE_SET_TTL_MS);
+    ReleaseSRWLockShared(&s_titleSetLock);
+    if (stale)
+    {
+        GfnRuntimeError status = gfnRefreshTitleSet(pDispatch);
+        if (GFNSDK_FAILED(status))
+        {
+            return status;
+        }
+    }
+
+    AcquireSRWLockShared(&s_titleSetLock);
+    if (s_pTitleSet != NULL)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            isAvailable[i] = (platformAppIds[i] != NULL && gfnFindTitle(s_pTitleSet, platformAppIds[i]));
+        }
+    }
+    ReleaseSRWLockShared(&s_titleSetLock);
+    return gfnSuccess;
+}
+
+GfnRuntimeError GfnRefreshTitlesAvailable(void)
+{
+    RESOLVE_CLOUD_API(GetTitlesAvailable);
+    return gfnRefreshTitleSet(pDispatch);
+}
+
+
+GfnRuntimeError GfnGetClientInfo(GfnClientInfo* clientInfo)
+{
+    GFN_COUNT_CALL(GetClientInfo);
+    GFN_SDK_LOG("Calling GfnGetClientInfo");
+    CHECK_NULL_PARAM(clientInfo);
+    GfnClientInfoSnapshot snapshot;
+    if (gfnReadClientInfo(&snapshot) && snapshot.hasInfo)
+    {
+        *clientInfo = snapshot.info;
+        return gfnSuccess;
+    }
+    clientInfo->version = GfnClientInfoVersion;
+    DELEGATE_TO_CLOUD_LIBRARY(GetClientInfo, clientInfo);
+}
+
+GfnRuntimeError GfnRegisterClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(clientInfoCallback);
+    RESOLVE_CLOUD_API(RegisterClientInfoCallback);
+    GFN_SDK_LOG("Registering for ClientInfo updates");
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventClientInfo, (void*)clientInfoCallback, pUserContext, NULL);
+}
+
+GfnRuntimeError GfnAddClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* pUserContext, GfnCallbackHandle* pHandle)
+{
+    CHECK_NULL_PARAM(clientInfoCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterClientInfoCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventClientInfo, (void*)clientInfoCallback, pUserContext, pHandle);
+}
+
+GfnRuntimeError GfnRegisterStreamStatusCallback(StreamStatusCallbackSig streamStatusCallback, void* userContext)
+{
+    CHECK_NULL_PARAM(streamStatusCallback);
+    RESOLVE_CLIENT_API(RegisterStreamStatusCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventStreamStatus, (void*)streamStatusCallback, userContext, NULL);
+}
+
+GfnRuntimeError GfnStartStream(StartStreamInput * startStreamInput, StartStreamResponse* response)
+{
+    GFN_COUNT_CALL(StartStream);
+    RESOLVE_CLIENT_API(StartStream);
+
+    GFN_BEGIN_LIBRARY_CALL();
+    GfnRuntimeError status = pDispatch->StartStream(startStreamInput, response);
+    GFN_END_LIBRARY_CALL(StartStream);
+    return status;
+}
+
+GfnRuntimeError GfnStartStreamAsync(const StartStreamInput* startStreamInput, StartStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+{
+    GFN_COUNT_CALL(StartStreamAsync);
+    RESOLVE_CLIENT_API(StartStreamAsync);
+
+    GFN_BEGIN_LIBRARY_CALL();
+    pDispatch->StartStreamAsync(startStreamInput, cb, context, timeoutMs);
+    GFN_END_LIBRARY_CALL(StartStreamAsync);
+
+    return gfnSuccess;
+}
+
+GfnRuntimeError GfnStopStream(void)
+{
+    GFN_COUNT_CALL(StopStream);
+    RESOLVE_CLIENT_API(StopStream);
+
+    GFN_BEGIN_LIBRARY_CALL();
+    GfnRuntimeError status = pDispatch->StopStream();
+    GFN_END_LIBRARY_CALL(StopStream);
+    return status;
+}
+
+GfnRuntimeError GfnStopStreamAsync(StopStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+{
+    GFN_COUNT_CALL(StopStreamAsync);
+    RESOLVE_CLIENT_API(StopStreamAsync);
+
+    GFN_BEGIN_LIBRARY_CALL();
+    pDispatch->StopStreamAsync(cb, context, timeoutMs);
+    GFN_END_LIBRARY_CALL(StopStreamAsync);
+
+    return gfnSuccess;
+}
+
+GfnRuntimeError GfnSetupTitle(const char* platformAppId)
+{
+    GFN_COUNT_CALL(SetupTitle);
+    CHECK_NULL_PARAM(platformAppId);
+    DELEGATE_TO_CLOUD_LIBRARY(SetupTitle, platformAppId);
+}
+
+GfnRuntimeError GfnTitleExited(const char* platformId, const char* platformAppId)
+{
+    GFN_COUNT_CALL(TitleExited);
+    RESOLVE_CLIENT_API(TitleExited);
+
+    GFN_BEGIN_LIBRARY_CALL();
+    GfnRuntimeError status = pDispatch->TitleExited(platformId, platformAppId);
+    GFN_END_LIBRARY_CALL(TitleExited);
+    return status;
+}
+
+GfnRuntimeError GfnAppReady(bool success, const char* status)
+{
+    GFN_COUNT_CALL(AppReady);
+    DELEGATE_TO_CLOUD_LIBRARY(AppReady, success, status);
+}
+
+GfnRuntimeError GfnSetActionZone(GfnActionType type, unsigned int id, GfnRect* zone)
+{
+    GFN_COUNT_CALL(SetActionZone);
+    DELEGATE_TO_CLOUD_LIBRARY(SetActionZone, type, id, zone);
+}
+
+
+GfnRuntimeError GfnRegisterExitCallback(ExitCallbackSig exitCallback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(exitCallback);
+    RESOLVE_CLOUD_API(RegisterExitCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventExit, (void*)exitCallback, pUserContext, NULL);
+}
+
+GfnRuntimeError GfnAddExitCallback(ExitCallbackSig exitCallback, void* pUserContext, GfnCallbackHandle* pHandle)
+{
+    CHECK_NULL_PARAM(exitCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterExitCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventExit, (void*)exitCallback, pUserContext, pHandle);
+}
+
+GfnRuntimeError GfnRegisterPauseCallback(PauseCallbackSig pauseCallback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(pauseCallback);
+    RESOLVE_CLOUD_API(RegisterPauseCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventPause, (void*)pauseCallback, pUserContext, NULL);
+}
+
+GfnRuntimeError GfnAddPauseCallback(PauseCallbackSig pauseCallback, void* pUserContext, GfnCallbackHandle* pHandle)
+{
+    CHECK_NULL_PARAM(pauseCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterPauseCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventPause, (void*)pauseCallback, pUserContext, pHandle);
+}
+
+GfnRuntimeError GfnRegisterInstallCallback(InstallCallbackSig installCallback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(installCallback);
+    RESOLVE_CLOUD_API(RegisterInstallCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventInstall, (void*)installCallback, pUserContext, NULL);
+}
+
+GfnRuntimeError GfnAddInstallCallback(InstallCallbackSig installCallback, void* pUserContext, GfnCallbackHandle* pHandle)
+{
+    CHECK_NULL_PARAM(installCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterInstallCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventInstall, (void*)installCallback, pUserContext, pHandle);
+}
+
+GfnRuntimeError GfnRegisterSaveCallback(SaveCallbackSig saveCallback, void* pUserContext)
+{
+    CHECK_NULL_PARAM(saveCallback);
+    RESOLVE_CLOUD_API(RegisterSaveCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventSave, (void*)saveCallback, pUserContext, NULL);
+}
 
-GfnRuntimeError GfnGetClientInfo(GfnClientInfo* clientInfo)
+GfnRuntimeError GfnAddSaveCallback(SaveCallbackSig saveCallback, void* pUserContext, GfnCallbackHandle* pHandle)
 {
-    GFN_SDK_LOG("Calling GfnGetClientInfo");
-    CHECK_NULL_PARAM(clientInfo);
-    CHECK_CLOUD_ENVIRONMENT();
-    clientInfo->version = GfnClientInfoVersion;
-    DELEGATE_TO_CLOUD_LIBRARY(GetClientInfo, clientInfo);
+    CHECK_NULL_PARAM(saveCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterSaveCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventSave, (void*)saveCallback, pUserContext, pHandle);
 }
 
-static void GFN_CALLBACK _gfnClientInfoCallbackWrapper(int status, void* updateData, void* pData)
+GfnRuntimeError GfnRegisterSessionInitCallback(SessionInitCallbackSig sessionInitCallback, void* pUserContext)
 {
-    (void)status;
-    GFN_SDK_LOG("ClientInfo update received");
+    CHECK_NULL_PARAM(sessionInitCallback);
+    RESOLVE_CLOUD_API(RegisterSessionInitCallback);
 
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pData);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
-    {
-        GFN_SDK_LOG("Wrapped context was null or had no callback. Ignoring");
-        return;
-    }
-    ClientInfoCallbackSig cb = (ClientInfoCallbackSig)(pWrappedContext->fnCallback);
-    if (cb == NULL)
-    {
-        GFN_SDK_LOG("Callback was NULL, ignoring");
-        return;
-    }
-    cb((GfnClientInfoUpdateData *)updateData, pWrappedContext->pOrigUserContext);
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventSessionInit, (void*)sessionInitCallback, pUserContext, NULL);
 }
 
-GfnRuntimeError GfnRegisterClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* pUserContext)
+GfnRuntimeError GfnAddSessionInitCallback(SessionInitCallbackSig sessionInitCallback, void* pUserContext, GfnCallbackHandle* pHandle)
 {
-    CHECK_NULL_PARAM(clientInfoCallback);
-    CHECK_CLOUD_ENVIRONMENT();
-    GFN_SDK_LOG("Registering for ClientInfo updates");
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)clientInfoCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
-    DELEGATE_TO_CLOUD_LIBRARY(RegisterClientInfoCallback, &_gfnClientInfoCallbackWrapper, (void*)(pWrappedContext));
+    CHECK_NULL_PARAM(sessionInitCallback);
+    CHECK_NULL_PARAM(pHandle);
+    RESOLVE_CLOUD_API(RegisterSessionInitCallback);
+
+    return gfnSubscribeCallback(pDispatch, gfnCallbackEventSessionInit, (void*)sessionInitCallback, pUserContext, pHandle);
 }
 
-GfnRuntimeError GfnRegisterStreamStatusCallback(StreamStatusCallbackSig streamStatusCallback, void* userContext)
+GfnRuntimeError GfnRemoveCallback(GfnCallbackHandle handle)
 {
-    if (g_gfnSdkModule == NULL)
+    GfnCallbackEvent event = (GfnCallbackEvent)(handle & ((1u << GFN_CALLBACK_EVENT_BITS) - 1));
+    if (handle == GFN_LEGACY_CALLBACK_HANDLE || event >= gfnCallbackEventCount)
     {
-        return gfnAPINotInit;
+        return gfnInvalidParameter;
     }
-
-    gfnRegisterStreamStatusCallbackFn fnRegisterStreamStatusCallback = (gfnRegisterStreamStatusCallbackFn)GetProcAddress(g_gfnSdkModule, "gfnRegisterStreamStatusCallback");
-
-    if (fnRegisterStreamStatusCallback == NULL)
+    if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized)
     {
-        return gfnAPINotFound;
+        return gfnAPINotInit;
     }
 
-    return fnRegisterStreamStatusCallback(streamStatusCallback, userContext);
+    // The trampoline stays registered with the library and simply finds one subscriber fewer
+    return gfnUpdateSubscribers(event, NULL, handle);
 }
 
-GfnRuntimeError GfnStartStream(StartStreamInput * startStreamInput, StartStreamResponse* response)
+GfnRuntimeError GfnSetCallbackDelivery(GfnCallbackDelivery delivery)
 {
-    if (g_gfnSdkModule == NULL)
+    if (delivery != gfnCallbackDeliveryImmediate && delivery != gfnCallbackDeliveryPolled &&
+        delivery != gfnCallbackDeliveryWrapperThread)
     {
-        return gfnAPINotInit;
+        return gfnInvalidParameter;
     }
 
-    gfnStartStreamFn fnGfnStartStream = (gfnStartStreamFn)GetProcAddress(g_gfnSdkModule, "gfnStartStream");
-
-    if (fnGfnStartStream == NULL)
+    AcquireSRWLockExclusive(&s_initLock);
+    GfnRuntimeError status = gfnSuccess;
+    LONG current = s_callbackDelivery;
+    if (s_wrapperState != gfnWrapperInitialized)
     {
-        return gfnAPINotFound;
+        status = gfnAPINotInit;
+    }
+    else if (current == gfnCallbackDeliveryWrapperThread && GetCurrentThreadId() == s_deliveryThreadId)
+    {
+        // Stopping the thread waits for it, which would never finish from here
+        status = gfnCallWrongEnvironment;
     }
+    else if (current != (LONG)delivery)
+    {
+        if (!s_eventQueueReady)
+        {
+            for (LONG i = 0; i < GFN_EVENT_QUEUE_SIZE; ++i)
+            {
+                s_eventQueue[i].sequence = i;
+            }
+            s_eventQueueReady = 1;
+        }
 
-    return fnGfnStartStream(startStreamInput, response);
+        // Events raised during the change are delivered right away, what was queued before it
+        // is delivered here so none is left behind for a mode that no longer dispatches
+        gfnStoreRelease(&s_callbackDelivery, gfnCallbackDeliveryImmediate);
+        gfnStopDeliveryThread();
+        if (delivery == gfnCallbackDeliveryWrapperThread)
+        {
+            status = gfnStartDeliveryThread();
+        }
+        while (gfnDispatchQueuedEvents(0, true) != 0)
+        {
+        }
+        if (GFNSDK_SUCCEEDED(status))
+        {
+            gfnStoreRelease(&s_callbackDelivery, delivery);
+            if (delivery == gfnCallbackDeliveryWrapperThread)
+            {
+                SetEvent(s_deliveryWake);
+            }
+            GFN_SDK_LOG("Callback delivery set to %d", delivery);
+        }
+    }
+    ReleaseSRWLockExclusive(&s_initLock);
+    return status;
 }
 
-GfnRuntimeError GfnStartStreamAsync(const StartStreamInput* startStreamInput, StartStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+GfnRuntimeError GfnDispatchCallbacks(unsigned int maxCallbacks, unsigned int* dispatched)
 {
-    if (g_gfnSdkModule == NULL)
+    unsigned int count = 0;
+    if (gfnLoadAcquire(&s_wrapperState) != gfnWrapperInitialized)
     {
         return gfnAPINotInit;
     }
-
-    gfnStartStreamAsyncFn fnGfnStartStreamAsync = (gfnStartStreamAsyncFn)GetProcAddress(g_gfnSdkModule, "gfnStartStreamAsync");
-
-    if (fnGfnStartStreamAsync == NULL)
+    if (gfnLoadAcquire(&s_eventQueueReady))
     {
-        return gfnAPINotFound;
+        count = gfnDispatchQueuedEvents(maxCallbacks, true);
     }
+    if (dispatched != NULL)
+    {
+        *dispatched = count;
+    }
+    return gfnSuccess;
+}
 
-    fnGfnStartStreamAsync(startStreamInput, cb, context, timeoutMs);
-
+GfnRuntimeError GfnGetCallbackDeliveryStats(GfnCallbackDeliveryStats* stats)
+{
+    CHECK_NULL_PARAM(stats);
+    stats->queued = (unsigned long long)gfnReadCounter(&s_deliveryCounters.queued);
+    stats->delivered = (unsigned long long)gfnReadCounter(&s_deliveryCounters.delivered);
+    stats->coalesced = (unsigned long long)gfnReadCounter(&s_deliveryCounters.coalesced);
+    stats->overflowed = (unsigned long long)gfnReadCounter(&s_deliveryCounters.overflowed);
+    stats->lastLatencyUs = (unsigned long long)gfnReadCounter(&s_deliveryCounters.lastLatencyUs);
+    stats->maxLatencyUs = (unsigned long long)gfnReadCounter(&s_deliveryCounters.maxLatencyUs);
+    stats->totalLatencyUs = (unsigned long long)gfnReadCounter(&s_deliveryCounters.totalLatencyUs);
     return gfnSuccess;
 }
 
-GfnRuntimeError GfnStopStream(void)
+GfnRuntimeError GfnGetWrapperStats(GfnWrapperStats* stats)
 {
-    if (g_gfnSdkModule == NULL)
-    {
-        return gfnAPINotInit;
-    }
+    CHECK_NULL_PARAM(stats);
+#ifndef GFN_SDK_WRAPPER_NO_STATS
+    gfnSumWrapperStats(stats);
+    return gfnSuccess;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return gfnUnsupportedAPICall;
+#endif
+}
 
-    gfnStopStreamFn fnGfnStopStream = (gfnStopStreamFn)GetProcAddress(g_gfnSdkModule, "gfnStopStream");
 
-    if (fnGfnStopStream == NULL)
-    {
-        return gfnAPINotFound;
-    }
+#ifdef GFN_SDK_WRAPPER_LOG
+#define GFN_LOG_QUEUE_SIZE 128          // must be a power of two
+#define GFN_LOG_MAX_ARGS 8
+#define GFN_LOG_PAYLOAD_SIZE 256        // copied string arguments or preformatted text
+#define GFN_LOG_LINE_SIZE 1024
+#define GFN_LOG_FLUSH_INTERVAL_MS 100
 
-    return fnGfnStopStream();
+typedef enum gfnLogArgType
+{
+    gfnLogArgNone,          // "%%", consumes nothing
+    gfnLogArgInt,
+    gfnLogArgLong,
+    gfnLogArgLongLong,
+    gfnLogArgSizeT,
+    gfnLogArgDouble,
+    gfnLogArgPointer,
+    gfnLogArgString,
+    gfnLogArgUnsupported    // '*' width, wide strings, %n: formatted on the calling thread instead
+} gfnLogArgType;
+
+typedef struct gfnLogArg
+{
+    gfnLogArgType type;
+    union
+    {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        double d;
+        const void* p;
+        unsigned int offset;  // gfnLogArgString, offset of the copy in the record payload
+    } value;
+} gfnLogArg;
+
+typedef struct gfnLogRecord
+{
+    volatile LONG sequence;
+    gfnLogLevel level;
+    int line;
+    DWORD threadId;
+    FILETIME time;
+    const char* func;
+    const char* format;     // NULL when the payload already holds the formatted message
+    unsigned int argCount;
+    gfnLogArg args[GFN_LOG_MAX_ARGS];
+    unsigned int payloadUsed;
+    char payload[GFN_LOG_PAYLOAD_SIZE];
+} gfnLogRecord;
+
+typedef struct gfnLogSpec
+{
+    const char* start;
+    const char* end;
+    gfnLogArgType type;
+} gfnLogSpec;
+
+// Bounded multi-producer queue (D. Vyukov), drained only by the writer thread
+static gfnLogRecord s_logQueue[GFN_LOG_QUEUE_SIZE];
+static volatile LONG s_logEnqueuePos = 0;
+static LONG s_logDequeuePos = 0;
+static volatile LONG s_logDropped = 0;
+static volatile LONG s_logRunning = 0;
+static volatile LONG s_logStopping = 0;
+static HANDLE s_logWake = NULL;
+static HANDLE s_logWriter = NULL;
+static DWORD s_logStatsIntervalMs = 0;  // 0 - statistics are not logged
+
+// Used on the calling thread when a record has to be formatted synchronously
+static __declspec(thread) char t_logFormatBuffer[GFN_LOG_LINE_SIZE];
+// Only touched by the writer thread
+static char s_logBatch[GFN_LOG_QUEUE_SIZE * 2 * GFN_LOG_PAYLOAD_SIZE];
+static char s_logLine[GFN_LOG_LINE_SIZE];
+
+// _snprintf_s with _TRUNCATE returns -1 when the output was cut
+static size_t gfnLogPrinted(int result, const char* out)
+{
+    return result < 0 ? strlen(out) : (size_t)result;
 }
 
-GfnRuntimeError GfnStopStreamAsync(StopStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+// Finds the next conversion in the format string, returns false when there is none.
+static bool gfnLogNextSpec(const char* p, gfnLogSpec* spec)
 {
-    if (g_gfnSdkModule == NULL)
+    int size = 0; // 0 - int, 1 - long, 2 - long long, 3 - size_t
+    bool wide = false;
+
+    p = strchr(p, '%');
+    if (p == NULL)
     {
-        return gfnAPINotInit;
+        return false;
     }
+    spec->start = p++;
 
-    gfnStopStreamAsyncFn fnGfnStopStreamAsync = (gfnStopStreamAsyncFn)GetProcAddress(g_gfnSdkModule, "gfnStopStreamAsync");
+    if (*p == '%')
+    {
+        spec->end = p + 1;
+        spec->type = gfnLogArgNone;
+        return true;
+    }
 
-    if (fnGfnStopStreamAsync == NULL)
+    p += strspn(p, "-+ #0123456789.");
+    if (*p == '*')
     {
-        return gfnAPINotFound;
+        spec->end = p + 1;
+        spec->type = gfnLogArgUnsupported;
+        return true;
     }
 
-    fnGfnStopStreamAsync(cb, context, timeoutMs);
+    if (p[0] == 'h')
+    {
+        p += (p[1] == 'h') ? 2 : 1;
+    }
+    else if (p[0] == 'l')
+    {
+        size = (p[1] == 'l') ? 2 : 1;
+        p += size;
+        wide = (size == 1);
+    }
+    else if (p[0] == 'I' && p[1] == '6' && p[2] == '4')
+    {
+        size = 2;
+        p += 3;
+    }
+    else if (p[0] == 'I' && p[1] == '3' && p[2] == '2')
+    {
+        p += 3;
+    }
+    else if (p[0] == 'z' || p[0] == 'I')
+    {
+        size = 3;
+        p += 1;
+    }
+    else if (p[0] == 'L')
+    {
+        p += 1;
+    }
 
-    return gfnSuccess;
+    spec->end = (*p != '\0') ? p + 1 : p;
+    switch (*p)
+    {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+        spec->type = size == 0 ? gfnLogArgInt : size == 1 ? gfnLogArgLong : size == 2 ? gfnLogArgLongLong : gfnLogArgSizeT;
+        break;
+    case 'c':
+        spec->type = gfnLogArgInt;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec->type = gfnLogArgDouble;
+        break;
+    case 'p':
+        spec->type = gfnLogArgPointer;
+        break;
+    case 's':
+        spec->type = wide ? gfnLogArgUnsupported : gfnLogArgString;
+        break;
+    default:
+        spec->type = gfnLogArgUnsupported;
+        break;
+    }
+    return true;
 }
 
-GfnRuntimeError GfnSetupTitle(const char* platformAppId)
+// Copies the arguments into the record, false if the record has to be formatted right away
+static bool gfnLogCapture(gfnLogRecord* record, const char* format, va_list args)
 {
-    CHECK_NULL_PARAM(platformAppId);
-    CHECK_CLOUD_ENVIRONMENT();
-    DELEGATE_TO_CLOUD_LIBRARY(SetupTitle, platformAppId);
-}
+    gfnLogSpec spec;
+    const char* p = format;
 
-GfnRuntimeError GfnTitleExited(const char* platformId, const char* platformAppId)
-{
-    if (g_gfnSdkModule == NULL)
+    record->argCount = 0;
+    record->payloadUsed = 0;
+    while (gfnLogNextSpec(p, &spec))
     {
-        return gfnAPINotInit;
+        gfnLogArg* arg = &record->args[record->argCount];
+        p = spec.end;
+        if (spec.type == gfnLogArgNone)
+        {
+            continue;
+        }
+        if (spec.type == gfnLogArgUnsupported || record->argCount == GFN_LOG_MAX_ARGS)
+        {
+            return false;
+        }
+
+        arg->type = spec.type;
+        switch (spec.type)
+        {
+        case gfnLogArgInt: arg->value.i = va_arg(args, int); break;
+        case gfnLogArgLong: arg->value.l = va_arg(args, long); break;
+        case gfnLogArgLongLong: arg->value.ll = va_arg(args, long long); break;
+        case gfnLogArgSizeT: arg->value.z = va_arg(args, size_t); break;
+        case gfnLogArgDouble: arg->value.d = va_arg(args, double); break;
+        case gfnLogArgPointer: arg->value.p = va_arg(args, const void*); break;
+        case gfnLogArgString:
+        {
+            const char* str = va_arg(args, const char*);
+            size_t length;
+            if (str == NULL)
+            {
+                str = "(null)";
+            }
+            length = strlen(str);
+            if (length >= GFN_LOG_PAYLOAD_SIZE - record->payloadUsed)
+            {
+                return false;
+            }
+            memcpy(record->payload + record->payloadUsed, str, length + 1);
+            arg->value.offset = record->payloadUsed;
+            record->payloadUsed += (unsigned int)(length + 1);
+            break;
+        }
+        default:
+            return false;
+        }
+        ++record->argCount;
     }
+    return true;
+}
 
-    gfnTitleExitedFn fnTitleExited = (gfnTitleExitedFn)GetProcAddress(g_gfnSdkModule, "gfnTitleExited");
+static size_t gfnLogFormatMessage(const gfnLogRecord* record, char* out, size_t size)
+{
+    gfnLogSpec spec;
+    const char* p = record->format;
+    unsigned int argIndex = 0;
+    size_t n = 0;
+    char specBuffer[32];
 
-    if (fnTitleExited == NULL)
+    if (record->format == NULL)
     {
-        return gfnAPINotFound;
+        return gfnLogPrinted(_snprintf_s(out, size, _TRUNCATE, "%s", record->payload), out);
     }
 
-    return fnTitleExited(platformId, platformAppId);
-}
+    while (n < size - 1)
+    {
+        const char* literalEnd;
+        size_t literalLength;
+        bool found = gfnLogNextSpec(p, &spec);
+        int written = 0;
 
-GfnRuntimeError GfnAppReady(bool success, const char* status)
-{
-    CHECK_CLOUD_ENVIRONMENT();
-    DELEGATE_TO_CLOUD_LIBRARY(AppReady, success, status);
-}
+        literalEnd = found ? spec.start : p + strlen(p);
+        literalLength = (size_t)(literalEnd - p);
+        if (literalLength > size - 1 - n)
+        {
+            literalLength = size - 1 - n;
+        }
+        memcpy(out + n, p, literalLength);
+        n += literalLength;
+        if (!found || n >= size - 1)
+        {
+            break;
+        }
+        p = spec.end;
 
-GfnRuntimeError GfnSetActionZone(GfnActionType type, unsigned int id, GfnRect* zone)
-{
-    CHECK_CLOUD_ENVIRONMENT();
-    DELEGATE_TO_CLOUD_LIBRARY(SetActionZone, type, id, zone);
-}
+        if (spec.type == gfnLogArgNone)
+        {
+            out[n++] = '%';
+            continue;
+        }
+        if (argIndex >= record->argCount || (size_t)(spec.end - spec.start) >= sizeof(specBuffer))
+        {
+            break;
+        }
 
+        memcpy(specBuffer, spec.start, spec.end - spec.start);
+        specBuffer[spec.end - spec.start] = '\0';
 
-static void GFN_CALLBACK _gfnExitCallbackWrapper(int status, void* pUnused, void* pContext)
-{
-    (void)status;
-    (void)pUnused;
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pContext);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
-    {
-        return;
+        {
+            const gfnLogArg* arg = &record->args[argIndex++];
+            switch (arg->type)
+            {
+            case gfnLogArgInt: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.i); break;
+            case gfnLogArgLong: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.l); break;
+            case gfnLogArgLongLong: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.ll); break;
+            case gfnLogArgSizeT: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.z); break;
+            case gfnLogArgDouble: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.d); break;
+            case gfnLogArgPointer: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, arg->value.p); break;
+            case gfnLogArgString: written = _snprintf_s(out + n, size - n, _TRUNCATE, specBuffer, record->payload + arg->value.offset); break;
+            default: break;
+            }
+        }
+        n = (written < 0) ? size - 1 : n + (size_t)written;
     }
-    ExitCallbackSig cb = (ExitCallbackSig)(pWrappedContext->fnCallback);
-    cb(pWrappedContext->pOrigUserContext);
+    out[n] = '\0';
+    return n;
 }
 
-GfnRuntimeError GfnRegisterExitCallback(ExitCallbackSig exitCallback, void* pUserContext)
+static size_t gfnLogFormatLine(const gfnLogRecord* record, char* out, size_t size)
 {
-    CHECK_NULL_PARAM(exitCallback);
-    CHECK_CLOUD_ENVIRONMENT();
-
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)exitCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
-
-    DELEGATE_TO_CLOUD_LIBRARY(RegisterExitCallback, &_gfnExitCallbackWrapper, pWrappedContext);
+    FILETIME localTime;
+    SYSTEMTIME time;
+    size_t n;
+
+    FileTimeToLocalFileTime(&record->time, &localTime);
+    FileTimeToSystemTime(&localTime, &time);
+
+    // Same layout as before: date and time, function, line number, message
+    n = gfnLogPrinted(_snprintf_s(out, size, _TRUNCATE, "%04d-%02d-%02dT%02d:%02d:%02d.%03d %24.24s:%-5d ",
+        time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, time.wMilliseconds,
+        record->func, record->line), out);
+    n += gfnLogFormatMessage(record, out + n, size - n - 1);
+    out[n++] = '\n';
+    out[n] = '\0';
+    return n;
 }
 
-static void GFN_CALLBACK _gfnPauseCallbackWrapper(int status, void* pUnused, void* pContext)
+static void gfnLogDrain(void)
 {
-    (void)status;
-    (void)pUnused;
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pContext);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
+    FILE* sink = s_logfile ? s_logfile : stderr;
+    size_t batchUsed = 0;
+    LONG dropped;
+
+    for (;;)
     {
-        return;
-    }
-    PauseCallbackSig cb = (PauseCallbackSig)(pWrappedContext->fnCallback);
-    cb(pWrappedContext->pOrigUserContext);
-}
+        gfnLogRecord* record = &s_logQueue[s_logDequeuePos & (GFN_LOG_QUEUE_SIZE - 1)];
+        size_t length;
+        if (gfnLoadAcquire(&record->sequence) != s_logDequeuePos + 1)
+        {
+            break;
+        }
 
-GfnRuntimeError GfnRegisterPauseCallback(PauseCallbackSig pauseCallback, void* pUserContext)
-{
-    CHECK_NULL_PARAM(pauseCallback);
-    CHECK_CLOUD_ENVIRONMENT();
+        length = gfnLogFormatLine(record, s_logLine, sizeof(s_logLine));
+        gfnStoreRelease(&record->sequence, s_logDequeuePos + GFN_LOG_QUEUE_SIZE);
+        ++s_logDequeuePos;
 
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)pauseCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
+        if (batchUsed + length > sizeof(s_logBatch))
+        {
+            fwrite(s_logBatch, 1, batchUsed, sink);
+            batchUsed = 0;
+        }
+        memcpy(s_logBatch + batchUsed, s_logLine, length);
+        batchUsed += length;
+    }
 
-    DELEGATE_TO_CLOUD_LIBRARY(RegisterPauseCallback, &_gfnPauseCallbackWrapper, pWrappedContext);
-}
+    dropped = InterlockedExchange(&s_logDropped, 0);
+    if (dropped != 0)
+    {
+        int n = _snprintf_s(s_logLine, sizeof(s_logLine), _TRUNCATE, "Log queue overflow, %ld records dropped\n", dropped);
+        if (n > 0 && batchUsed + (size_t)n <= sizeof(s_logBatch))
+        {
+            memcpy(s_logBatch + batchUsed, s_logLine, n);
+            batchUsed += n;
+        }
+    }
 
-static void GFN_CALLBACK _gfnInstallCallbackWrapper(int status, void* pTitleInstallationInformation, void* pContext)
-{
-    (void)status;
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pContext);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
+    if (batchUsed != 0)
     {
-        return;
+        fwrite(s_logBatch, 1, batchUsed, sink);
+        fflush(sink);
     }
-    InstallCallbackSig cb = (InstallCallbackSig)(pWrappedContext->fnCallback);
-    cb((TitleInstallationInformation*)pTitleInstallationInformation, pWrappedContext->pOrigUserContext);
 }
 
-GfnRuntimeError GfnRegisterInstallCallback(InstallCallbackSig installCallback, void* pUserContext)
+static DWORD WINAPI gfnLogWriterThread(LPVOID unused)
 {
-    CHECK_NULL_PARAM(installCallback);
-    CHECK_CLOUD_ENVIRONMENT();
-
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)installCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
-
-    DELEGATE_TO_CLOUD_LIBRARY(RegisterInstallCallback, &_gfnInstallCallbackWrapper, pWrappedContext);
+    UNREFERENCED_PARAMETER(unused);
+#ifndef GFN_SDK_WRAPPER_NO_STATS
+    ULONGLONG statsLoggedAt = GetTickCount64();
+#endif
+    while (!gfnLoadAcquire(&s_logStopping))
+    {
+        WaitForSingleObject(s_logWake, GFN_LOG_FLUSH_INTERVAL_MS);
+#ifndef GFN_SDK_WRAPPER_NO_STATS
+        if (s_logStatsIntervalMs != 0 && GetTickCount64() - statsLoggedAt >= s_logStatsIntervalMs)
+        {
+            gfnLogWrapperStats();
+            statsLoggedAt = GetTickCount64();
+        }
+#endif
+        gfnLogDrain();
+    }
+    gfnLogDrain();
+    return 0;
 }
 
-static void GFN_CALLBACK _gfnSaveCallbackWrapper(int status, void* pUnused, void* pContext)
+// GFN_SDK_WRAPPER_STATS_INTERVAL holds the number of seconds between dumps of the API statistics
+static void gfnLogReadStatsInterval(void)
 {
-    (void)status;
-    (void)pUnused;
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pContext);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
+    char value[16] = { 0 };
+    DWORD length = GetEnvironmentVariableA("GFN_SDK_WRAPPER_STATS_INTERVAL", value, sizeof(value));
+    if (length == 0 || length >= sizeof(value))
     {
         return;
     }
-    SaveCallbackSig cb = (SaveCallbackSig)(pWrappedContext->fnCallback);
-    cb(pWrappedContext->pOrigUserContext);
-}
-
-GfnRuntimeError GfnRegisterSaveCallback(SaveCallbackSig saveCallback, void* pUserContext)
-{
-    CHECK_NULL_PARAM(saveCallback);
-    CHECK_CLOUD_ENVIRONMENT();
-
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)saveCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
-
-    DELEGATE_TO_CLOUD_LIBRARY(RegisterSaveCallback, &_gfnSaveCallbackWrapper, pWrappedContext);
+    s_logStatsIntervalMs = strtoul(value, NULL, 10) * 1000;
 }
 
-static void GFN_CALLBACK _gfnSessionInitCallbackWrapper(int status, void* pCString, void* pContext)
+static void gfnLogReadLevel(void)
 {
-    (void)status;
-    _gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)(pContext);
-    if (pWrappedContext == NULL || pWrappedContext->fnCallback == NULL)
+    char value[16] = { 0 };
+    DWORD length = GetEnvironmentVariableA("GFN_SDK_WRAPPER_LOG_LEVEL", value, sizeof(value));
+    if (length == 0 || length >= sizeof(value))
     {
         return;
     }
-    SessionInitCallbackSig cb = (SessionInitCallbackSig)(pWrappedContext->fnCallback);
-    cb((const char *)pCString, pWrappedContext->pOrigUserContext);
-}
-
-GfnRuntimeError GfnRegisterSessionInitCallback(SessionInitCallbackSig sessionInitCallback, void* pUserContext)
-{
-	CHECK_NULL_PARAM(sessionInitCallback);
-    CHECK_CLOUD_ENVIRONMENT();
-	_gfnUserContextCallbackWrapper* pWrappedContext = (_gfnUserContextCallbackWrapper*)malloc(sizeof(_gfnUserContextCallbackWrapper));
-    pWrappedContext->fnCallback = (void*)sessionInitCallback;
-    pWrappedContext->pOrigUserContext = pUserContext;
 
-	DELEGATE_TO_CLOUD_LIBRARY(RegisterSessionInitCallback, &_gfnSessionInitCallbackWrapper, pWrappedContext)
+    if (_stricmp(value, "verbose") == 0)
+    {
+        s_logLevel = gfnLogLevelVerbose;
+    }
+    else if (_stricmp(value, "info") == 0)
+    {
+        s_logLevel = gfnLogLevelInfo;
+    }
+    else if (_stricmp(value, "error") == 0)
+    {
+        s_logLevel = gfnLogLevelError;
+    }
+    else if (_stricmp(value, "none") == 0)
+    {
+        s_logLevel = gfnLogLevelNone;
+    }
 }
 
-
-#ifdef GFN_SDK_WRAPPER_LOG
 void gfnInitLogging()
 {
     wchar_t localAppDataPath[1024] = { L"" };
+
+    gfnLogReadLevel();
+    gfnLogReadStatsInterval();
+
     if (SHGetSpecialFolderPathW(NULL, localAppDataPath, CSIDL_COMMON_APPDATA, false) == FALSE)
     {
-        GFN_SDK_LOG("Could not get path to LOCALAPPDATA: %d", GetLastError());
+        GFN_SDK_LOG_ERROR("Could not get path to LOCALAPPDATA: %d", GetLastError());
         return;
     }
     wcscat_s(localAppDataPath, 1024, L"\\NVIDIA Corporation\\GfnRuntimeSdk");
@@ -1041,10 +3634,43 @@ void gfnInitLogging()
     }
     wcscat_s(localAppDataPath, 1024, L"\\GfnRuntimeSdkWrapper.log");
     _wfopen_s(&s_logfile, localAppDataPath, L"w+");
+
+    for (LONG i = 0; i < GFN_LOG_QUEUE_SIZE; ++i)
+    {
+        s_logQueue[i].sequence = i;
+    }
+    s_logEnqueuePos = 0;
+    s_logDequeuePos = 0;
+    s_logStopping = 0;
+    s_logWake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    s_logWriter = s_logWake ? CreateThread(NULL, 0, gfnLogWriterThread, NULL, 0, NULL) : NULL;
+    if (s_logWriter == NULL)
+    {
+        // Keep logging synchronously
+        if (s_logWake)
+        {
+            CloseHandle(s_logWake);
+            s_logWake = NULL;
+        }
+        return;
+    }
+    gfnStoreRelease(&s_logRunning, 1);
 }
 
 void gfnDeinitLogging()
 {
+    if (s_logWriter)
+    {
+        gfnStoreRelease(&s_logRunning, 0);
+        gfnStoreRelease(&s_logStopping, 1);
+        SetEvent(s_logWake);
+        WaitForSingleObject(s_logWriter, INFINITE);
+        CloseHandle(s_logWriter);
+        CloseHandle(s_logWake);
+        s_logWriter = NULL;
+        s_logWake = NULL;
+    }
+
     if (s_logfile)
     {
         fclose(s_logfile);
@@ -1052,38 +3678,105 @@ void gfnDeinitLogging()
     }
 }
 
-void gfnLog(char const* func, int line, char const* format, ...)
+// Formats on the calling thread and writes directly, used before the writer thread runs
+static void gfnLogSync(char const* func, int line, char const* format, va_list args)
 {
-    va_list args;
-    va_start(args, format);
+    SYSTEMTIME time;
+    size_t n;
+
+    GetLocalTime(&time);
+    n = gfnLogPrinted(_snprintf_s(t_logFormatBuffer, sizeof(t_logFormatBuffer), _TRUNCATE, "%04d-%02d-%02dT%02d:%02d:%02d.%03d %24.24s:%-5d ",
+        time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, time.wMilliseconds, func, line), t_logFormatBuffer);
+    if (vsnprintf(t_logFormatBuffer + n, sizeof(t_logFormatBuffer) - n - 1, format, args) < 0)
+    {
+        t_logFormatBuffer[n] = '\0';
+    }
+    t_logFormatBuffer[sizeof(t_logFormatBuffer) - 2] = '\0';
+    strcat_s(t_logFormatBuffer, sizeof(t_logFormatBuffer), "\n");
 
-    // Format date and time
-    GetLocalTime(&s_logData.timeBuffer);
-    size_t n = sprintf_s(s_logData.buffer, 24, "%04d-%02d-%02dT%02d:%02d:%02d.%03d", s_logData.timeBuffer.wYear, s_logData.timeBuffer.wMonth, s_logData.timeBuffer.wDay,
-        s_logData.timeBuffer.wHour, s_logData.timeBuffer.wMinute, s_logData.timeBuffer.wSecond, s_logData.timeBuffer.wMilliseconds);
+    // Never pass the message as a format string, it may contain '%'
+    fputs(t_logFormatBuffer, s_logfile ? s_logfile : stderr);
+    fflush(s_logfile ? s_logfile : stderr);
+}
 
-    // Format function, line number
-    n += _snprintf_s(s_logData.buffer + n, kGfnLogBufLen - n, kGfnLogBufLen - n, " %24.24s:%-5d", func, line);
+void gfnLog(gfnLogLevel level, char const* func, int line, char const* format, ...)
+{
+    gfnLogRecord* record = NULL;
+    va_list args;
+    va_list argsCopy;
+    LONG pos;
 
-    // Format the actual message/format
-    n += vsnprintf(s_logData.buffer + n, kGfnLogBufLen - n - 2, format, args); // -1 leave room for linebreak and terminator
-    if (kGfnLogBufLen - 2 < n)  // returns amount it WOULD have written if buffer were big enough
+    va_start(args, format);
+    if (!gfnLoadAcquire(&s_logRunning))
     {
-        n = kGfnLogBufLen - 2;
+        gfnLogSync(func, line, format, args);
+        va_end(args);
+        return;
     }
-    _snprintf_s(s_logData.buffer + n, kGfnLogBufLen - n, kGfnLogBufLen - n, "\n"); // Add linebreak at end
 
-    if (s_logfile)
+    // Claim a slot, a full queue drops the record instead of blocking the caller
+    pos = gfnLoadAcquire(&s_logEnqueuePos);
+    for (;;)
     {
-        fprintf(s_logfile, s_logData.buffer);
-        fflush(s_logfile);
+        gfnLogRecord* candidate = &s_logQueue[pos & (GFN_LOG_QUEUE_SIZE - 1)];
+        LONG diff = gfnLoadAcquire(&candidate->sequence) - pos;
+        if (diff == 0)
+        {
+            LONG previous = InterlockedCompareExchange(&s_logEnqueuePos, pos + 1, pos);
+            if (previous == pos)
+            {
+                record = candidate;
+                break;
+            }
+            pos = previous;
+        }
+        else if (diff < 0)
+        {
+            // Errors are worth the wait, everything else is only counted
+            if (level >= gfnLogLevelError)
+            {
+                gfnLogSync(func, line, format, args);
+            }
+            else
+            {
+                InterlockedIncrement(&s_logDropped);
+            }
+            va_end(args);
+            return;
+        }
+        else
+        {
+            pos = gfnLoadAcquire(&s_logEnqueuePos);
+        }
     }
-    else
+
+    record->level = level;
+    record->line = line;
+    record->threadId = GetCurrentThreadId();
+    record->func = func;
+    GetSystemTimeAsFileTime(&record->time);
+
+    va_copy(argsCopy, args);
+    record->format = format;
+    if (!gfnLogCapture(record, format, argsCopy))
     {
-        fprintf(stderr, s_logData.buffer);
-        fflush(stderr);
+        // Needs the real arguments, format here into the calling thread's buffer
+        if (vsnprintf(t_logFormatBuffer, sizeof(t_logFormatBuffer), format, args) < 0)
+        {
+            t_logFormatBuffer[0] = '\0';
+        }
+        strncpy_s(record->payload, sizeof(record->payload), t_logFormatBuffer, _TRUNCATE);
+        record->format = NULL;
+        record->argCount = 0;
     }
+    va_end(argsCopy);
     va_end(args);
+
+    gfnStoreRelease(&record->sequence, pos + 1);
+    if (level >= gfnLogLevelError || (pos & (GFN_LOG_QUEUE_SIZE / 2 - 1)) == 0)
+    {
+        SetEvent(s_logWake);
+    }
 }
 
 #endif // GFN_SDK_WRAPPER_LOG
@@ -64,6 +64,12 @@
 ///
 /// Language | API
 /// -------- | -------------------------------------
+/// C        | @ref GfnInitializeSdkAsync
+///
+/// @copydoc GfnInitializeSdkAsync
+///
+/// Language | API
+/// -------- | -------------------------------------
 /// C        | @ref GfnShutdownSdk
 ///
 /// @copydoc GfnShutdownSdk
@@ -82,6 +88,12 @@
 ///
 /// Language | API
 /// -------- | -------------------------------------
+/// C        | @ref GfnIsRunningInCloudSecureEx
+///
+/// @copydoc GfnIsRunningInCloudSecureEx
+///
+/// Language | API
+/// -------- | -------------------------------------
 /// C        | @ref GfnFree
 ///
 /// @copydoc GfnFree
@@ -124,12 +136,66 @@
 ///
 /// Language | API
 /// -------- | -------------------------------------
+/// C        | @ref GfnGetClientIpV4ToBuffer
+///
+/// @copydoc GfnGetClientIpV4ToBuffer
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetClientLanguageCodeToBuffer
+///
+/// @copydoc GfnGetClientLanguageCodeToBuffer
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetCustomDataToBuffer
+///
+/// @copydoc GfnGetCustomDataToBuffer
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetAuthDataToBuffer
+///
+/// @copydoc GfnGetAuthDataToBuffer
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetTitlesAvailableToBuffer
+///
+/// @copydoc GfnGetTitlesAvailableToBuffer
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnAreTitlesAvailable
+///
+/// @copydoc GfnAreTitlesAvailable
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnRefreshTitlesAvailable
+///
+/// @copydoc GfnRefreshTitlesAvailable
+///
+/// Language | API
+/// -------- | -------------------------------------
 /// C        | @ref GfnGetClientInfo
 ///
 /// @copydoc GfnGetClientInfo
 ///
 /// Language | API
 /// -------- | -------------------------------------
+/// C        | @ref GfnGetSessionSnapshot
+///
+/// @copydoc GfnGetSessionSnapshot
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnFreeSessionSnapshot
+///
+/// @copydoc GfnFreeSessionSnapshot
+///
+/// Language | API
+/// -------- | -------------------------------------
 /// C        | @ref GfnRegisterStreamStatusCallback
 ///
 /// @copydoc GfnRegisterStreamStatusCallback
@@ -205,6 +271,43 @@
 /// C        | @ref GfnRegisterClientInfoCallback
 ///
 /// @copydoc GfnRegisterClientInfoCallback
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnAddExitCallback, @ref GfnAddPauseCallback, @ref GfnAddInstallCallback,
+///          | @ref GfnAddSaveCallback, @ref GfnAddSessionInitCallback, @ref GfnAddClientInfoCallback
+///
+/// @copydoc GfnAddExitCallback
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnRemoveCallback
+///
+/// @copydoc GfnRemoveCallback
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnSetCallbackDelivery
+///
+/// @copydoc GfnSetCallbackDelivery
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnDispatchCallbacks
+///
+/// @copydoc GfnDispatchCallbacks
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetCallbackDeliveryStats
+///
+/// @copydoc GfnGetCallbackDeliveryStats
+///
+/// Language | API
+/// -------- | -------------------------------------
+/// C        | @ref GfnGetWrapperStats
+///
+/// @copydoc GfnGetWrapperStats
 
 #include "GfnRuntimeSdk_CAPI.h"
 
@@ -217,6 +320,91 @@ extern HMODULE g_gfnSdkModule;
 extern "C"
 {
 #endif
+    /// @brief Identifies a callback added with one of the GfnAdd*Callback functions, pass it to
+    /// @ref GfnRemoveCallback to remove the callback again. Zero is never a valid handle.
+    typedef unsigned int GfnCallbackHandle;
+
+    /// @brief Completion callback for @ref GfnInitializeSdkAsync, receives what @ref GfnInitializeSdk returned
+    typedef void(GFN_CALLBACK* GfnInitializeSdkCallbackSig)(GfnRuntimeError status, void* pUserContext);
+
+    /// @brief Where application callbacks run, see @ref GfnSetCallbackDelivery
+    typedef enum GfnCallbackDelivery
+    {
+        gfnCallbackDeliveryImmediate = 0,   ///< On the SDK thread that raised the event, the default
+        gfnCallbackDeliveryPolled,          ///< Queued until the application calls @ref GfnDispatchCallbacks
+        gfnCallbackDeliveryWrapperThread    ///< Queued and delivered from a thread owned by the wrapper
+    } GfnCallbackDelivery;
+
+    /// @brief Queued callback delivery counters, see @ref GfnGetCallbackDeliveryStats
+    typedef struct GfnCallbackDeliveryStats
+    {
+        unsigned long long queued;          ///< Events put on the queue
+        unsigned long long delivered;       ///< Queued events handed to application callbacks
+        unsigned long long coalesced;       ///< Updates merged into one that was still queued
+        unsigned long long overflowed;      ///< Events delivered on the SDK thread because the queue was full
+        unsigned long long lastLatencyUs;   ///< Time the last delivered event spent queued, in microseconds
+        unsigned long long maxLatencyUs;    ///< Longest time an event spent queued, in microseconds
+        unsigned long long totalLatencyUs;  ///< Sum of the time all delivered events spent queued, in microseconds
+    } GfnCallbackDeliveryStats;
+
+    /// @brief APIs tracked by @ref GfnGetWrapperStats
+    typedef enum GfnWrapperApi
+    {
+        gfnWrapperApiGetClientIp = 0,       ///< @ref GfnGetClientIpV4
+        gfnWrapperApiGetClientLanguageCode, ///< @ref GfnGetClientLanguageCode
+        gfnWrapperApiGetClientCountryCode,  ///< @ref GfnGetClientCountryCode
+        gfnWrapperApiGetClientInfo,         ///< @ref GfnGetClientInfo
+        gfnWrapperApiGetCustomData,         ///< @ref GfnGetCustomData
+        gfnWrapperApiGetAuthData,           ///< @ref GfnGetAuthData
+        gfnWrapperApiIsTitleAvailable,      ///< @ref GfnIsTitleAvailable
+        gfnWrapperApiGetTitlesAvailable,    ///< @ref GfnGetTitlesAvailable
+        gfnWrapperApiSetupTitle,            ///< @ref GfnSetupTitle
+        gfnWrapperApiAppReady,              ///< @ref GfnAppReady
+        gfnWrapperApiSetActionZone,         ///< @ref GfnSetActionZone
+        gfnWrapperApiFree,                  ///< @ref GfnFree
+        gfnWrapperApiStartStream,           ///< @ref GfnStartStream
+        gfnWrapperApiStartStreamAsync,      ///< @ref GfnStartStreamAsync
+        gfnWrapperApiStopStream,            ///< @ref GfnStopStream
+        gfnWrapperApiStopStreamAsync,       ///< @ref GfnStopStreamAsync
+        gfnWrapperApiTitleExited,           ///< @ref GfnTitleExited
+        gfnWrapperApiCount
+    } GfnWrapperApi;
+
+    /// @brief Number of buckets in GfnWrapperApiStats::latencyHistogram
+    #define GFN_WRAPPER_LATENCY_BUCKETS 16
+
+    /// @brief Call counters of one API, see @ref GfnGetWrapperStats
+    typedef struct GfnWrapperApiStats
+    {
+        unsigned long long calls;           ///< Calls made, including those the wrapper answered itself
+        unsigned long long libraryCalls;    ///< Calls passed on to the SDK library
+        unsigned long long totalLatencyUs;  ///< Time spent in the SDK library, in microseconds
+        unsigned long long maxLatencyUs;    ///< Longest call into the SDK library, in microseconds
+        /// Library calls by duration. Bucket 0 counts calls under 1 microsecond, bucket i calls
+        /// under 2^i microseconds, and the last bucket all longer calls.
+        unsigned long long latencyHistogram[GFN_WRAPPER_LATENCY_BUCKETS];
+    } GfnWrapperApiStats;
+
+    /// @brief Per-API call counters, see @ref GfnGetWrapperStats
+    typedef struct GfnWrapperStats
+    {
+        GfnWrapperApiStats apis[gfnWrapperApiCount];   ///< Indexed by @ref GfnWrapperApi
+    } GfnWrapperStats;
+
+    /// @brief Session data returned by @ref GfnGetSessionSnapshot. The struct and all of its strings
+    /// live in one block, released with @ref GfnFreeSessionSnapshot. A field the cloud library
+    /// could not provide is NULL, or empty for countryCode.
+    typedef struct GfnSessionSnapshot
+    {
+        const char* clientIp;           ///< As returned by @ref GfnGetClientIpV4
+        const char* languageCode;       ///< As returned by @ref GfnGetClientLanguageCode
+        char countryCode[CC_SIZE];      ///< As returned by @ref GfnGetClientCountryCode
+        const char* customData;         ///< As returned by @ref GfnGetCustomData
+        const char* authData;           ///< As returned by @ref GfnGetAuthData
+        bool hasClientInfo;             ///< Whether clientInfo is valid
+        GfnClientInfo clientInfo;       ///< As returned by @ref GfnGetClientInfo
+    } GfnSessionSnapshot;
+
     /// @defgroup wrapper API Wrapper Methods
     /// @{
 
@@ -225,13 +413,15 @@ extern "C"
     /// expects the library to be in the same folder as the loading process's executable. For
     /// security reasons, the dynamic library is loaded by fully-quanitified path. If the GFN SDK
     /// library is packaged in another folder, you will need to locally modify the function to
-    /// reference that location.
+    /// reference that location. The client and cloud libraries are loaded and their signatures
+    /// checked in parallel, unless the wrapper is built with GFN_SDK_SERIAL_INIT.
     ///
     /// @par Environment
     /// Cloud and Client
     ///
     /// @par Usage
-    /// Call as soon as possible during application startup.
+    /// Call as soon as possible during application startup. May be called from several threads at
+    /// once, only the first call loads the libraries and the others wait for it to finish.
     ///
     /// @param language                   - Language to use for any UI, such as GFN download and install progress dialogs.
     ///                                     Defaults to system language if not defined.
@@ -244,6 +434,30 @@ extern "C"
     /// @retval gfnAPINotFound            - The API was not found in the GFN SDK Library
     GfnRuntimeError GfnInitializeSdk(GfnDisplayLanguage language);
 
+    /// @par Description
+    /// Runs @ref GfnInitializeSdk on a new thread and reports the result to a callback.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @par Usage
+    /// Call during application startup to keep loading and verifying the SDK libraries off the
+    /// calling thread. The callback runs on the initialization thread once it is done. Other
+    /// wrapper calls made meanwhile return gfnAPINotInit, except @ref GfnInitializeSdk, which
+    /// waits for the initialization in progress. Do not call @ref GfnShutdownSdk before the
+    /// callback has run.
+    ///
+    /// @param language                   - Language to use for any UI, such as GFN download and install progress dialogs.
+    ///                                     Defaults to system language if not defined.
+    /// @param callback                   - Called with the result of @ref GfnInitializeSdk
+    /// @param userContext                - Pointer to user context, which will be passed unmodified to the
+    ///                                     callback. Can be NULL.
+    /// @retval gfnSuccess                - Initialization was started, the callback reports its result
+    /// @retval gfnInvalidParameter       - callback was NULL
+    /// @retval gfnUnableToAllocateMemory - The request could not be allocated
+    /// @retval gfnInternalError          - The initialization thread could not be started
+    GfnRuntimeError GfnInitializeSdkAsync(GfnDisplayLanguage language, GfnInitializeSdkCallbackSig callback, void* userContext);
+
     /// @par Description
     /// Loads the GFN SDK dynamic library from the given path and calls @ref gfnInitializeRuntimeSdk.
     ///
@@ -251,7 +465,8 @@ extern "C"
     /// Cloud and Client
     ///
     /// @par Usage
-    /// Call as soon as possible during application startup.
+    /// Call as soon as possible during application startup. May be called from several threads at
+    /// once, only the first call loads the libraries and the others wait for it to finish.
     ///
     /// @param language                   - Language to use for any UI, such as GFN download and install progress dialogs.
     ///                                     Defaults to system language if not defined.
@@ -276,6 +491,7 @@ extern "C"
     ///
     /// @par Usage
     /// Call during application shutdown or when GFN Runtime API methods are no longer needed.
+    /// No other wrapper API call may be in progress on another thread.
     /// @retval gfnSuccess                - If the SDK was initialized and all SDK features are available
     /// @retval gfnAPINotFound            - The API was not found in the GFN SDK Library
     GfnRuntimeError GfnShutdownSdk(void);
@@ -339,8 +555,38 @@ extern "C"
     /// @retval gfnClientLibraryNotFound  - GFN SDK client-side library could not be found
     /// @retval gfnCloudLibraryNotFound   - GFN SDK cloud-side library could not be found
     /// @retval gfnAPINotFound            - The API was not found in the GFN SDK Library
+    ///
+    /// @note
+    /// The wrapper verifies the GFN signature of the cloud library on the first call and keeps the
+    /// result for as long as the SDK is initialized. The library file is held open without write or
+    /// delete sharing during that time, so it can't be swapped behind the cached result. Use
+    /// @ref GfnIsRunningInCloudSecureEx to force a fresh verification.
     GfnRuntimeError GfnIsRunningInCloudSecure(GfnIsRunningInCloudAssurance* assurance);
 
+    ///
+    /// @par Description
+    /// Same as @ref GfnIsRunningInCloudSecure, optionally discarding the cached signature
+    /// verification result of the cloud library first.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    /// Elevated Process
+    ///
+    /// @par Usage
+    /// Pass forceRevalidate as true before enabling a feature of high value, where the cost of
+    /// verifying the signature again, typically several milliseconds, is acceptable.
+    ///
+    /// @param assurance                  - Likelihood and level of security assurance defined via @ref GfnIsRunningInCloudAssurance that API is running in GFN cloud environment
+    /// @param forceRevalidate            - True to verify the signature of the cloud library again even if
+    ///                                     a cached result exists
+    ///
+    /// @retval gfnSuccess                - If the query was successful.
+    /// @retval gfnRequiredElevation      - The API was called from a non-elevated process
+    /// @retval gfnClientLibraryNotFound  - GFN SDK client-side library could not be found
+    /// @retval gfnCloudLibraryNotFound   - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound            - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnIsRunningInCloudSecureEx(GfnIsRunningInCloudAssurance* assurance, bool forceRevalidate);
+
     ///
     /// @par Description
     /// Calls @ref gfnGetClientIp to get user client's IP address.
@@ -470,6 +716,41 @@ extern "C"
     /// To avoid leaking memory, call @ref gfnFree once done with the data.
     GfnRuntimeError GfnGetAuthData(const char** authData);
 
+    ///
+    /// @par Description
+    /// Retrieves the client IP address, language code, country code, custom data, authorization data
+    /// and client info in one call.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use at session start instead of calling each of the getters, which each need their own
+    /// environment check and each return a string to free.
+    ///
+    /// @param ppSnapshot               - Receives the snapshot. Call @ref GfnFreeSessionSnapshot to free the memory.
+    ///
+    /// @retval gfnSuccess                - On success, fields the cloud library could not provide are left empty
+    /// @retval gfnInvalidParameter       - NULL pointer passed in
+    /// @retval gfnCallWrongEnvironment   - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound   - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound            - The API was not found in the GFN SDK Library
+    /// @retval gfnUnableToAllocateMemory - Not enough memory to hold the snapshot
+    GfnRuntimeError GfnGetSessionSnapshot(GfnSessionSnapshot** ppSnapshot);
+
+    ///
+    /// @par Description
+    /// Frees a snapshot returned by @ref GfnGetSessionSnapshot, including all of its strings.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @param ppSnapshot               - Snapshot to free, set to NULL on return. NULL snapshots are ignored.
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnInvalidParameter     - NULL pointer passed in
+    GfnRuntimeError GfnFreeSessionSnapshot(GfnSessionSnapshot** ppSnapshot);
+
     ///
     /// @par Description
     /// Calls @ref gfnIsTitleAvailable to determines if a specific title is available to launch
@@ -522,6 +803,162 @@ extern "C"
     /// To avoid leaking memory, call @ref gfnFree once done with the title list.
     GfnRuntimeError GfnGetTitlesAvailable(const char** platformAppIds);
 
+    ///
+    /// @par Description
+    /// Same as @ref GfnGetClientIpV4, but copies the client IP address into a caller-provided buffer.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use where the value is read often, to reuse a buffer instead of freeing a library
+    /// allocation with @ref GfnFree every time. Pass a NULL buffer to query the size needed.
+    ///
+    /// @param clientIp                 - Buffer that receives the NULL-terminated value, or NULL to query the size
+    /// @param length                   - On input, the size of the buffer in bytes. On output, the size
+    ///                                   the value needs, including the NULL terminator
+    ///
+    /// @retval gfnSuccess              - On success, or when only the size was queried
+    /// @retval gfnInvalidParameter     - NULL length, or the buffer is smaller than the returned length
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnGetClientIpV4ToBuffer(char* clientIp, unsigned int* length);
+
+    ///
+    /// @par Description
+    /// Same as @ref GfnGetClientLanguageCode, but copies the client language code into a caller-provided buffer.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use where the value is read often, to reuse a buffer instead of freeing a library
+    /// allocation with @ref GfnFree every time. Pass a NULL buffer to query the size needed.
+    ///
+    /// @param languageCode             - Buffer that receives the NULL-terminated value, or NULL to query the size
+    /// @param length                   - On input, the size of the buffer in bytes. On output, the size
+    ///                                   the value needs, including the NULL terminator
+    ///
+    /// @retval gfnSuccess              - On success, or when only the size was queried
+    /// @retval gfnInvalidParameter     - NULL length, or the buffer is smaller than the returned length
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnGetClientLanguageCodeToBuffer(char* languageCode, unsigned int* length);
+
+    ///
+    /// @par Description
+    /// Same as @ref GfnGetCustomData, but copies the custom data into a caller-provided buffer.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use where the value is read often, to reuse a buffer instead of freeing a library
+    /// allocation with @ref GfnFree every time. Pass a NULL buffer to query the size needed.
+    ///
+    /// @param customData               - Buffer that receives the NULL-terminated value, or NULL to query the size
+    /// @param length                   - On input, the size of the buffer in bytes. On output, the size
+    ///                                   the value needs, including the NULL terminator
+    ///
+    /// @retval gfnSuccess              - On success, or when only the size was queried
+    /// @retval gfnInvalidParameter     - NULL length, or the buffer is smaller than the returned length
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnGetCustomDataToBuffer(char* customData, unsigned int* length);
+
+    ///
+    /// @par Description
+    /// Same as @ref GfnGetAuthData, but copies the authorization data into a caller-provided buffer.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use where the value is read often, to reuse a buffer instead of freeing a library
+    /// allocation with @ref GfnFree every time. Pass a NULL buffer to query the size needed.
+    ///
+    /// @param authData                 - Buffer that receives the NULL-terminated value, or NULL to query the size
+    /// @param length                   - On input, the size of the buffer in bytes. On output, the size
+    ///                                   the value needs, including the NULL terminator
+    ///
+    /// @retval gfnSuccess              - On success, or when only the size was queried
+    /// @retval gfnInvalidParameter     - NULL length, or the buffer is smaller than the returned length
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnGetAuthDataToBuffer(char* authData, unsigned int* length);
+
+    ///
+    /// @par Description
+    /// Same as @ref GfnGetTitlesAvailable, but copies the list of available titles into a caller-provided buffer.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use where the value is read often, to reuse a buffer instead of freeing a library
+    /// allocation with @ref GfnFree every time. Pass a NULL buffer to query the size needed.
+    ///
+    /// @param platformAppIds           - Buffer that receives the NULL-terminated value, or NULL to query the size
+    /// @param length                   - On input, the size of the buffer in bytes. On output, the size
+    ///                                   the value needs, including the NULL terminator
+    ///
+    /// @retval gfnSuccess              - On success, or when only the size was queried
+    /// @retval gfnInvalidParameter     - NULL length, or the buffer is smaller than the returned length
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnGetTitlesAvailableToBuffer(char* platformAppIds, unsigned int* length);
+
+    ///
+    /// @par Description
+    /// Determines for each of a set of titles whether it is available to launch in the current
+    /// GFN cloud instance.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use to check many titles at once, for example to decorate a library page. The answers come
+    /// from a copy of the list returned by @ref GfnGetTitlesAvailable that the wrapper keeps for up
+    /// to a minute, so a title made available since may still be reported as unavailable until
+    /// the copy is refreshed. Call @ref GfnRefreshTitlesAvailable to refresh it right away.
+    ///
+    /// @param platformAppIds           - Array of count platform-specific identifiers of the titles
+    /// @param count                    - Number of entries in platformAppIds and isAvailable
+    /// @param isAvailable              - Array of count booleans, each receives true if the title
+    ///                                   at the same index is available. NULL identifiers are reported
+    ///                                   as unavailable.
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnInvalidParameter     - NULL pointer passed in
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    /// @retval gfnUnableToAllocateMemory - Not enough memory to hold the list of titles
+    GfnRuntimeError GfnAreTitlesAvailable(const char** platformAppIds, size_t count, bool* isAvailable);
+
+    ///
+    /// @par Description
+    /// Refreshes the list of available titles used by @ref GfnAreTitlesAvailable.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Use when titles are known to have been made available, for example after a title was set
+    /// up with @ref GfnSetupTitle.
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnCallWrongEnvironment - If called in a client environment
+    /// @retval gfnCloudLibraryNotFound - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
+    /// @retval gfnUnableToAllocateMemory - Not enough memory to hold the list of titles
+    GfnRuntimeError GfnRefreshTitlesAvailable(void);
+
     ///
     /// @par Description
     /// Calls @ref gfnFree to free memory allocated by @ref gfnGetTitlesAvailable
@@ -707,6 +1144,8 @@ extern "C"
     ///
     /// @par Usage
     /// Register an application function to call when Geforce NOW needs to exit the game.
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddExitCallback
+    /// are kept and called as well.
     ///
     /// @param exitCallback             - Function pointer to application code to call when Geforce NOW
     ///                                   needs to exit the game.
@@ -731,6 +1170,8 @@ extern "C"
     ///
     /// @par Usage
     /// Register an application function to call when Geforce NOW needs to pause the game.
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddPauseCallback
+    /// are kept and called as well.
     ///
     /// @param pauseCallback            - Function pointer to application code to call when
     ///                                   Geforce NOW needs to pause the game
@@ -755,6 +1196,8 @@ extern "C"
     ///
     /// @par Usage
     /// Register a function to call after a successful call to gfnSetupTitle.
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddInstallCallback
+    /// are kept and called as well.
     ///
     /// @param installCallback          - Function pointer to application code to call after
     ///                                   Geforce NOW successfully performs its own title setup.
@@ -780,6 +1223,8 @@ extern "C"
     /// 
     /// @par Usage
     /// Register an application function to call when GFN needs the application to save
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddSaveCallback
+    /// are kept and called as well.
     ///
     /// @param saveCallback             - Function pointer to application code to call when GFN needs the application to save
     /// @param userContext              - Pointer to user context, which will be passed unmodified to the
@@ -800,6 +1245,8 @@ extern "C"
     /// 
     /// @par Usage
     /// Register an application function to call when a GFN user has connected to the game seat
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddSessionInitCallback
+    /// are kept and called as well.
     ///
     /// @param sessionInitCallback      - Function pointer to application code to call when the user has connected
     /// @param userContext              - Pointer to user context, which will be passed unmodified to the
@@ -820,6 +1267,10 @@ extern "C"
     /// @par Environment
     /// Cloud
     /// 
+    /// @par Usage
+    /// Replaces the callback set by an earlier call, callbacks added with @ref GfnAddClientInfoCallback
+    /// are kept and called as well.
+    ///
     /// @param clientInfoCallback       - Function pointer to application code to call when GFN client data changes
     ///
     /// @retval gfnSuccess              - On success when running in a GFN environment
@@ -827,6 +1278,265 @@ extern "C"
     /// @retval gfnAPINotFound          - The API was not found in the GFN SDK Library
     GfnRuntimeError GfnRegisterClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* userContext);
 
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterExitCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param exitCallback             - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddExitCallback(ExitCallbackSig exitCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterPauseCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param pauseCallback            - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddPauseCallback(PauseCallbackSig pauseCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterInstallCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param installCallback          - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddInstallCallback(InstallCallbackSig installCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterSaveCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param saveCallback             - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddSaveCallback(SaveCallbackSig saveCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterSessionInitCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param sessionInitCallback      - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddSessionInitCallback(SessionInitCallbackSig sessionInitCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Adds an application callback for the event @ref GfnRegisterClientInfoCallback registers for. Any
+    /// number of components can add their own callbacks, up to eight per event, and every one of
+    /// them is called when the event fires. Adding a callback allocates nothing.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Keep the returned handle to remove the callback with @ref GfnRemoveCallback. Handles stop
+    /// being valid at @ref GfnShutdownSdk.
+    ///
+    /// @param clientInfoCallback       - Function pointer to application code to call when the event fires
+    /// @param userContext              - Pointer to user context, which will be passed unmodified to the
+    ///                                   callback specified. Can be NULL.
+    /// @param handle                   - Receives the handle identifying the added callback
+    ///
+    /// @retval gfnSuccess                  - On success when running in a GFN environment
+    /// @retval gfnInvalidParameter         - Callback or handle was NULL
+    /// @retval gfnUnableToAllocateMemory   - Eight callbacks are already added for this event
+    /// @retval gfnCallWrongEnvironment     - Called outside of a cloud execution environment
+    /// @retval gfnCloudLibraryNotFound     - GFN SDK cloud-side library could not be found
+    /// @retval gfnAPINotFound              - The API was not found in the GFN SDK Library
+    GfnRuntimeError GfnAddClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* userContext, GfnCallbackHandle* handle);
+
+    ///
+    /// @par Description
+    /// Removes a callback added with one of the GfnAdd*Callback functions.
+    ///
+    /// @par Environment
+    /// Cloud
+    ///
+    /// @par Usage
+    /// Once this returns the callback is not called for events that fire later. A call already in
+    /// progress on another thread may still finish after it.
+    ///
+    /// @param handle                   - Handle returned when the callback was added
+    ///
+    /// @retval gfnSuccess              - The callback was removed
+    /// @retval gfnInvalidParameter     - The handle doesn't identify an added callback
+    /// @retval gfnAPINotInit           - The SDK is not initialized
+    GfnRuntimeError GfnRemoveCallback(GfnCallbackHandle handle);
+
+    ///
+    /// @par Description
+    /// Chooses the thread application callbacks run on. By default they run on the SDK thread that
+    /// raised the event, and a slow callback holds that thread up. When queued, the wrapper copies
+    /// the event and returns to the SDK right away, and the callbacks run later on the application
+    /// thread calling @ref GfnDispatchCallbacks or on a thread owned by the wrapper. Queued client
+    /// info and stream status updates that are superseded before they are delivered are merged,
+    /// only the latest one reaches the callbacks. A full queue delivers on the SDK thread instead.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @par Usage
+    /// Call after @ref GfnInitializeSdk. The setting is reset to @ref gfnCallbackDeliveryImmediate
+    /// by @ref GfnShutdownSdk, which drops events that were never dispatched. Exit, pause and save
+    /// callbacks no longer hold the SDK up while queued, so they finish after the SDK has moved on.
+    /// Changing the mode delivers what is already queued before returning, on the wrapper thread
+    /// when leaving @ref gfnCallbackDeliveryWrapperThread and on the calling thread otherwise.
+    ///
+    /// @param delivery                 - Where callbacks run from now on
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnInvalidParameter     - Unknown delivery mode
+    /// @retval gfnAPINotInit           - The SDK is not initialized
+    /// @retval gfnCallWrongEnvironment - Called from a callback running on the wrapper thread
+    /// @retval gfnInternalError        - The wrapper thread could not be started
+    GfnRuntimeError GfnSetCallbackDelivery(GfnCallbackDelivery delivery);
+
+    ///
+    /// @par Description
+    /// Runs application callbacks for events queued under @ref gfnCallbackDeliveryPolled.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @par Usage
+    /// Call regularly on the thread callbacks should run on, for example once per frame. Only one
+    /// thread dispatches at a time, a call made meanwhile, including one from inside a callback,
+    /// returns right away with nothing dispatched.
+    ///
+    /// @param maxCallbacks             - Most events to deliver, 0 for everything queued
+    /// @param dispatched               - Optional, receives the number of events delivered
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnAPINotInit           - The SDK is not initialized
+    GfnRuntimeError GfnDispatchCallbacks(unsigned int maxCallbacks, unsigned int* dispatched);
+
+    ///
+    /// @par Description
+    /// Reports how queued callback delivery has been doing since the process started.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @par Usage
+    /// Use the latency figures to see how long events wait for the dispatching thread. The
+    /// latency of a merged update counts from the oldest update it replaced.
+    ///
+    /// @param stats                    - Receives the counters
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnInvalidParameter     - stats was NULL
+    GfnRuntimeError GfnGetCallbackDeliveryStats(GfnCallbackDeliveryStats* stats);
+
+    ///
+    /// @par Description
+    /// Reports how often each wrapper API has been called since the process started, and how long
+    /// the SDK libraries took to answer the calls passed on to them.
+    ///
+    /// @par Environment
+    /// Cloud and Client
+    ///
+    /// @par Usage
+    /// Use to find APIs called far more often than needed, for example every frame. Take two
+    /// reports some time apart and compare them for call rates. When the wrapper is built with
+    /// GFN_SDK_WRAPPER_LOG, setting the GFN_SDK_WRAPPER_STATS_INTERVAL environment variable to a
+    /// number of seconds also writes the counters to the wrapper log at that interval.
+    ///
+    /// @param stats                    - Receives the counters
+    ///
+    /// @retval gfnSuccess              - On success
+    /// @retval gfnInvalidParameter     - stats was NULL
+    /// @retval gfnUnsupportedAPICall   - The wrapper was built with GFN_SDK_WRAPPER_NO_STATS
+    GfnRuntimeError GfnGetWrapperStats(GfnWrapperStats* stats);
+
     ///
     /// @par Description
     /// Calls @ref GfnAppReady to notify GFN that an application is ready to be displayed.
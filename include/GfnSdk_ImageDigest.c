@@ -0,0 +1,663 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+// SHA-256 with a portable implementation and two x86 ones: SHA extensions for a single stream,
+// and AVX2 for eight streams side by side. Image digests hash fixed size chunks so the AVX2 code
+// always has eight equally long streams to work on.
+
+#include <stdlib.h>
+#include <string.h>
+#include "GfnSdk_ImageDigest.h"
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#   define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define GFN_DIGEST_X86 1
+#   include <immintrin.h>
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#       define GFN_DIGEST_TARGET(features)
+#   else
+#       include <cpuid.h>
+#       define GFN_DIGEST_TARGET(features) __attribute__((target(features)))
+#   endif
+#else
+#   define GFN_DIGEST_X86 0
+#endif
+
+#define SHA256_BLOCK_SIZE   64
+#define DIGEST_LANES        8
+
+typedef void(*Sha256BlocksFn)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+static const uint32_t s_sha256InitialState[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t s_sha256RoundConstants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t gfnLoadBigEndian32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void gfnStoreBigEndian32(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+// ===================================================================
+// Portable implementation
+// ===================================================================
+
+#define ROTR32(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void gfnSha256BlocksScalar(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    uint32_t w[64];
+    for (; blocks != 0; --blocks, data += SHA256_BLOCK_SIZE)
+    {
+        for (int t = 0; t < 16; ++t)
+        {
+            w[t] = gfnLoadBigEndian32(data + 4 * t);
+        }
+        for (int t = 16; t < 64; ++t)
+        {
+            uint32_t s0 = ROTR32(w[t - 15], 7) ^ ROTR32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = ROTR32(w[t - 2], 17) ^ ROTR32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t)
+        {
+            uint32_t t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + s_sha256RoundConstants[t] + w[t];
+            uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+// ===================================================================
+// x86 implementations, only called after the processor checks below
+// ===================================================================
+#if GFN_DIGEST_X86
+
+// Four rounds, then the message schedule steps that can overlap with them. The message words
+// rotate through msgCur, msgNext, msgNextNext and msgPrev from one group to the next.
+#define SHA_NI_GROUP(group, msgCur, msgNext, msgPrev, scheduleNext, schedulePrev)                                   \
+    {                                                                                                               \
+        __m128i msg = _mm_add_epi32(msgCur, _mm_loadu_si128((const __m128i*)&s_sha256RoundConstants[4 * (group)])); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                                        \
+        if (scheduleNext)                                                                                           \
+        {                                                                                                           \
+            msgNext = _mm_add_epi32(msgNext, _mm_alignr_epi8(msgCur, msgPrev, 4));                                  \
+            msgNext = _mm_sha256msg2_epu32(msgNext, msgCur);                                                        \
+        }                                                                                                           \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                                                         \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                                                        \
+        if (schedulePrev)                                                                                           \
+        {                                                                                                           \
+            msgPrev = _mm_sha256msg1_epu32(msgPrev, msgCur);                                                        \
+        }                                                                                                           \
+    }
+
+GFN_DIGEST_TARGET("sha,sse4.1,ssse3")
+static void gfnSha256BlocksShaNi(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    const __m128i byteSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    // The instructions want the state as ABEF and CDGH
+    __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i state1 = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (; blocks != 0; --blocks, data += SHA256_BLOCK_SIZE)
+    {
+        const __m128i savedState0 = state0;
+        const __m128i savedState1 = state1;
+
+        __m128i msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), byteSwap);
+        __m128i msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), byteSwap);
+        __m128i msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), byteSwap);
+        __m128i msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), byteSwap);
+
+        SHA_NI_GROUP(0, msg0, msg1, msg3, 0, 0);
+        SHA_NI_GROUP(1, msg1, msg2, msg0, 0, 1);
+        SHA_NI_GROUP(2, msg2, msg3, msg1, 0, 1);
+        SHA_NI_GROUP(3, msg3, msg0, msg2, 1, 1);
+        SHA_NI_GROUP(4, msg0, msg1, msg3, 1, 1);
+        SHA_NI_GROUP(5, msg1, msg2, msg0, 1, 1);
+        SHA_NI_GROUP(6, msg2, msg3, msg1, 1, 1);
+        SHA_NI_GROUP(7, msg3, msg0, msg2, 1, 1);
+        SHA_NI_GROUP(8, msg0, msg1, msg3, 1, 1);
+        SHA_NI_GROUP(9, msg1, msg2, msg0, 1, 1);
+        SHA_NI_GROUP(10, msg2, msg3, msg1, 1, 1);
+        SHA_NI_GROUP(11, msg3, msg0, msg2, 1, 1);
+        SHA_NI_GROUP(12, msg0, msg1, msg3, 1, 1);
+        SHA_NI_GROUP(13, msg1, msg2, msg0, 1, 0);
+        SHA_NI_GROUP(14, msg2, msg3, msg1, 1, 0);
+        SHA_NI_GROUP(15, msg3, msg0, msg2, 0, 0);
+
+        state0 = _mm_add_epi32(state0, savedState0);
+        state1 = _mm_add_epi32(state1, savedState1);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(state0, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#define MB_ROTR(x, n)   _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// Turns eight rows of eight words into eight columns, rows[j] holds words of lane j
+GFN_DIGEST_TARGET("avx2")
+static void gfnTranspose8x8(__m256i rows[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+GFN_DIGEST_TARGET("avx2")
+static void gfnSha256CompressLanes(__m256i state[8], __m256i w[16])
+{
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; ++t)
+    {
+        if (t >= 16)
+        {
+            __m256i w15 = w[(t - 15) & 15];
+            __m256i w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(MB_ROTR(w15, 7), MB_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(MB_ROTR(w2, 17), MB_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(MB_ROTR(e, 6), MB_ROTR(e, 11)), MB_ROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, bigSigma1), _mm256_add_epi32(ch, w[t & 15]));
+        t1 = _mm256_add_epi32(t1, _mm256_set1_epi32((int)s_sha256RoundConstants[t]));
+        __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(MB_ROTR(a, 2), MB_ROTR(a, 13)), MB_ROTR(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(bigSigma0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    state[0] = _mm256_add_epi32(state[0], a); state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c); state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e); state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g); state[7] = _mm256_add_epi32(state[7], h);
+}
+
+// Hashes eight full chunks that follow each other at data, writing their digests to digests
+GFN_DIGEST_TARGET("avx2")
+static void gfnSha256ChunksAvx2(const uint8_t* data, uint8_t digests[DIGEST_LANES][GFN_SHA256_DIGEST_SIZE])
+{
+    const __m256i byteSwap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        state[i] = _mm256_set1_epi32((int)s_sha256InitialState[i]);
+    }
+
+    __m256i w[16];
+    for (size_t offset = 0; offset < GFN_IMAGE_DIGEST_CHUNK_SIZE; offset += SHA256_BLOCK_SIZE)
+    {
+        for (int half = 0; half < 2; ++half)
+        {
+            __m256i* rows = &w[8 * half];
+            for (int lane = 0; lane < DIGEST_LANES; ++lane)
+            {
+                const uint8_t* p = data + (size_t)lane * GFN_IMAGE_DIGEST_CHUNK_SIZE + offset + 32 * half;
+                rows[lane] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)p), byteSwap);
+            }
+            gfnTranspose8x8(rows);
+        }
+        gfnSha256CompressLanes(state, w);
+    }
+
+    // Every chunk is a whole number of blocks long, so they all end with the same padding block
+    for (int t = 0; t < 16; ++t)
+    {
+        w[t] = _mm256_setzero_si256();
+    }
+    w[0] = _mm256_set1_epi32((int)0x80000000u);
+    w[15] = _mm256_set1_epi32((int)(GFN_IMAGE_DIGEST_CHUNK_SIZE * 8u));
+    gfnSha256CompressLanes(state, w);
+
+    uint32_t words[8][DIGEST_LANES];
+    for (int i = 0; i < 8; ++i)
+    {
+        _mm256_storeu_si256((__m256i*)words[i], state[i]);
+    }
+    for (int lane = 0; lane < DIGEST_LANES; ++lane)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            gfnStoreBigEndian32(&digests[lane][4 * i], words[i][lane]);
+        }
+    }
+}
+
+// ===================================================================
+// Processor feature detection
+// ===================================================================
+
+static void gfnCpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    regs[0] = (uint32_t)info[0]; regs[1] = (uint32_t)info[1]; regs[2] = (uint32_t)info[2]; regs[3] = (uint32_t)info[3];
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+    {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+// Whether the operating system saves the upper halves of the YMM registers
+static bool gfnOsSavesYmm(void)
+{
+#ifdef _MSC_VER
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 0x6) == 0x6;
+#endif
+}
+
+#define CPU_FEATURES_UNKNOWN    0x1u
+#define CPU_FEATURE_SHA_NI      0x2u
+#define CPU_FEATURE_AVX2        0x4u
+
+static uint32_t gfnGetCpuFeatures(void)
+{
+    // Racing threads compute the same value, so a plain volatile store is enough
+    static volatile uint32_t s_features = CPU_FEATURES_UNKNOWN;
+    uint32_t features = s_features;
+    if (features != CPU_FEATURES_UNKNOWN)
+    {
+        return features;
+    }
+
+    features = 0;
+    uint32_t leaf0[4], leaf1[4], leaf7[4] = { 0 };
+    gfnCpuid(0, 0, leaf0);
+    gfnCpuid(1, 0, leaf1);
+    if (leaf0[0] >= 7)
+    {
+        gfnCpuid(7, 0, leaf7);
+    }
+
+    const bool ssse3 = (leaf1[2] & (1u << 9)) != 0;
+    const bool sse41 = (leaf1[2] & (1u << 19)) != 0;
+    const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+    const bool avx = (leaf1[2] & (1u << 28)) != 0;
+    if (ssse3 && sse41 && (leaf7[1] & (1u << 29)) != 0)
+    {
+        features |= CPU_FEATURE_SHA_NI;
+    }
+    if (osxsave && avx && (leaf7[1] & (1u << 5)) != 0 && gfnOsSavesYmm())
+    {
+        features |= CPU_FEATURE_AVX2;
+    }
+
+    s_features = features;
+    return features;
+}
+
+#endif // GFN_DIGEST_X86
+
+// ===================================================================
+// Backend selection and digests
+// ===================================================================
+
+bool gfnIsDigestBackendSupported(GfnDigestBackend backend)
+{
+    switch (backend)
+    {
+    case gfnDigestBackendAuto:
+    case gfnDigestBackendScalar:
+        return true;
+#if GFN_DIGEST_X86
+    case gfnDigestBackendAvx2:
+        return (gfnGetCpuFeatures() & CPU_FEATURE_AVX2) != 0;
+    case gfnDigestBackendShaNi:
+        return (gfnGetCpuFeatures() & CPU_FEATURE_SHA_NI) != 0;
+#endif
+    default:
+        return false;
+    }
+}
+
+GfnDigestBackend gfnGetDigestBackend(void)
+{
+    // A single stream on the SHA extensions keeps up with eight AVX2 lanes without the transposes
+    if (gfnIsDigestBackendSupported(gfnDigestBackendShaNi))
+    {
+        return gfnDigestBackendShaNi;
+    }
+    if (gfnIsDigestBackendSupported(gfnDigestBackendAvx2))
+    {
+        return gfnDigestBackendAvx2;
+    }
+    return gfnDigestBackendScalar;
+}
+
+static bool gfnResolveDigestBackend(GfnDigestBackend* pBackend)
+{
+    if (*pBackend == gfnDigestBackendAuto)
+    {
+        *pBackend = gfnGetDigestBackend();
+        return true;
+    }
+    return gfnIsDigestBackendSupported(*pBackend);
+}
+
+// Block function for a single stream
+static Sha256BlocksFn gfnGetBlocksFn(GfnDigestBackend backend)
+{
+#if GFN_DIGEST_X86
+    if (backend == gfnDigestBackendShaNi)
+    {
+        return gfnSha256BlocksShaNi;
+    }
+#endif
+    (void)backend;
+    return gfnSha256BlocksScalar;
+}
+
+static void gfnSha256WithBlocks(Sha256BlocksFn blocksFn, const uint8_t* data, size_t size, uint8_t digest[GFN_SHA256_DIGEST_SIZE])
+{
+    uint32_t state[8];
+    memcpy(state, s_sha256InitialState, sizeof(state));
+
+    const size_t fullBlocks = size / SHA256_BLOCK_SIZE;
+    blocksFn(state, data, fullBlocks);
+
+    // The rest of the data, the 0x80 terminator and the bit length need one or two more blocks
+    uint8_t tail[2 * SHA256_BLOCK_SIZE];
+    const size_t remaining = size % SHA256_BLOCK_SIZE;
+    const size_t tailBlocks = remaining < SHA256_BLOCK_SIZE - 8 ? 1 : 2;
+    memset(tail, 0, sizeof(tail));
+    if (remaining != 0)
+    {
+        memcpy(tail, data + fullBlocks * SHA256_BLOCK_SIZE, remaining);
+    }
+    tail[remaining] = 0x80;
+    const uint64_t bitLength = (uint64_t)size * 8;
+    gfnStoreBigEndian32(&tail[tailBlocks * SHA256_BLOCK_SIZE - 8], (uint32_t)(bitLength >> 32));
+    gfnStoreBigEndian32(&tail[tailBlocks * SHA256_BLOCK_SIZE - 4], (uint32_t)bitLength);
+    blocksFn(state, tail, tailBlocks);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        gfnStoreBigEndian32(&digest[4 * i], state[i]);
+    }
+}
+
+bool gfnSha256(const void* data, size_t size, GfnDigestBackend backend, unsigned char digest[GFN_SHA256_DIGEST_SIZE])
+{
+    if ((data == NULL && size != 0) || digest == NULL || !gfnResolveDigestBackend(&backend))
+    {
+        return false;
+    }
+    gfnSha256WithBlocks(gfnGetBlocksFn(backend), (const uint8_t*)data, size, digest);
+    return true;
+}
+
+bool gfnDigestImage(const void* data, uint64_t size, GfnDigestBackend backend, GfnImageDigest* digest)
+{
+    if ((data == NULL && size != 0) || digest == NULL || size > SIZE_MAX || !gfnResolveDigestBackend(&backend))
+    {
+        return false;
+    }
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    const size_t chunks = size == 0 ? 1 : (size_t)((size + GFN_IMAGE_DIGEST_CHUNK_SIZE - 1) / GFN_IMAGE_DIGEST_CHUNK_SIZE);
+    const size_t fullChunks = (size_t)(size / GFN_IMAGE_DIGEST_CHUNK_SIZE);
+
+    // Image size followed by the chunk digests
+    const size_t summarySize = 8 + chunks * GFN_SHA256_DIGEST_SIZE;
+    uint8_t* summary = (uint8_t*)malloc(summarySize);
+    if (summary == NULL)
+    {
+        return false;
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        summary[i] = (uint8_t)(size >> (8 * i));
+    }
+    uint8_t (*chunkDigests)[GFN_SHA256_DIGEST_SIZE] = (uint8_t (*)[GFN_SHA256_DIGEST_SIZE])(summary + 8);
+
+    size_t chunk = 0;
+#if GFN_DIGEST_X86
+    if (backend == gfnDigestBackendAvx2)
+    {
+        for (; chunk + DIGEST_LANES <= fullChunks; chunk += DIGEST_LANES)
+        {
+            gfnSha256ChunksAvx2(bytes + chunk * GFN_IMAGE_DIGEST_CHUNK_SIZE, &chunkDigests[chunk]);
+        }
+    }
+#endif
+
+    // Chunks left over from the lanes, and the last partial one
+    const Sha256BlocksFn blocksFn = gfnGetBlocksFn(backend);
+    for (; chunk < chunks; ++chunk)
+    {
+        const size_t offset = chunk * GFN_IMAGE_DIGEST_CHUNK_SIZE;
+        const size_t length = chunk < fullChunks ? GFN_IMAGE_DIGEST_CHUNK_SIZE : (size_t)(size - offset);
+        gfnSha256WithBlocks(blocksFn, bytes + offset, length, chunkDigests[chunk]);
+    }
+
+    gfnSha256WithBlocks(blocksFn, summary, summarySize, digest->bytes);
+    free(summary);
+    return true;
+}
+
+bool gfnDigestImageFile(GfnDigestFile file, GfnDigestBackend backend, GfnImageDigest* digest)
+{
+    if (digest == NULL || !gfnIsDigestBackendSupported(backend))
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (file == NULL || file == INVALID_HANDLE_VALUE || !GetFileSizeEx((HANDLE)file, &size))
+    {
+        return false;
+    }
+    // Empty files can't be mapped
+    if (size.QuadPart == 0)
+    {
+        return gfnDigestImage(NULL, 0, backend, digest);
+    }
+
+    HANDLE mapping = CreateFileMappingW((HANDLE)file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL)
+    {
+        return false;
+    }
+
+    bool result = gfnDigestImage(view, (uint64_t)size.QuadPart, backend, digest);
+    UnmapViewOfFile(view);
+    return result;
+#else
+    struct stat info;
+    if (file < 0 || fstat(file, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return false;
+    }
+    if (info.st_size == 0)
+    {
+        return gfnDigestImage(NULL, 0, backend, digest);
+    }
+
+    void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+
+    bool result = gfnDigestImage(view, (uint64_t)info.st_size, backend, digest);
+    munmap(view, (size_t)info.st_size);
+    return result;
+#endif
+}
+
+bool gfnDigestImagePathA(const char* path, GfnDigestBackend backend, GfnImageDigest* digest)
+{
+    if (path == NULL)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    bool result = gfnDigestImageFile(file, backend, digest);
+    CloseHandle(file);
+#else
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return false;
+    }
+    bool result = gfnDigestImageFile(file, backend, digest);
+    close(file);
+#endif
+    return result;
+}
+
+#ifdef _WIN32
+bool gfnDigestImagePathW(const wchar_t* path, GfnDigestBackend backend, GfnImageDigest* digest)
+{
+    if (path == NULL)
+    {
+        return false;
+    }
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    bool result = gfnDigestImageFile(file, backend, digest);
+    CloseHandle(file);
+    return result;
+}
+#endif
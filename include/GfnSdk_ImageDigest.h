@@ -0,0 +1,149 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#ifndef __NV_GFNSDK_IMAGE_DIGEST_H__
+#define __NV_GFNSDK_IMAGE_DIGEST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GFN_SHA256_DIGEST_SIZE      32
+/// Size of the pieces an image is split into, see @ref gfnDigestImage
+#define GFN_IMAGE_DIGEST_CHUNK_SIZE (64 * 1024)
+
+typedef struct GfnImageDigest
+{
+    unsigned char bytes[GFN_SHA256_DIGEST_SIZE];
+} GfnImageDigest;
+
+/// SHA-256 implementations, all of them produce the same digests
+typedef enum GfnDigestBackend
+{
+    gfnDigestBackendAuto,           ///< Fastest backend the processor supports
+    gfnDigestBackendScalar,         ///< Portable C
+    gfnDigestBackendAvx2,           ///< Eight chunks at a time in AVX2 lanes
+    gfnDigestBackendShaNi           ///< x86 SHA extensions
+} GfnDigestBackend;
+
+#ifdef _WIN32
+typedef void* GfnDigestFile;        ///< HANDLE opened with GENERIC_READ
+#else
+typedef int GfnDigestFile;          ///< File descriptor opened for reading
+#endif
+
+///
+/// @par Description
+/// Reports whether backend can run on this processor and operating system
+///
+/// @param backend                  - Backend to check, gfnDigestBackendAuto is always supported
+///
+bool gfnIsDigestBackendSupported(GfnDigestBackend backend);
+
+///
+/// @par Description
+/// Resolves gfnDigestBackendAuto to the backend it stands for on this machine
+///
+GfnDigestBackend gfnGetDigestBackend(void);
+
+///
+/// @par Description
+/// Computes the plain SHA-256 digest of a buffer
+///
+/// @param data                     - Data to hash, may be NULL when size is 0
+/// @param size                     - Size of data in bytes
+/// @param backend                  - Implementation to use. gfnDigestBackendAvx2 only pays off
+///                                   for several buffers at once and runs the scalar code here.
+/// @param digest                   - Receives the digest
+///
+/// @retval true                    - The digest was computed
+/// @retval false                   - A parameter is NULL, or backend isn't supported
+///
+bool gfnSha256(const void* data, size_t size, GfnDigestBackend backend, unsigned char digest[GFN_SHA256_DIGEST_SIZE]);
+
+///
+/// @par Description
+/// Computes the digest used to recognize an image that has been seen before
+///
+/// @par Usage
+/// The image is split into GFN_IMAGE_DIGEST_CHUNK_SIZE chunks, at least one, and the digest is
+/// the SHA-256 of the image size as a little endian 64 bit value followed by the SHA-256 of
+/// every chunk. Hashing the chunks independently lets them run in parallel lanes. The result is
+/// not the SHA-256 of the file, only compare it with other image digests.
+///
+/// @param data                     - Image bytes, may be NULL when size is 0
+/// @param size                     - Size of the image in bytes
+/// @param backend                  - Implementation to use
+/// @param digest                   - Receives the digest
+///
+/// @retval true                    - The digest was computed
+/// @retval false                   - A parameter is NULL, or backend isn't supported
+///
+bool gfnDigestImage(const void* data, uint64_t size, GfnDigestBackend backend, GfnImageDigest* digest);
+
+///
+/// @par Description
+/// Memory-maps an open file and computes its @ref gfnDigestImage digest
+///
+/// @par Usage
+/// Hold the file open without write sharing for as long as the digest has to describe what
+/// gets loaded from it.
+///
+/// @param file                     - File to hash, it is not closed
+/// @param backend                  - Implementation to use
+/// @param digest                   - Receives the digest
+///
+/// @retval true                    - The digest was computed
+/// @retval false                   - The file couldn't be mapped, or backend isn't supported
+///
+bool gfnDigestImageFile(GfnDigestFile file, GfnDigestBackend backend, GfnImageDigest* digest);
+
+///
+/// @par Description
+/// Opens a file by path and computes its @ref gfnDigestImage digest
+///
+/// @param path                     - Path of the file to hash
+/// @param backend                  - Implementation to use
+/// @param digest                   - Receives the digest
+///
+/// @retval true                    - The digest was computed
+/// @retval false                   - The file couldn't be opened or mapped, or backend isn't supported
+///
+bool gfnDigestImagePathA(const char* path, GfnDigestBackend backend, GfnImageDigest* digest);
+#ifdef _WIN32
+bool gfnDigestImagePathW(const wchar_t* path, GfnDigestBackend backend, GfnImageDigest* digest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NV_GFNSDK_IMAGE_DIGEST_H__
@@ -30,11 +30,13 @@
 #endif
 #include <Shlobj.h>
 #include <WinTrust.h>
+#include <AccCtrl.h>
 #include <wchar.h> // Needed for conversion to WCHAR for Win32 APIs that require it
 #include <windows.h>
 #include <strsafe.h>
 
 #include "GfnSdk_SecureLoadLibrary.h"
+#include "GfnSdk_ImageDigest.h"
 
 // Internal function forward declarations
 static BOOL gfnInternalFileExists(LPCWSTR szFileName);
@@ -55,8 +57,14 @@ static BOOL gfnInternalVerifyFileSignatureInfo(
     LPCWSTR fileName,
     DWORD index,
     SignatureType signatureType);
+static BOOL gfnInternalVerifyImageSignature(LPCWSTR fileName, HANDLE hFile, SignatureType signatureType);
+static BOOL gfnInternalIsImageVerifiedPersistently(HANDLE hFile, const GfnImageDigest* pDigest, SignatureType signatureType);
+static void gfnInternalPersistVerifiedImage(HANDLE hFile, const GfnImageDigest* pDigest, SignatureType signatureType);
 static HMODULE gfnInternalSecureLoadLibraryW(LPCWSTR filePath, DWORD dwFlags, SignatureType signatureType);
 static HMODULE gfnInternalSecureLoadLibraryA(LPCSTR filePath, DWORD dwFlags, SignatureType signatureType);
+static BOOL gfnInternalIsLocalSystem(void);
+
+static volatile LONG s_persistentCacheMode = gfnVerificationCacheOff;
 
 // Just emphasising that LocalFree ignores NULL args:
 #define SafeLocalFree(x) LocalFree(x)
@@ -94,7 +102,7 @@ HMODULE gfnSecureLoadCloudLibraryA(LPCSTR filePath, DWORD dwFlags)
 
 BOOL gfnCheckLibraryGfnSignatureW(LPCWSTR filePath)
 {
-    return gfnInternalVerifyFileSignature(filePath, SignatureTypeGfn);
+    return gfnInternalVerifyImageSignature(filePath, INVALID_HANDLE_VALUE, SignatureTypeGfn);
 }
 
 BOOL gfnCheckLibraryGfnSignatureA(LPCSTR filePath)
@@ -109,7 +117,7 @@ BOOL gfnCheckLibraryGfnSignatureA(LPCSTR filePath)
     unicodeFilePath = gfnInternalCreateUnicodeStringFromAscii(filePath);
     if (!!unicodeFilePath)
     {
-        isSigned = gfnInternalVerifyFileSignature(unicodeFilePath, SignatureTypeGfn);
+        isSigned = gfnInternalVerifyImageSignature(unicodeFilePath, INVALID_HANDLE_VALUE, SignatureTypeGfn);
     }
     SafeLocalFree(unicodeFilePath);
 
@@ -118,7 +126,7 @@ BOOL gfnCheckLibraryGfnSignatureA(LPCSTR filePath)
 
 BOOL gfnCheckLibraryNvSignatureW(LPCWSTR filePath)
 {
-    return gfnInternalVerifyFileSignature(filePath, SignatureTypeNvidia);
+    return gfnInternalVerifyImageSignature(filePath, INVALID_HANDLE_VALUE, SignatureTypeNvidia);
 }
 
 BOOL gfnCheckLibraryNvSignatureA(LPCSTR filePath)
@@ -133,13 +141,37 @@ BOOL gfnCheckLibraryNvSignatureA(LPCSTR filePath)
     unicodeFilePath = gfnInternalCreateUnicodeStringFromAscii(filePath);
     if (!!unicodeFilePath)
     {
-        isSigned = gfnInternalVerifyFileSignature(unicodeFilePath, SignatureTypeNvidia);
+        isSigned = gfnInternalVerifyImageSignature(unicodeFilePath, INVALID_HANDLE_VALUE, SignatureTypeNvidia);
     }
     SafeLocalFree(unicodeFilePath);
 
     return isSigned;
 }
 
+BOOL gfnSetPersistentVerificationCache(GfnVerificationCacheMode mode)
+{
+    switch (mode)
+    {
+    case gfnVerificationCacheOff:
+    case gfnVerificationCacheRead:
+        break;
+    case gfnVerificationCacheReadWrite:
+        if (!gfnInternalIsLocalSystem())
+        {
+            SetLastError(ERROR_ACCESS_DENIED);
+            return FALSE;
+        }
+        break;
+    default:
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+    InterlockedExchange(&s_persistentCacheMode, (LONG)mode);
+    SetLastError(ERROR_SUCCESS);
+    return TRUE;
+}
+
 
 // ===================================================================
 // Internal functions defined below. Do not use directly.
@@ -167,7 +199,7 @@ static HMODULE gfnInternalSecureLoadLibraryW(LPCWSTR filePath, DWORD dwFlags, Si
     }
     else
     {
-        BOOL bSignatureVerified = gfnInternalVerifyFileSignature(filePath, signatureType);
+        BOOL bSignatureVerified = gfnInternalVerifyImageSignature(filePath, hFileLock, signatureType);
         if (!bSignatureVerified)
         {
             SetLastError((DWORD)CRYPT_E_NO_MATCH);
@@ -306,6 +338,9 @@ static PfnRegCloseKey pfnRegCloseKey = NULL;
 typedef HRESULT(WINAPI* PfnSHGetFolderPath_W)(HWND, int, HANDLE, DWORD, LPWSTR);
 static PfnSHGetFolderPath_W pfnSHGetFolderPath = NULL;
 
+typedef int(WINAPI* PfnSHCreateDirectoryExW)(HWND, LPCWSTR, const SECURITY_ATTRIBUTES*);
+static PfnSHCreateDirectoryExW pfnSHCreateDirectoryExW = NULL;
+
 typedef SC_HANDLE(WINAPI* PfnOpenSCManagerW)(
     IN LPCWSTR lpMachineName,
     IN LPCWSTR lpDatabaseName,
@@ -380,6 +415,47 @@ typedef LONG(WINAPI* PfnCertVerifyTimeValidity)(
     IN PCERT_INFO pCertInfo);
 static PfnCertVerifyTimeValidity pfnCertVerifyTimeValidity = NULL;
 
+typedef DWORD(WINAPI* PfnGetSecurityInfo)(
+    IN HANDLE handle,
+    IN SE_OBJECT_TYPE ObjectType,
+    IN SECURITY_INFORMATION SecurityInfo,
+    OUT PSID* ppsidOwner,
+    OUT PSID* ppsidGroup,
+    OUT PACL* ppDacl,
+    OUT PACL* ppSacl,
+    OUT PSECURITY_DESCRIPTOR* ppSecurityDescriptor);
+static PfnGetSecurityInfo pfnGetSecurityInfo = NULL;
+
+typedef BOOL(WINAPI* PfnGetAce)(IN PACL pAcl, IN DWORD dwAceIndex, OUT LPVOID* pAce);
+static PfnGetAce pfnGetAce = NULL;
+
+typedef BOOL(WINAPI* PfnIsWellKnownSid)(IN PSID pSid, IN WELL_KNOWN_SID_TYPE WellKnownSidType);
+static PfnIsWellKnownSid pfnIsWellKnownSid = NULL;
+
+typedef BOOL(WINAPI* PfnConvertStringSecurityDescriptorToSecurityDescriptorW)(
+    IN LPCWSTR StringSecurityDescriptor,
+    IN DWORD StringSDRevision,
+    OUT PSECURITY_DESCRIPTOR* SecurityDescriptor,
+    OUT PULONG SecurityDescriptorSize);
+static PfnConvertStringSecurityDescriptorToSecurityDescriptorW pfnConvertStringSecurityDescriptorToSecurityDescriptorW = NULL;
+
+typedef BOOL(WINAPI* PfnGetSecurityDescriptorControl)(
+    IN PSECURITY_DESCRIPTOR pSecurityDescriptor,
+    OUT PSECURITY_DESCRIPTOR_CONTROL pControl,
+    OUT LPDWORD lpdwRevision);
+static PfnGetSecurityDescriptorControl pfnGetSecurityDescriptorControl = NULL;
+
+typedef BOOL(WINAPI* PfnOpenProcessToken)(IN HANDLE ProcessHandle, IN DWORD DesiredAccess, OUT PHANDLE TokenHandle);
+static PfnOpenProcessToken pfnOpenProcessToken = NULL;
+
+typedef BOOL(WINAPI* PfnGetTokenInformation)(
+    IN HANDLE TokenHandle,
+    IN TOKEN_INFORMATION_CLASS TokenInformationClass,
+    OUT LPVOID TokenInformation,
+    IN DWORD TokenInformationLength,
+    OUT PDWORD ReturnLength);
+static PfnGetTokenInformation pfnGetTokenInformation = NULL;
+
 static BOOL gfnInternalFileExists(LPCWSTR szFileName)
 {
     DWORD fileAttributes = GetFileAttributesW(szFileName);
@@ -438,6 +514,111 @@ static LPWSTR gfnInternalCreateUnicodeStringFromAscii(LPCSTR szAscii)
     return pResult;
 }
 
+// Images that recently passed a signature check, keyed by their digest. Checking the same bytes
+// again skips WinVerifyTrust and the certificate chain walk until the entry expires, which also
+// bounds how long a revoked certificate goes unnoticed.
+#define VERIFIED_IMAGE_CACHE_SIZE   8
+#define VERIFIED_IMAGE_TTL_MS       (10 * 60 * 1000)
+
+typedef struct tagVerifiedImage
+{
+    GfnImageDigest digest;
+    SignatureType signatureType;
+    ULONGLONG verifiedAt;           // GetTickCount64, 0 for an unused entry
+} VerifiedImage;
+
+static SRWLOCK s_verifiedImagesLock = SRWLOCK_INIT;
+static VerifiedImage s_verifiedImages[VERIFIED_IMAGE_CACHE_SIZE];
+
+static BOOL gfnInternalIsImageVerified(const GfnImageDigest* pDigest, SignatureType signatureType)
+{
+    BOOL bFound = FALSE;
+    ULONGLONG now = GetTickCount64();
+    DWORD i;
+
+    AcquireSRWLockShared(&s_verifiedImagesLock);
+    for (i = 0; i < VERIFIED_IMAGE_CACHE_SIZE && !bFound; ++i)
+    {
+        const VerifiedImage* pEntry = &s_verifiedImages[i];
+        bFound = pEntry->verifiedAt != 0 &&
+            now - pEntry->verifiedAt < VERIFIED_IMAGE_TTL_MS &&
+            pEntry->signatureType == signatureType &&
+            memcmp(&pEntry->digest, pDigest, sizeof(*pDigest)) == 0;
+    }
+    ReleaseSRWLockShared(&s_verifiedImagesLock);
+
+    return bFound;
+}
+
+static void gfnInternalRememberVerifiedImage(const GfnImageDigest* pDigest, SignatureType signatureType)
+{
+    VerifiedImage* pOldest = &s_verifiedImages[0];
+    DWORD i;
+
+    AcquireSRWLockExclusive(&s_verifiedImagesLock);
+    for (i = 0; i < VERIFIED_IMAGE_CACHE_SIZE; ++i)
+    {
+        VerifiedImage* pEntry = &s_verifiedImages[i];
+        // Reuse the entry of the same image, otherwise replace the oldest
+        if (pEntry->verifiedAt != 0 && pEntry->signatureType == signatureType &&
+            memcmp(&pEntry->digest, pDigest, sizeof(*pDigest)) == 0)
+        {
+            pOldest = pEntry;
+            break;
+        }
+        if (pEntry->verifiedAt < pOldest->verifiedAt)
+        {
+            pOldest = pEntry;
+        }
+    }
+    pOldest->digest = *pDigest;
+    pOldest->signatureType = signatureType;
+    pOldest->verifiedAt = GetTickCount64();
+    ReleaseSRWLockExclusive(&s_verifiedImagesLock);
+}
+
+// Verifies the signature of fileName unless an image with the same digest passed recently.
+// hFile is the caller's read lock on the file, or INVALID_HANDLE_VALUE to take one here so the
+// file can't change between hashing and verifying it.
+static BOOL gfnInternalVerifyImageSignature(LPCWSTR fileName, HANDLE hFile, SignatureType signatureType)
+{
+    HANDLE hOwnedFile = INVALID_HANDLE_VALUE;
+    GfnImageDigest digest;
+    BOOL bHaveDigest = FALSE;
+    BOOL bVerified = FALSE;
+
+    if (INVALID_HANDLE_VALUE == hFile && !!fileName)
+    {
+        hFile = hOwnedFile = gfnInternalLockFileForGenericReadAccess(fileName);
+    }
+
+    // Without a digest, e.g. when someone else has the file open for writing, verify as before
+    bHaveDigest = INVALID_HANDLE_VALUE != hFile && gfnDigestImageFile(hFile, gfnDigestBackendAuto, &digest);
+    if (bHaveDigest && gfnInternalIsImageVerified(&digest, signatureType))
+    {
+        SafeCloseHandle(hOwnedFile);
+        SetLastError(ERROR_SUCCESS);
+        return TRUE;
+    }
+    if (bHaveDigest && gfnInternalIsImageVerifiedPersistently(hFile, &digest, signatureType))
+    {
+        gfnInternalRememberVerifiedImage(&digest, signatureType);
+        SafeCloseHandle(hOwnedFile);
+        SetLastError(ERROR_SUCCESS);
+        return TRUE;
+    }
+
+    bVerified = gfnInternalVerifyFileSignature(fileName, signatureType);
+    if (bVerified && bHaveDigest)
+    {
+        gfnInternalRememberVerifiedImage(&digest, signatureType);
+        gfnInternalPersistVerifiedImage(hFile, &digest, signatureType);
+    }
+
+    SafeCloseHandle(hOwnedFile);
+    return bVerified;
+}
+
 LPWSTR gfnInternalCreateSystemFilePath(LPCWSTR szFileName)
 {
     LPWSTR pResult = NULL;
@@ -1518,3 +1699,442 @@ verifyFileSignatureInfoDone:
     SetLastError(dwError);
     return bResult;
 }
+
+// ===================================================================
+// Verification results shared between processes
+//
+// The service records images it verified in a table on disk that only LocalSystem and
+// Administrators can write, so other processes can look an image up instead of walking its
+// certificate chain. Entries are keyed by file identity and must also match the digest.
+//
+// The table lives in a directory of its own that the service creates. Its parent can be created,
+// and written to, by any user, so the writer checks the directory it opened before using it and
+// only touches files through handles.
+// ===================================================================
+
+#define PERSISTENT_CACHE_PARENT     L"\\NVIDIA Corporation\\GfnRuntimeSdk"
+#define PERSISTENT_CACHE_DIRECTORY  L"Verification"
+#define PERSISTENT_CACHE_FILE_NAME  L"VerificationCache.bin"
+#define PERSISTENT_CACHE_MAGIC      0x43564647  // "GFVC"
+#define PERSISTENT_CACHE_VERSION    1
+#define PERSISTENT_CACHE_SLOTS      64          // power of two
+#define PERSISTENT_CACHE_PROBES     4
+#define PERSISTENT_CACHE_TTL        (24ull * 60 * 60 * 10000000) // FILETIME units, one day
+
+// Owner LocalSystem, protected from inheritance, full access for LocalSystem and
+// Administrators, read access for everyone
+#define PERSISTENT_CACHE_SDDL       L"O:SYD:P(A;;FA;;;SY)(A;;FA;;;BA)(A;;FR;;;WD)"
+#define PERSISTENT_CACHE_DIR_SDDL   L"O:SYD:P(A;OICI;FA;;;SY)(A;OICI;FA;;;BA)(A;OICI;FR;;;WD)"
+#ifndef SDDL_REVISION_1
+#define SDDL_REVISION_1             1
+#endif
+
+typedef struct tagPersistentCacheEntry
+{
+    GfnImageDigest digest;
+    DWORD signatureType;
+    DWORD volumeSerialNumber;
+    DWORD fileIndexHigh;
+    DWORD fileIndexLow;
+    ULONGLONG fileSize;
+    ULONGLONG lastWriteTime;
+    ULONGLONG verifiedAt;           // FILETIME, 0 for an unused slot
+} PersistentCacheEntry;
+
+typedef struct tagPersistentCache
+{
+    DWORD magic;
+    DWORD version;
+    PersistentCacheEntry entries[PERSISTENT_CACHE_SLOTS];
+} PersistentCache;
+
+// Serializes the writers of this process, other processes can't write the file
+static SRWLOCK s_persistentCacheWriteLock = SRWLOCK_INIT;
+
+static BOOL gfnInternalLoadSecurityApis(void)
+{
+    return gfnInternalGetModule(L"advapi32.dll", hModAdvapi32) &&
+        gfnInternalGetProc(hModAdvapi32, "GetSecurityInfo", pfnGetSecurityInfo) &&
+        gfnInternalGetProc(hModAdvapi32, "GetAce", pfnGetAce) &&
+        gfnInternalGetProc(hModAdvapi32, "GetSecurityDescriptorControl", pfnGetSecurityDescriptorControl) &&
+        gfnInternalGetProc(hModAdvapi32, "IsWellKnownSid", pfnIsWellKnownSid) &&
+        gfnInternalGetProc(hModAdvapi32, "ConvertStringSecurityDescriptorToSecurityDescriptorW", pfnConvertStringSecurityDescriptorToSecurityDescriptorW) &&
+        gfnInternalGetProc(hModAdvapi32, "OpenProcessToken", pfnOpenProcessToken) &&
+        gfnInternalGetProc(hModAdvapi32, "GetTokenInformation", pfnGetTokenInformation);
+}
+
+static BOOL gfnInternalIsLocalSystem(void)
+{
+    DWORD_PTR tokenUser[(sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE) / sizeof(DWORD_PTR) + 1];
+    HANDLE hToken = NULL;
+    DWORD size = 0;
+    BOOL bResult = FALSE;
+
+    if (!gfnInternalLoadSecurityApis() || !pfnOpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken))
+    {
+        return FALSE;
+    }
+    if (pfnGetTokenInformation(hToken, TokenUser, tokenUser, sizeof(tokenUser), &size))
+    {
+        bResult = pfnIsWellKnownSid(((TOKEN_USER*)tokenUser)->User.Sid, WinLocalSystemSid);
+    }
+    CloseHandle(hToken);
+    return bResult;
+}
+
+static BOOL gfnInternalGetPersistentCacheParent(LPWSTR path, size_t pathLength)
+{
+    if (!gfnInternalGetModule(L"shell32.dll", hModShell32) ||
+        !gfnInternalGetProc(hModShell32, "SHGetFolderPathW", pfnSHGetFolderPath) ||
+        pathLength < MAX_PATH ||
+        FAILED(pfnSHGetFolderPath(NULL, CSIDL_COMMON_APPDATA, NULL, SHGFP_TYPE_CURRENT, path)))
+    {
+        return FALSE;
+    }
+    return SUCCEEDED(StringCchCatW(path, pathLength, PERSISTENT_CACHE_PARENT));
+}
+
+static BOOL gfnInternalGetPersistentCachePath(LPWSTR path, size_t pathLength)
+{
+    return gfnInternalGetPersistentCacheParent(path, pathLength) &&
+        SUCCEEDED(StringCchCatW(path, pathLength, L"\\" PERSISTENT_CACHE_DIRECTORY L"\\" PERSISTENT_CACHE_FILE_NAME));
+}
+
+static BOOL gfnInternalIsTrustedSid(PSID pSid)
+{
+    return pfnIsWellKnownSid(pSid, WinLocalSystemSid) || pfnIsWellKnownSid(pSid, WinBuiltinAdministratorsSid);
+}
+
+// Only a file or directory nobody but LocalSystem and Administrators could have written is
+// trusted. Someone replacing it creates one they own, which fails the owner check. Everything
+// the service creates here has a protected DACL, so one that inherits is not ours either.
+static BOOL gfnInternalIsPersistentCacheTrusted(HANDLE hFile)
+{
+    // FILE_WRITE_DATA and FILE_APPEND_DATA double as FILE_ADD_FILE and FILE_ADD_SUBDIRECTORY
+    const ACCESS_MASK writeAccess = FILE_WRITE_DATA | FILE_APPEND_DATA | FILE_WRITE_EA | FILE_WRITE_ATTRIBUTES |
+        FILE_DELETE_CHILD | DELETE | WRITE_DAC | WRITE_OWNER | GENERIC_WRITE | GENERIC_ALL;
+    PSECURITY_DESCRIPTOR pSecurityDescriptor = NULL;
+    SECURITY_DESCRIPTOR_CONTROL control = 0;
+    DWORD revision = 0;
+    PSID pOwner = NULL;
+    PACL pDacl = NULL;
+    BOOL bTrusted = FALSE;
+    DWORD i;
+
+    if (ERROR_SUCCESS != pfnGetSecurityInfo(hFile, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION,
+        &pOwner, NULL, &pDacl, NULL, &pSecurityDescriptor))
+    {
+        return FALSE;
+    }
+
+    // A NULL DACL grants everyone full access
+    bTrusted = NULL != pOwner && NULL != pDacl && gfnInternalIsTrustedSid(pOwner) &&
+        pfnGetSecurityDescriptorControl(pSecurityDescriptor, &control, &revision) && (control & SE_DACL_PROTECTED);
+    for (i = 0; bTrusted && i < pDacl->AceCount; ++i)
+    {
+        ACE_HEADER* pAce = NULL;
+        if (!pfnGetAce(pDacl, i, (LPVOID*)&pAce))
+        {
+            bTrusted = FALSE;
+        }
+        else if (ACCESS_ALLOWED_ACE_TYPE == pAce->AceType)
+        {
+            ACCESS_ALLOWED_ACE* pAllowed = (ACCESS_ALLOWED_ACE*)pAce;
+            bTrusted = !(pAllowed->Mask & writeAccess) || gfnInternalIsTrustedSid((PSID)&pAllowed->SidStart);
+        }
+        else
+        {
+            // Deny entries only take access away, anything more exotic is not expected here
+            bTrusted = ACCESS_DENIED_ACE_TYPE == pAce->AceType;
+        }
+    }
+
+    SafeLocalFree(pSecurityDescriptor);
+    return bTrusted;
+}
+
+// A link could point anywhere, only regular files and directories are used
+static BOOL gfnInternalIsPlainObject(HANDLE hFile, BOOL bDirectory)
+{
+    BY_HANDLE_FILE_INFORMATION info;
+    return GetFileInformationByHandle(hFile, &info) &&
+        !(info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+        !(info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == !bDirectory;
+}
+
+// Whether hFile was opened at path, and no link on the way led somewhere else
+static BOOL gfnInternalIsAtPath(HANDLE hFile, LPCWSTR path)
+{
+    WCHAR finalPath[MAX_PATH + 4];
+    const DWORD length = GetFinalPathNameByHandleW(hFile, finalPath, MAX_PATH + 4, FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+
+    // Comes back as \\?\C:\...
+    return length > 4 && length < MAX_PATH + 4 &&
+        CSTR_EQUAL == CompareStringOrdinal(finalPath + 4, -1, path, -1, TRUE);
+}
+
+static BOOL gfnInternalReadPersistentCache(LPCWSTR path, PersistentCache* pCache)
+{
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    LARGE_INTEGER size;
+    DWORD bytesRead = 0;
+    BOOL bResult = FALSE;
+
+    // Share delete so the service can replace the file while it's being read
+    hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    if (INVALID_HANDLE_VALUE == hFile)
+    {
+        return FALSE;
+    }
+
+    bResult = gfnInternalIsPlainObject(hFile, FALSE) && gfnInternalIsPersistentCacheTrusted(hFile) &&
+        GetFileSizeEx(hFile, &size) && sizeof(*pCache) == size.QuadPart &&
+        ReadFile(hFile, pCache, sizeof(*pCache), &bytesRead, NULL) && sizeof(*pCache) == bytesRead &&
+        PERSISTENT_CACHE_MAGIC == pCache->magic && PERSISTENT_CACHE_VERSION == pCache->version;
+
+    SafeCloseHandle(hFile);
+    return bResult;
+}
+
+static BOOL gfnInternalGetPersistentCacheKey(HANDLE hFile, PersistentCacheEntry* pKey)
+{
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(hFile, &info))
+    {
+        return FALSE;
+    }
+
+    memset(pKey, 0, sizeof(*pKey));
+    pKey->volumeSerialNumber = info.dwVolumeSerialNumber;
+    pKey->fileIndexHigh = info.nFileIndexHigh;
+    pKey->fileIndexLow = info.nFileIndexLow;
+    pKey->fileSize = ((ULONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    pKey->lastWriteTime = ((ULONGLONG)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+    return TRUE;
+}
+
+static BOOL gfnInternalIsSameFile(const PersistentCacheEntry* pEntry, const PersistentCacheEntry* pKey)
+{
+    return pEntry->volumeSerialNumber == pKey->volumeSerialNumber &&
+        pEntry->fileIndexHigh == pKey->fileIndexHigh &&
+        pEntry->fileIndexLow == pKey->fileIndexLow &&
+        pEntry->fileSize == pKey->fileSize &&
+        pEntry->lastWriteTime == pKey->lastWriteTime;
+}
+
+// The slot holding the file of pKey, or for an insert the slot to replace. NULL when the
+// file isn't in the table.
+static PersistentCacheEntry* gfnInternalFindPersistentCacheSlot(PersistentCache* pCache, const PersistentCacheEntry* pKey, BOOL bForInsert)
+{
+    // FNV-1a over the parts of the identity that never change for a file
+    const DWORD identity[3] = { pKey->volumeSerialNumber, pKey->fileIndexHigh, pKey->fileIndexLow };
+    const BYTE* pBytes = (const BYTE*)identity;
+    PersistentCacheEntry* pVictim = NULL;
+    DWORD hash = 2166136261u;
+    DWORD i;
+
+    for (i = 0; i < sizeof(identity); ++i)
+    {
+        hash = (hash ^ pBytes[i]) * 16777619u;
+    }
+
+    for (i = 0; i < PERSISTENT_CACHE_PROBES; ++i)
+    {
+        PersistentCacheEntry* pEntry = &pCache->entries[(hash + i) & (PERSISTENT_CACHE_SLOTS - 1)];
+        if (0 != pEntry->verifiedAt && gfnInternalIsSameFile(pEntry, pKey))
+        {
+            return pEntry;
+        }
+        if (NULL == pVictim || pEntry->verifiedAt < pVictim->verifiedAt)
+        {
+            pVictim = pEntry;
+        }
+    }
+    return bForInsert ? pVictim : NULL;
+}
+
+static ULONGLONG gfnInternalGetSystemTime(void)
+{
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return ((ULONGLONG)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
+
+static BOOL gfnInternalIsImageVerifiedPersistently(HANDLE hFile, const GfnImageDigest* pDigest, SignatureType signatureType)
+{
+    WCHAR path[MAX_PATH];
+    PersistentCacheEntry key;
+    PersistentCache* pCache = NULL;
+    const PersistentCacheEntry* pEntry = NULL;
+    ULONGLONG now;
+    BOOL bFound = FALSE;
+
+    if (gfnVerificationCacheOff == s_persistentCacheMode ||
+        !gfnInternalGetPersistentCacheKey(hFile, &key) ||
+        !gfnInternalLoadSecurityApis() ||
+        !gfnInternalGetPersistentCachePath(path, MAX_PATH) ||
+        NULL == (pCache = (PersistentCache*)LocalAlloc(LPTR, sizeof(PersistentCache))))
+    {
+        return FALSE;
+    }
+
+    if (gfnInternalReadPersistentCache(path, pCache) &&
+        NULL != (pEntry = gfnInternalFindPersistentCacheSlot(pCache, &key, FALSE)))
+    {
+        now = gfnInternalGetSystemTime();
+        bFound = (DWORD)signatureType == pEntry->signatureType &&
+            pEntry->verifiedAt <= now && now - pEntry->verifiedAt < PERSISTENT_CACHE_TTL &&
+            0 == memcmp(&pEntry->digest, pDigest, sizeof(*pDigest));
+    }
+
+    SafeLocalFree(pCache);
+    return bFound;
+}
+
+// Opens the cache directory, creating it when it's missing. The handle doesn't share delete, so
+// the directory can't be renamed or replaced by a link while the writer holds it.
+static HANDLE gfnInternalOpenPersistentCacheDirectory(LPWSTR directory, size_t directoryLength)
+{
+    SECURITY_ATTRIBUTES securityAttributes = { sizeof(SECURITY_ATTRIBUTES), NULL, FALSE };
+    HANDLE hDirectory = INVALID_HANDLE_VALUE;
+
+    if (!gfnInternalGetModule(L"shell32.dll", hModShell32) ||
+        !gfnInternalGetProc(hModShell32, "SHCreateDirectoryExW", pfnSHCreateDirectoryExW) ||
+        !gfnInternalGetPersistentCacheParent(directory, directoryLength))
+    {
+        return INVALID_HANDLE_VALUE;
+    }
+
+    // The parents get the usual inherited access, users may need to write there
+    pfnSHCreateDirectoryExW(NULL, directory, NULL);
+
+    if (FAILED(StringCchCatW(directory, directoryLength, L"\\" PERSISTENT_CACHE_DIRECTORY)) ||
+        !pfnConvertStringSecurityDescriptorToSecurityDescriptorW(PERSISTENT_CACHE_DIR_SDDL, SDDL_REVISION_1,
+            &securityAttributes.lpSecurityDescriptor, NULL))
+    {
+        return INVALID_HANDLE_VALUE;
+    }
+    CreateDirectoryW(directory, &securityAttributes);
+    SafeLocalFree(securityAttributes.lpSecurityDescriptor);
+
+    // Whoever created it, the checks below decide whether it's used
+    hDirectory = CreateFileW(directory, FILE_TRAVERSE | FILE_ADD_FILE | FILE_READ_ATTRIBUTES | READ_CONTROL,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    if (INVALID_HANDLE_VALUE != hDirectory &&
+        !(gfnInternalIsPlainObject(hDirectory, TRUE) &&
+          gfnInternalIsAtPath(hDirectory, directory) &&
+          gfnInternalIsPersistentCacheTrusted(hDirectory)))
+    {
+        SafeCloseHandle(hDirectory);
+    }
+    return hDirectory;
+}
+
+static BOOL gfnInternalDeleteOnClose(HANDLE hFile)
+{
+    FILE_DISPOSITION_INFO disposition = { TRUE };
+    return SetFileInformationByHandle(hFile, FileDispositionInfo, &disposition, sizeof(disposition));
+}
+
+// Renames hFile to the cache file name in the directory of hDirectory
+static BOOL gfnInternalReplacePersistentCache(HANDLE hFile, HANDLE hDirectory)
+{
+    DWORD_PTR buffer[(sizeof(FILE_RENAME_INFO) + sizeof(PERSISTENT_CACHE_FILE_NAME)) / sizeof(DWORD_PTR) + 1];
+    FILE_RENAME_INFO* pRenameInfo = (FILE_RENAME_INFO*)buffer;
+
+    memset(buffer, 0, sizeof(buffer));
+    pRenameInfo->ReplaceIfExists = TRUE;
+    pRenameInfo->RootDirectory = hDirectory;
+    pRenameInfo->FileNameLength = sizeof(PERSISTENT_CACHE_FILE_NAME) - sizeof(WCHAR);
+    memcpy(pRenameInfo->FileName, PERSISTENT_CACHE_FILE_NAME, sizeof(PERSISTENT_CACHE_FILE_NAME));
+    return SetFileInformationByHandle(hFile, FileRenameInfo, pRenameInfo, sizeof(buffer));
+}
+
+static void gfnInternalPersistVerifiedImage(HANDLE hFile, const GfnImageDigest* pDigest, SignatureType signatureType)
+{
+    WCHAR directory[MAX_PATH];
+    WCHAR path[MAX_PATH];
+    WCHAR tempPath[MAX_PATH];
+    SECURITY_ATTRIBUTES securityAttributes = { sizeof(SECURITY_ATTRIBUTES), NULL, FALSE };
+    PersistentCacheEntry key;
+    PersistentCache* pCache = NULL;
+    PersistentCacheEntry* pEntry = NULL;
+    HANDLE hDirectory = INVALID_HANDLE_VALUE;
+    HANDLE hCacheFile = INVALID_HANDLE_VALUE;
+    DWORD bytesWritten = 0;
+    BOOL bWritten = FALSE;
+    DWORD lastError = GetLastError();
+
+    if (gfnVerificationCacheReadWrite != s_persistentCacheMode ||
+        !gfnInternalGetPersistentCacheKey(hFile, &key) ||
+        !gfnInternalLoadSecurityApis() ||
+        NULL == (pCache = (PersistentCache*)LocalAlloc(LPTR, sizeof(PersistentCache))))
+    {
+        SetLastError(lastError);
+        return;
+    }
+
+    AcquireSRWLockExclusive(&s_persistentCacheWriteLock);
+
+    hDirectory = gfnInternalOpenPersistentCacheDirectory(directory, MAX_PATH);
+    if (INVALID_HANDLE_VALUE == hDirectory ||
+        FAILED(StringCchPrintfW(path, MAX_PATH, L"%s\\" PERSISTENT_CACHE_FILE_NAME, directory)) ||
+        FAILED(StringCchPrintfW(tempPath, MAX_PATH, L"%s.%lu.tmp", path, GetCurrentProcessId())))
+    {
+        goto persistVerifiedImageDone;
+    }
+
+    if (!gfnInternalReadPersistentCache(path, pCache))
+    {
+        memset(pCache, 0, sizeof(*pCache));
+        pCache->magic = PERSISTENT_CACHE_MAGIC;
+        pCache->version = PERSISTENT_CACHE_VERSION;
+    }
+    pEntry = gfnInternalFindPersistentCacheSlot(pCache, &key, TRUE);
+    *pEntry = key;
+    pEntry->digest = *pDigest;
+    pEntry->signatureType = (DWORD)signatureType;
+    pEntry->verifiedAt = gfnInternalGetSystemTime();
+
+    if (!pfnConvertStringSecurityDescriptorToSecurityDescriptorW(PERSISTENT_CACHE_SDDL, SDDL_REVISION_1,
+        &securityAttributes.lpSecurityDescriptor, NULL))
+    {
+        goto persistVerifiedImageDone;
+    }
+
+    // Written next to the cache and renamed over it, so readers never see a partial table. Only
+    // this service writes to the directory, a file left at the temporary path is from one of its
+    // earlier runs and is removed through its handle.
+    hCacheFile = CreateFileW(tempPath, DELETE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    if (INVALID_HANDLE_VALUE != hCacheFile)
+    {
+        if (gfnInternalIsAtPath(hCacheFile, tempPath))
+        {
+            gfnInternalDeleteOnClose(hCacheFile);
+        }
+        SafeCloseHandle(hCacheFile);
+    }
+    hCacheFile = CreateFileW(tempPath, GENERIC_WRITE | DELETE, 0, &securityAttributes, CREATE_NEW,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    SafeLocalFree(securityAttributes.lpSecurityDescriptor);
+    if (INVALID_HANDLE_VALUE != hCacheFile)
+    {
+        bWritten = gfnInternalIsAtPath(hCacheFile, tempPath) &&
+            WriteFile(hCacheFile, pCache, sizeof(*pCache), &bytesWritten, NULL) && sizeof(*pCache) == bytesWritten &&
+            gfnInternalReplacePersistentCache(hCacheFile, hDirectory);
+        if (!bWritten)
+        {
+            gfnInternalDeleteOnClose(hCacheFile);
+        }
+        SafeCloseHandle(hCacheFile);
+    }
+
+persistVerifiedImageDone:
+    SafeCloseHandle(hDirectory);
+    ReleaseSRWLockExclusive(&s_persistentCacheWriteLock);
+
+    SafeLocalFree(pCache);
+    SetLastError(lastError);
+}
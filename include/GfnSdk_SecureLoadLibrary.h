@@ -96,6 +96,38 @@ BOOL gfnCheckLibraryGfnSignatureA(LPCSTR filePath);
 BOOL gfnCheckLibraryNvSignatureW(LPCWSTR filePath);
 BOOL gfnCheckLibraryNvSignatureA(LPCSTR filePath);
 
+/// Ways a process can use the verification results shared through
+/// ProgramData\\NVIDIA Corporation\\GfnRuntimeSdk\\Verification\\VerificationCache.bin
+typedef enum GfnVerificationCacheMode
+{
+    gfnVerificationCacheOff,        ///< Default, verify every library within this process
+    gfnVerificationCacheRead,       ///< Skip the certificate checks for libraries the service verified
+    gfnVerificationCacheReadWrite   ///< Also record libraries this process verified, LocalSystem only
+} GfnVerificationCacheMode;
+
+///
+/// @par Description
+/// Opts in to sharing signature verification results between processes
+///
+/// @par Environment
+/// Client
+///
+/// @par Usage
+/// Call before loading or checking libraries. The service calls this with
+/// gfnVerificationCacheReadWrite, the processes that start after it with gfnVerificationCacheRead,
+/// so they recognize a library the service verified by its file identity and digest instead of
+/// walking its certificate chain again. Results are trusted for a day and only from a cache file
+/// that nobody but LocalSystem and Administrators can write.
+///
+/// @param mode                     - How this process uses the shared results
+///
+/// @note
+/// In case of failure, call GetLastError for additional information about the error:
+/// - ERROR_ACCESS_DENIED           - gfnVerificationCacheReadWrite outside of LocalSystem
+/// - ERROR_INVALID_PARAMETER       - mode is not a GfnVerificationCacheMode value
+///
+BOOL gfnSetPersistentVerificationCache(GfnVerificationCacheMode mode);
+
 #ifdef UNICODE
 #define gfnSecureLoadClientLibrary gfnSecureLoadClientLibraryW
 #define gfnSecureLoadCloudLibrary gfnSecureLoadCloudLibraryW
@@ -7,6 +7,7 @@
 #include <winsock2.h>
 
 #include "gfn_sdk_demo/client_impl.h"
+#include "gfn_sdk_demo/service_connection.h"
 #include "shared/app_factory.h"
 #include "shared/browser_util.h"
 #include "shared/resource_util.h"
@@ -175,6 +176,9 @@ namespace message_router {
 namespace shared {
 
     CefRefPtr<CefApp> CreateBrowserProcessApp() {
+        // Connect to GfnSdkSampleService while CEF initializes, the page runs the secure cloud
+        // check right after it loads
+        ServiceConnection::instance().prefetch();
         return new message_router::BrowserApp();
     }
 
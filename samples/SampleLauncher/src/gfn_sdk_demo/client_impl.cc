@@ -139,7 +139,7 @@ void Client::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
     message_handler_.reset();
     message_router_ = NULL;
    
-    GfnShutdownSdk();
+    GfnSdkHelperShutdown();
     shared::g_browserHost = NULL;
   }
 
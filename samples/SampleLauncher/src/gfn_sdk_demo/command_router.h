@@ -0,0 +1,301 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#ifndef GFN_SDK_COMMAND_ROUTER_H_
+#define GFN_SDK_COMMAND_ROUTER_H_
+
+#include "include/cef_values.h"
+#include "include/wrapper/cef_message_router.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Dispatches launcher queries by command name. The command table is laid out at compile time
+// around a perfect hash of the names, so finding a handler costs one hash and one string
+// compare however many commands are registered. Every handler declares the request values it
+// takes as a parameter struct, which is decoded from the request before the handler runs.
+//
+//     struct TitleParams
+//     {
+//         std::string appId;
+//         static constexpr auto fields() { return std::make_tuple(CommandRouter::field("appId", &TitleParams::appId)); }
+//     };
+//     static void onTitle(const CommandRouter::Query& query, TitleParams params);
+//
+//     static constexpr auto s_commands = CommandRouter::makeTable(std::array{
+//         CommandRouter::command<&onTitle>("TITLE"),
+//     });
+namespace CommandRouter
+{
+    // Passed to Failure() when the request values don't match the handler's parameters
+    static const int INVALID_PARAMETERS = -1;
+
+    // The parts of a query other than its parameters
+    struct Query
+    {
+        CefRefPtr<CefBrowser> browser;
+        CefRefPtr<CefFrame> frame;
+        int64 query_id;
+        bool persistent;
+        CefRefPtr<CefMessageRouterBrowserSide::Callback> callback;
+    };
+
+    // Request value decoded into a parameter struct member. Members of type std::optional may be
+    // left out of the request, all others are required.
+    // Supported types: bool, int, std::string, std::vector<std::string>
+    template <typename Params, typename T>
+    struct Field
+    {
+        const char* name;
+        T Params::* member;
+    };
+
+    template <typename Params, typename T>
+    constexpr Field<Params, T> field(const char* name, T Params::* member)
+    {
+        return { name, member };
+    }
+
+    // Parameters of commands that take none
+    struct NoParams
+    {
+        static constexpr auto fields() { return std::make_tuple(); }
+    };
+
+    namespace detail
+    {
+        inline bool decode(CefRefPtr<CefDictionaryValue> dict, const CefString& key, bool& value)
+        {
+            if (dict->GetType(key) != VTYPE_BOOL)
+            {
+                return false;
+            }
+            value = dict->GetBool(key);
+            return true;
+        }
+
+        inline bool decode(CefRefPtr<CefDictionaryValue> dict, const CefString& key, int& value)
+        {
+            if (dict->GetType(key) != VTYPE_INT)
+            {
+                return false;
+            }
+            value = dict->GetInt(key);
+            return true;
+        }
+
+        inline bool decode(CefRefPtr<CefDictionaryValue> dict, const CefString& key, std::string& value)
+        {
+            if (dict->GetType(key) != VTYPE_STRING)
+            {
+                return false;
+            }
+            value = dict->GetString(key).ToString();
+            return true;
+        }
+
+        inline bool decode(CefRefPtr<CefDictionaryValue> dict, const CefString& key, std::vector<std::string>& value)
+        {
+            if (dict->GetType(key) != VTYPE_LIST)
+            {
+                return false;
+            }
+
+            CefRefPtr<CefListValue> list = dict->GetList(key);
+            value.resize(list->GetSize());
+            for (size_t i = 0; i < value.size(); i++)
+            {
+                if (list->GetType(i) != VTYPE_STRING)
+                {
+                    return false;
+                }
+                value[i] = list->GetString(i).ToString();
+            }
+            return true;
+        }
+
+        template <typename T>
+        bool decode(CefRefPtr<CefDictionaryValue> dict, const CefString& key, std::optional<T>& value)
+        {
+            if (dict->GetType(key) == VTYPE_INVALID)
+            {
+                value.reset();
+                return true;
+            }
+            return decode(dict, key, value.emplace());
+        }
+
+        template <typename Params, typename T>
+        bool decodeField(CefRefPtr<CefDictionaryValue> dict, const Field<Params, T>& f, Params& params, std::string& error)
+        {
+            if (decode(dict, f.name, params.*f.member))
+            {
+                return true;
+            }
+            error = std::string("Missing or invalid \"") + f.name + "\" parameter";
+            return false;
+        }
+
+        template <typename Params>
+        bool decodeParams(CefRefPtr<CefDictionaryValue> dict, Params& params, std::string& error)
+        {
+            return std::apply([&](const auto&... fields)
+            {
+                return (decodeField(dict, fields, params, error) && ... && true);
+            }, Params::fields());
+        }
+
+        template <typename Handler>
+        struct HandlerParams;
+
+        template <typename Params>
+        struct HandlerParams<void (*)(const Query&, Params)>
+        {
+            using type = Params;
+        };
+
+        template <auto Handler>
+        void invoke(const Query& query, CefRefPtr<CefDictionaryValue> request)
+        {
+            typename HandlerParams<decltype(Handler)>::type params{};
+            std::string error;
+            if (!decodeParams(request, params, error))
+            {
+                query.callback->Failure(INVALID_PARAMETERS, error);
+                return;
+            }
+            Handler(query, std::move(params));
+        }
+
+        // FNV-1a, seeded so the table can search for a seed without collisions
+        constexpr uint32_t hash(std::string_view name, uint32_t seed)
+        {
+            uint32_t h = 2166136261u ^ seed;
+            for (char c : name)
+            {
+                h ^= static_cast<uint8_t>(c);
+                h *= 16777619u;
+            }
+            return h ^ (h >> 16);
+        }
+
+        // A quarter full table takes only a few seeds to come out collision-free
+        constexpr size_t tableSize(size_t commandCount)
+        {
+            size_t size = 1;
+            while (size < commandCount * 4)
+            {
+                size <<= 1;
+            }
+            return size;
+        }
+    }
+
+    struct Command
+    {
+        std::string_view name;
+        void (*invoke)(const Query&, CefRefPtr<CefDictionaryValue>) = nullptr;
+    };
+
+    // Registers Handler, a void(const Query&, Params) function, under name
+    template <auto Handler>
+    constexpr Command command(std::string_view name)
+    {
+        return { name, &detail::invoke<Handler> };
+    }
+
+    template <size_t N>
+    class Table
+    {
+    public:
+        static constexpr size_t SIZE = detail::tableSize(N);
+
+        constexpr explicit Table(const std::array<Command, N>& commands)
+        {
+            // Settle on the first seed that sends every name to its own slot. Running out of seeds
+            // (or a name registered twice) throws, which turns into a compile error.
+            for (uint32_t seed = 0; seed < 0x10000; seed++)
+            {
+                std::array<bool, SIZE> used{};
+                bool collision = false;
+                for (size_t i = 0; i < N && !collision; i++)
+                {
+                    const size_t slot = detail::hash(commands[i].name, seed) & (SIZE - 1);
+                    collision = used[slot];
+                    used[slot] = true;
+                }
+
+                if (!collision)
+                {
+                    m_seed = seed;
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        m_slots[detail::hash(commands[i].name, seed) & (SIZE - 1)] = commands[i];
+                    }
+                    return;
+                }
+            }
+            throw "No collision-free seed for the command names";
+        }
+
+        // Returns nullptr for names that were not registered
+        const Command* find(std::string_view name) const
+        {
+            const Command& slot = m_slots[detail::hash(name, m_seed) & (SIZE - 1)];
+            return slot.invoke != nullptr && slot.name == name ? &slot : nullptr;
+        }
+
+        // Decodes the parameters and runs the handler, returns false for unknown commands
+        bool dispatch(std::string_view name, const Query& query, CefRefPtr<CefDictionaryValue> request) const
+        {
+            const Command* command = find(name);
+            if (command == nullptr)
+            {
+                return false;
+            }
+            command->invoke(query, request);
+            return true;
+        }
+
+    private:
+        uint32_t m_seed = 0;
+        std::array<Command, SIZE> m_slots{};
+    };
+
+    template <size_t N>
+    constexpr Table<N> makeTable(const std::array<Command, N>& commands)
+    {
+        return Table<N>(commands);
+    }
+}
+
+#endif
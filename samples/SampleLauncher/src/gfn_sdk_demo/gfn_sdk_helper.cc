@@ -26,41 +26,145 @@
 // Copyright (c) 2019-2021 NVIDIA Corporation. All rights reserved.
 
 #include "gfn_sdk_demo/gfn_sdk_helper.h"
+#include "gfn_sdk_demo/command_router.h"
+#include "gfn_sdk_demo/json_writer.h"
+#include "gfn_sdk_demo/service_connection.h"
 
 #include "include/cef_parser.h"
+#include "include/cef_task.h"
 #include "shared/client_util.h"
 #include "shared/defines.h"
 #include "shared/main.h"
 #include "GfnRuntimeSdk_Wrapper.h"  //Helper functions that wrap Library-based APIs
+#include "GfnRuntimeSdk_Async.h"    //Futures over the asynchronous wrapper APIs
+#include "GfnSdk_SecureLoadLibrary.h"
 #include "shellapi.h"
+#include <algorithm>
 #include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 #include "client.h"
+#include "thread_pool.h"
 
-CefString GFN_SDK_INIT = "GFN_SDK_INIT";
-CefString GFN_SDK_SHUTDOWN = "GFN_SDK_SHUTDOWN";
-CefString GFN_SDK_STREAM_ACTION = "GFN_SDK_STREAM_ACTION";
-CefString GFN_SDK_IS_RUNNING_IN_CLOUD = "GFN_SDK_IS_RUNNING_IN_CLOUD";
-CefString GFN_SDK_IS_RUNNING_IN_CLOUD_SECURE = "GFN_SDK_IS_RUNNING_IN_CLOUD_SECURE";
-CefString GFN_SDK_GET_CLIENT_IP = "GFN_SDK_GET_CLIENT_IP";
-CefString GFN_SDK_GET_CLIENT_COUNTRY_CODE = "GFN_SDK_GET_CLIENT_COUNTRY_CODE";
-CefString GFN_SDK_GET_CLIENT_LANGUAGE_CODE = "GFN_SDK_GET_CLIENT_LANGUAGE_CODE";
-CefString GFN_SDK_REGISTER_STREAM_STATUS_CALLBACK = "GFN_SDK_REGISTER_STREAM_STATUS_CALLBACK";
-CefString GFN_SDK_IS_TITLE_AVAILABLE = "GFN_SDK_IS_TITLE_AVAILABLE";
-CefString GFN_SDK_GET_AVAILABLE_TITLES = "GFN_SDK_GET_AVAILABLE_TITLES";
-CefString GFN_SDK_REQUEST_ACCESS_TOKEN = "GFN_SDK_REQUEST_ACCESS_TOKEN";
-CefString GET_TCP_PORT = "GET_TCP_PORT";
-CefString GET_CLIENT_INFO = "GFN_SDK_GET_CLIENT_INFO";
-CefString GFN_SDK_REGISTER_CLIENT_INFO_CALLBACK = "GFN_SDK_REGISTER_CLIENT_INFO_CALLBACK";
-CefString GET_OVERRIDE_URI = "GET_OVERRIDE_URI";
-
-static CefString DictToJson(CefRefPtr<CefDictionaryValue> dict)
-{
-    auto json = CefValue::Create();
-    json->SetDictionary(dict);
-    return CefWriteJSON(json, JSON_WRITER_DEFAULT);
+// Starting a stream may have to download and install GeForce NOW first
+static const unsigned int STREAM_START_TIMEOUT_MS = 5 * 60 * 1000;
+static const unsigned int STREAM_STOP_TIMEOUT_MS = 30 * 1000;
+
+// Runs a std::function as a CEF task
+class FunctionTask : public CefTask
+{
+public:
+    explicit FunctionTask(std::function<void()> fn) : m_fn(std::move(fn)) {}
+
+    void Execute() override
+    {
+        m_fn();
+    }
+
+private:
+    std::function<void()> m_fn;
+
+    IMPLEMENT_REFCOUNTING(FunctionTask);
+};
+
+// Executor for GfnRuntimeSdk futures, query callbacks are answered on the UI thread
+static void postToUiThread(std::function<void()> task)
+{
+    CefPostTask(TID_UI, new FunctionTask(std::move(task)));
 }
 
-static CefString GfnErrorToString(GfnError err)
+// Workers for the SDK and service calls that can block, such as initialization or connecting
+// to GfnSdkSampleService, so the browser UI thread keeps pumping while they run
+static const size_t SDK_WORKER_COUNT = 2;
+
+static SampleService::ThreadPool& sdkWorkers()
+{
+    static SampleService::ThreadPool s_workers([]() {
+        SampleService::ThreadPool::config cfg;
+        cfg.threads = SDK_WORKER_COUNT;
+        return cfg;
+    }());
+    return s_workers;
+}
+
+// Held exclusively while the SDK is initialized or shut down, shared by every other call
+static std::shared_mutex s_sdkLifetimeLock;
+
+// Passed to Failure() for queries that arrive after GfnSdkHelperShutdown
+static const int SDK_SHUT_DOWN = -2;
+
+// Runs a query handler on a worker, holding the SDK lifetime lock the way the handler needs it.
+// Once the helper has shut down the workers are gone, so the query is failed right away.
+static void runOnWorker(CefRefPtr<CefMessageRouterBrowserSide::Callback> callback,
+    bool changesSdkLifetime, std::function<void()> handler)
+{
+    const bool submitted = sdkWorkers().submit([changesSdkLifetime, handler = std::move(handler)]()
+    {
+        if (changesSdkLifetime)
+        {
+            std::unique_lock<std::shared_mutex> lock(s_sdkLifetimeLock);
+            handler();
+        }
+        else
+        {
+            std::shared_lock<std::shared_mutex> lock(s_sdkLifetimeLock);
+            handler();
+        }
+    });
+
+    if (!submitted)
+    {
+        callback->Failure(SDK_SHUT_DOWN, "The GFN SDK has been shut down");
+    }
+}
+
+// Stream actions being waited for on a worker, GfnSdkHelperShutdown cancels them rather than
+// waiting out their timeouts while it holds up browser shutdown
+static std::mutex s_streamActionsMutex;
+static std::list<std::function<void()>> s_streamActionCancels;
+static bool s_streamActionsCanceled = false;
+
+// Waits for a stream action, run from a worker so the shared lifetime lock is held throughout
+template <typename T>
+static void awaitStreamAction(const GfnRuntimeSdk::Future<T>& action)
+{
+    std::list<std::function<void()>>::iterator entry;
+    {
+        std::lock_guard<std::mutex> lock(s_streamActionsMutex);
+        if (s_streamActionsCanceled)
+        {
+            action.cancel();
+        }
+        entry = s_streamActionCancels.insert(s_streamActionCancels.end(), [action]() { action.cancel(); });
+    }
+
+    action.wait();
+
+    std::lock_guard<std::mutex> lock(s_streamActionsMutex);
+    s_streamActionCancels.erase(entry);
+}
+
+// Query callbacks belong to the message router, which lives on the UI thread
+static void respond(CefRefPtr<CefMessageRouterBrowserSide::Callback> callback, const CefString& response)
+{
+    postToUiThread([callback, response]() { callback->Success(response); });
+}
+
+static void sendStreamActionResponse(CefRefPtr<CefMessageRouterBrowserSide::Callback> callback,
+    bool actionSuccess, const std::string& msg)
+{
+    JsonWriter json(responseBuffer());
+    json.field("actionSuccess", actionSuccess);
+    json.field("errorMessage", msg);
+
+    CefString response = json.finish();
+    callback->Success(response);
+}
+
+static const char* GfnErrorToString(GfnError err)
 {
     switch (err)
     {
@@ -120,15 +224,150 @@ static void logGfnSdkData()
     }
 }
 
+// Push events are held back and merged for this long by default, about one display frame
+static const int PUSH_INTERVAL_DEFAULT_MS = 16;
+static const int PUSH_INTERVAL_MAX_MS = 1000;
+
+// Stream status changes that are kept between two pushes, older ones are dropped
+static const size_t STREAM_STATUS_HISTORY = 8;
+
+// Delivers SDK events to a persistent query without sending one message per event. Events are
+// merged into State on whatever thread the SDK raises them, and the first event after a push
+// schedules the next one on the UI thread an interval later, so the page sees at most one
+// message per interval per channel.
+//
+// State provides:
+//     bool empty() const;
+//     void write(JsonWriter& json) const;
+// and starts out empty when value-initialized.
+template <typename State>
+class PushChannel
+{
+public:
+    struct Counters
+    {
+        uint64_t merged = 0;   // events folded into one already pending
+        uint64_t dropped = 0;  // events that were pushed out of a full history
+    };
+
+    void attach(CefRefPtr<CefMessageRouterBrowserSide::Callback> callback, int intervalMs)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callback = callback;
+        m_intervalMs = intervalMs;
+    }
+
+    void detach()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callback = nullptr;
+        m_pending = State();
+    }
+
+    // update(State&, Counters&) merges one event into the pending state
+    template <typename F>
+    void post(F&& update)
+    {
+        int delayMs = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_callback)
+            {
+                return;
+            }
+
+            update(m_pending, m_counters);
+            if (m_flushScheduled)
+            {
+                return;
+            }
+            m_flushScheduled = true;
+            delayMs = m_intervalMs;
+        }
+
+        CefPostDelayedTask(TID_UI, new FunctionTask([this]() { flush(); }), delayMs);
+    }
+
+private:
+    void flush()
+    {
+        State state;
+        Counters counters;
+        CefRefPtr<CefMessageRouterBrowserSide::Callback> callback;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            state = m_pending;
+            m_pending = State();
+            counters = m_counters;
+            callback = m_callback;
+            m_flushScheduled = false;
+        }
+
+        if (!callback || state.empty())
+        {
+            return;
+        }
+
+        JsonWriter json(responseBuffer());
+        state.write(json);
+        json.field("merged", counters.merged);
+        json.field("dropped", counters.dropped);
+        callback->Success(json.finish());
+    }
+
+    std::mutex m_mutex;
+    CefRefPtr<CefMessageRouterBrowserSide::Callback> m_callback;
+    int m_intervalMs = PUSH_INTERVAL_DEFAULT_MS;
+    bool m_flushScheduled = false;
+    State m_pending{};
+    Counters m_counters;
+};
+
+// Every status change since the last push, so the page can still react to short-lived states
+struct StreamStatusState
+{
+    GfnStreamStatus history[STREAM_STATUS_HISTORY];
+    size_t count = 0;
+
+    bool empty() const { return count == 0; }
+
+    void write(JsonWriter& json) const
+    {
+        json.field("status", GfnStreamStatusToString(history[count - 1]));
+        json.beginArray("history");
+        for (size_t i = 0; i < count; i++)
+        {
+            json.element(GfnStreamStatusToString(history[i]));
+        }
+        json.endArray();
+    }
+};
+
+// Only the latest value of each client info field matters
+struct ClientInfoState
+{
+    bool hasOs = false;
+    GfnOsType os{};
+
+    bool empty() const { return !hasOs; }
+
+    void write(JsonWriter& json) const
+    {
+        json.field("os", os);
+    }
+};
+
 // Callback function for handling stream status callbacks
 static void __stdcall handleStreamStatusCallback(GfnStreamStatus status, void* context);
 static void __stdcall handleClientInfoCallback(GfnClientInfoUpdateData* pClientUpdate, void* context);
-static CefMessageRouterBrowserSide::Callback* s_registerStreamStatusCallback = nullptr;
-static CefMessageRouterBrowserSide::Callback* s_registerNetworkStatusCallback = nullptr;
-static CefMessageRouterBrowserSide::Callback* s_registerClientInfoCallback = nullptr;
+static PushChannel<StreamStatusState> s_streamStatusPush;
+static PushChannel<ClientInfoState> s_clientInfoPush;
 
 static GfnError initGFN()
 {
+    // Reuse the signature checks GfnSdkSampleService already did for the SDK libraries
+    gfnSetPersistentVerificationCache(gfnVerificationCacheRead);
+
     GfnError err = GfnInitializeSdk(GfnDisplayLanguage::gfnDefaultLanguage);
     switch (err)
     {
@@ -146,135 +385,101 @@ static GfnError initGFN()
     return err;
 }
 
-bool checkSampleServiceRunningStatus() {
-    WCHAR* serviceName = L"GfnSdkSampleService";
-
-    SC_HANDLE sch = OpenSCManager(NULL, NULL, SC_MANAGER_ENUMERATE_SERVICE);
-    if (sch == NULL)
-    {
-        LOG(INFO) << "OpenSCManager failed";
-        return false;
-    }
-
-    SC_HANDLE svc = OpenService(sch, serviceName, SERVICE_QUERY_STATUS);
-    if (svc == NULL)
-    {
-        LOG(INFO) << "OpenService failed";
-        CloseServiceHandle(sch);
-        return false;
-    }
-
-    bool serviceRunning = false;
-    SERVICE_STATUS_PROCESS stat;
-    DWORD needed = 0;
-    BOOL ret = QueryServiceStatusEx(svc, SC_STATUS_PROCESS_INFO,
-        (BYTE*)&stat, sizeof stat, &needed);
-    if (ret == TRUE)
+void GfnSdkHelperShutdown()
+{
     {
-        if (stat.dwCurrentState == SERVICE_RUNNING)
+        std::lock_guard<std::mutex> lock(s_streamActionsMutex);
+        s_streamActionsCanceled = true;
+        for (const std::function<void()>& cancel : s_streamActionCancels)
         {
-            serviceRunning = true;
-            LOG(INFO) << serviceName << " is running";
+            cancel();
         }
-        else
-        {
-            LOG(INFO) << serviceName << " is NOT running";
-        }
-    }
-    else
-    {
-        LOG(INFO) << "QueryServiceStatusEx failed";
     }
 
-    CloseServiceHandle(svc);
-    CloseServiceHandle(sch);
-
-    return serviceRunning;
+    // Let queries that are already running finish before the SDK goes away underneath them
+    sdkWorkers().stop();
+    s_streamStatusPush.detach();
+    s_clientInfoPush.detach();
+    GfnShutdownSdk();
 }
 
-bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
-    CefRefPtr<CefFrame> frame,
-    int64 query_id,
-    const CefString& request,
-    bool persistent,
-    CefRefPtr<CefMessageRouterBrowserSide::Callback> callback)
+/**
+ * Query command for initializing the GFN SDK. Should be called once during launcher startup
+ * before making any other GFN SDK calls.
+ */
+static void onInit(const CommandRouter::Query& query, CommandRouter::NoParams)
 {
-    CefRefPtr<CefValue> requestValue = CefParseJSON(request, JSON_PARSER_RFC);
-
-    CefRefPtr<CefDictionaryValue> dict = requestValue->GetDictionary();
-    CefString command = dict->GetString("command");
-
-    /**
-     * Query command for initializing the GFN SDK. Should be called once during launcher startup
-     * before making any other GFN SDK calls.
-     */
-    if (command == GFN_SDK_INIT)
+    runOnWorker(query.callback, true, [callback = query.callback]()
     {
         GfnError err = initGFN();
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
+        JsonWriter json(responseBuffer());
         // gfnInitSuccessClientOnly is also success, and needs to be treated as such
-        response_dict->SetBool("success", (err == GfnError::gfnSuccess || err == GfnError::gfnInitSuccessClientOnly));
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
+        json.field("success", (err == GfnError::gfnSuccess || err == GfnError::gfnInitSuccessClientOnly));
+        json.field("errorMessage", GfnErrorToString(err));
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
-        return true;
-    }
-    /**
-     * Query command for shutting down the GFN SDK. Should be called once the SDK is no longer needed.
-     * Manually wire up into gfn_sdk.html where you want shutdown to occur.
-     */
-    if (command == GFN_SDK_SHUTDOWN)
+        respond(callback, json.finish());
+    });
+}
+
+/**
+ * Query command for shutting down the GFN SDK. Should be called once the SDK is no longer needed.
+ * Manually wire up into gfn_sdk.html where you want shutdown to occur.
+ */
+static void onShutdown(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, true, [callback = query.callback]()
     {
         GfnError err = GfnShutdownSdk();
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetBool("success", (err == GfnError::gfnSuccess));
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
+        JsonWriter json(responseBuffer());
+        json.field("success", (err == GfnError::gfnSuccess));
+        json.field("errorMessage", GfnErrorToString(err));
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
-        return true;
-    }
-    /**
-     * Calls into GFN SDK to determine whether the sample launcher is being executed inside
-     * an NVIDIA GeForce NOW game seat.
-     */
-    else if (command == GFN_SDK_IS_RUNNING_IN_CLOUD)
+        respond(callback, json.finish());
+    });
+}
+
+/**
+ * Calls into GFN SDK to determine whether the sample launcher is being executed inside
+ * an NVIDIA GeForce NOW game seat.
+ */
+static void onIsRunningInCloud(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         bool enabled = false;
         GfnError err = GfnIsRunningInCloud(&enabled);
         if (err != GfnError::gfnSuccess)
         {
             LOG(ERROR) << "Failed to get if running in cloud. Error: " << err;
-            return true;
+            return;
         }
 
         LOG(INFO) << "is enabled: " << enabled;
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetBool("enabled", enabled);
+        JsonWriter json(responseBuffer());
+        json.field("enabled", enabled);
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
 
-        return true;
-    }
-    /**
-    * Calls into GFN SDK securely to determine whether the sample launcher is being executed inside
-    * an NVIDIA GeForce NOW game seat. Call will only succeed if the sample launcher was executed
-    * as an elevated process. In a real-world implementation, this would be called via a separate
-    * OS-based/elevated process via an IPC mechanism.
-    */
-    else if (command == GFN_SDK_IS_RUNNING_IN_CLOUD_SECURE)
+/**
+* Calls into GFN SDK securely to determine whether the sample launcher is being executed inside
+* an NVIDIA GeForce NOW game seat. Call will only succeed if the sample launcher was executed
+* as an elevated process. In a real-world implementation, this would be called via a separate
+* OS-based/elevated process via an IPC mechanism.
+*/
+static void onIsRunningInCloudSecure(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         GfnIsRunningInCloudAssurance assurance = GfnIsRunningInCloudAssurance::gfnNotCloud;
-        CefString errorMessage;
+        std::string errorMessage;
 
-        bool isServiceRunning = checkSampleServiceRunningStatus();
+        const auto [isServiceRunning, status, gfnstatus, value] = ServiceConnection::instance().isRunningInCloudSecure();
         if (isServiceRunning)
         {
-            SampleService::ServiceClient client;
-            const auto [status, gfnstatus, value] = client.isRunningInCloudSecure();
             if (status == SampleService::status::success)
             {
                 GfnError err = static_cast<GfnError>(std::stoi(gfnstatus));
@@ -300,25 +505,69 @@ bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
 
         LOG(INFO) << "Cloud environment assurance value: " << assurance;
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetInt("assurance", assurance);
-        response_dict->SetString("errorMessage", errorMessage);
+        JsonWriter json(responseBuffer());
+        json.field("assurance", assurance);
+        json.field("errorMessage", errorMessage);
+
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+struct TitleAvailableParams
+{
+    std::optional<std::string> appId;
+    std::optional<std::vector<std::string>> appIds;
 
-        return true;
+    static constexpr auto fields()
+    {
+        return std::make_tuple(
+            CommandRouter::field("appId", &TitleAvailableParams::appId),
+            CommandRouter::field("appIds", &TitleAvailableParams::appIds));
     }
-    /**
-     * Calls into GFN SDK to determine if a specific title is available to stream right now
-     * directly from the NVIDIA GeForce NOW game seat.
-     */
-    else if (command == GFN_SDK_IS_TITLE_AVAILABLE)
+};
+
+/**
+ * Calls into GFN SDK to determine if a specific title is available to stream right now
+ * directly from the NVIDIA GeForce NOW game seat. Pass "appIds" instead of "appId" to check
+ * a whole list at once, the response then maps each id to its availability.
+ */
+static void onIsTitleAvailable(const CommandRouter::Query& query, TitleAvailableParams params)
+{
+    if (params.appIds)
     {
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        if (dict->HasKey("appId"))
+        runOnWorker(query.callback, false, [callback = query.callback, appIds = std::move(*params.appIds)]()
+        {
+            std::vector<const char*> ids(appIds.size());
+            for (size_t i = 0; i < appIds.size(); i++)
+            {
+                ids[i] = appIds[i].c_str();
+            }
+
+            // std::vector<bool> has no contiguous bool storage to hand to the wrapper
+            std::unique_ptr<bool[]> available(new bool[ids.size()]());
+            GfnError err = GfnAreTitlesAvailable(ids.data(), ids.size(), available.get());
+            if (err != GfnError::gfnSuccess)
+            {
+                LOG(ERROR) << "are titles available error: " << GfnErrorToString(err);
+            }
+
+            JsonWriter json(responseBuffer());
+            json.beginObject("available");
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                json.field(appIds[i], available[i]);
+            }
+            json.endObject();
+            json.field("errorMessage", GfnErrorToString(err));
+
+            respond(callback, json.finish());
+        });
+    }
+    else if (params.appId)
+    {
+        runOnWorker(query.callback, false, [callback = query.callback, pchappId = std::move(*params.appId)]()
         {
-            std::string pchappId = dict->GetString("appId").ToString();
             bool available = false;
             GfnError err = GfnIsTitleAvailable(pchappId.c_str(), &available);
             if (err != GfnError::gfnSuccess)
@@ -330,141 +579,177 @@ bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
                 LOG(INFO) << "is available to stream: " << available;
             }
 
-            response_dict = CefDictionaryValue::Create();
-            response_dict->SetBool("available", available);
-        }
-        else
-        {
-            response_dict->SetString("errorMessage", CefString("Bad arguments to CEF extension"));
-        }
+            JsonWriter json(responseBuffer());
+            json.field("available", available);
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
-        return true;
+            respond(callback, json.finish());
+        });
     }
-    /**
-     * Calls into GFN SDK to determine all titles available to stream right now directly from the
-     * NVIDIA GeForce NOW game seat.
-     */
-    else if (command == GFN_SDK_GET_AVAILABLE_TITLES)
+    else
     {
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
+        JsonWriter json(responseBuffer());
+        json.field("errorMessage", "Bad arguments to CEF extension");
+
+        CefString response = json.finish();
+        query.callback->Success(response);
+    }
+}
+
+/**
+ * Calls into GFN SDK to determine all titles available to stream right now directly from the
+ * NVIDIA GeForce NOW game seat.
+ */
+static void onGetAvailableTitles(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
+    {
+        JsonWriter json(responseBuffer());
         char const* appIds = nullptr;
         GfnError err = GfnGetTitlesAvailable(&appIds);
         if (err != GfnError::gfnSuccess)
         {
             LOG(ERROR) << "get available titles error: " << GfnErrorToString(err);
-            response_dict->SetString("titles", "");
+            json.field("titles", "");
         }
         else
         {
-            response_dict->SetString("titles", appIds);
+            json.field("titles", appIds);
             GfnFree(&appIds);
         }
 
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+        json.field("errorMessage", GfnErrorToString(err));
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
+
+struct StreamActionParams
+{
+    std::optional<bool> launchStream;
+    std::optional<int> gfnTitleId;
+    std::optional<std::string> authToken;
+    std::optional<std::string> tokenType;
+    std::optional<std::string> launcherToken;
 
-        return true;
+    static constexpr auto fields()
+    {
+        return std::make_tuple(
+            CommandRouter::field("launchStream", &StreamActionParams::launchStream),
+            CommandRouter::field("gfnTitleId", &StreamActionParams::gfnTitleId),
+            CommandRouter::field("authToken", &StreamActionParams::authToken),
+            CommandRouter::field("tokenType", &StreamActionParams::tokenType),
+            CommandRouter::field("launcherToken", &StreamActionParams::launcherToken));
     }
-    /**
-     * Calls into GFN SDK to initiate a new GeForce NOW streaming session and launch the specified
-     * game application. If a valid delegate token is passed in as a parameter it will automatically
-     * authenticate the streaming session and begin streaming immediately. If an empty or invalid
-     * delegate token is passed in then the GeForce NOW streaming client will display a login
-     * window prompting the user to authenticate first.
-     */
-    else if (command == GFN_SDK_STREAM_ACTION)
+};
+
+/**
+ * Calls into GFN SDK to initiate a new GeForce NOW streaming session and launch the specified
+ * game application. If a valid delegate token is passed in as a parameter it will automatically
+ * authenticate the streaming session and begin streaming immediately. If an empty or invalid
+ * delegate token is passed in then the GeForce NOW streaming client will display a login
+ * window prompting the user to authenticate first.
+ *
+ * Starting and stopping are waited for on a worker that holds the SDK lifetime lock, so the
+ * UI thread never blocks on a stream starting and the SDK can't be shut down underneath them.
+ */
+static void onStreamAction(const CommandRouter::Query& query, StreamActionParams params)
+{
+    CefRefPtr<CefMessageRouterBrowserSide::Callback> callback = query.callback;
+    std::string msg;
+    if (!params.launchStream)
     {
-        bool actionSuccess = false;
-        bool launchStream = false;
-        std::string msg;
-        if (!dict->HasKey("launchStream"))
-        {
-            msg = "Call to Stream action missing \"launchStream\" parameter";
-        }
-        launchStream = dict->GetBool("launchStream");
-        if (launchStream)
+        msg = "Call to Stream action missing \"launchStream\" parameter";
+    }
+    else if (*params.launchStream)
+    {
+        LOG(INFO) << "Received request to start a session";
+        if (params.gfnTitleId && params.authToken && params.tokenType)
         {
-            LOG(INFO) << "Received request to start a session";
-            if (dict->HasKey("gfnTitleId") && dict->HasKey("authToken") && dict->HasKey("tokenType"))
+            AuthType_t tokenType = 0;
+            bool hasTokenType = false;
+            std::stringstream ssTokenType(*params.tokenType);
+            ssTokenType >> tokenType;
+            hasTokenType = !ssTokenType.fail() && !ssTokenType.bad();
+
+            if (hasTokenType)
             {
-                StartStreamResponse response = { 0 };
-                StartStreamInput startStreamInput = { 0 };
-                uint32_t gfnTitleId = dict->GetInt("gfnTitleId");
-                startStreamInput.uiTitleId = gfnTitleId;
-
-                // NVIDIA IDM authorization token (when NV user has logged in)
-                std::string pchAuthToken = dict->GetString("authToken").ToString();
-                startStreamInput.pchAuthToken = pchAuthToken.c_str();
-                bool hasTokenType = false;
-                std::stringstream ssTokenType(dict->GetString("tokenType"));
-                ssTokenType >> startStreamInput.tokenType;
-                hasTokenType = !ssTokenType.fail() && !ssTokenType.bad();
-
-                // 3rd party IDM token for SSO that is consumed by launcher application running in GFN
-                std::string pchcustAuth = dict->GetString("launcherToken").ToString();
-                startStreamInput.pchCustomAuth = pchcustAuth.c_str();
-
-                if (hasTokenType)
+                runOnWorker(callback, false, [callback, gfnTitleId = static_cast<uint32_t>(*params.gfnTitleId),
+                    authToken = std::move(*params.authToken), tokenType,
+                    pchcustAuth = params.launcherToken.value_or("")]()
                 {
+                    StartStreamInput startStreamInput = { 0 };
+                    startStreamInput.uiTitleId = gfnTitleId;
+
+                    // NVIDIA IDM authorization token (when NV user has logged in)
+                    startStreamInput.pchAuthToken = authToken.c_str();
+                    startStreamInput.tokenType = tokenType;
+
+                    // 3rd party IDM token for SSO that is consumed by launcher application running in GFN
+                    startStreamInput.pchCustomAuth = pchcustAuth.c_str();
                     startStreamInput.pchCustomData = "This is example custom data";
 
-                    GfnError err = GfnStartStream(&startStreamInput, &response);
-                    msg = "gfnStartStream = " + std::string(GfnErrorToString(err));
+                    GfnRuntimeSdk::Future<StartStreamResponse> started =
+                        GfnRuntimeSdk::StartStreamAsync(startStreamInput, STREAM_START_TIMEOUT_MS);
+                    awaitStreamAction(started);
+
+                    GfnError err = started.status();
+                    std::string msg = "gfnStartStream = " + std::string(GfnErrorToString(err));
                     if (err != GfnError::gfnSuccess)
                     {
                         LOG(ERROR) << "launch game error: " << msg;
+                        postToUiThread([callback, msg]() { sendStreamActionResponse(callback, false, msg); });
+                        return;
                     }
-                    else
-                    {
-                        actionSuccess = true;
-                        msg = msg + ", GFN Downloaded & Installed = " + (response.downloaded ? "Yes" : "Not needed");
-                        LOG(INFO) << "launch game response. Downloaded GeForceNOW? : " << response.downloaded;
-                    }
-                }
-                else
-                {
-                    msg = "An error occurred while parsing tokenType argument to CEF extention";
-                }
+                    msg = msg + ", GFN Downloaded & Installed = " + (started.value().downloaded ? "Yes" : "Not needed");
+                    LOG(INFO) << "launch game response. Downloaded GeForceNOW? : " << started.value().downloaded;
+                    postToUiThread([callback, msg]() { sendStreamActionResponse(callback, true, msg); });
+                });
+                return;
             }
             else
             {
-                msg = "Bad arguments to CEF extension";
+                msg = "An error occurred while parsing tokenType argument to CEF extention";
             }
         }
         else
         {
-            LOG(INFO) << "Received request to stop a session";
-            GfnError err = GfnStopStream();
-            msg = "gfnStopStream = " + std::string(GfnErrorToString(err));
+            msg = "Bad arguments to CEF extension";
+        }
+    }
+    else
+    {
+        LOG(INFO) << "Received request to stop a session";
+        runOnWorker(callback, false, [callback]()
+        {
+            GfnRuntimeSdk::Future<void> stopped = GfnRuntimeSdk::StopStreamAsync(STREAM_STOP_TIMEOUT_MS);
+            awaitStreamAction(stopped);
+
+            GfnError err = stopped.status();
+            std::string msg = "gfnStopStream = " + std::string(GfnErrorToString(err));
             if (err != GfnError::gfnSuccess)
             {
                 LOG(ERROR) << "Stream stop error: " << msg;
+                postToUiThread([callback, msg]() { sendStreamActionResponse(callback, false, msg); });
+                return;
             }
-            else
-            {
-                actionSuccess = true;
-                LOG(INFO) << "Stream stop success";
-            }
-        }
+            LOG(INFO) << "Stream stop success";
+            postToUiThread([callback, msg]() { sendStreamActionResponse(callback, true, msg); });
+        });
+        return;
+    }
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetBool("actionSuccess", actionSuccess);
-        response_dict->SetString("errorMessage", CefString(msg.c_str()));
+    sendStreamActionResponse(callback, false, msg);
+}
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
-        return true;
-    }
-    /**
-     * Calls into GFN SDK to get the user's current local IP address. This is meant to be
-     * called while running on the GeForce NOW game seat to handle scenarios where the IP
-     * addressed is used for account security or other validation purposes or things like
-     * region specific localization or other UI.
-     */
-    else if (command == GFN_SDK_GET_CLIENT_IP)
+/**
+ * Calls into GFN SDK to get the user's current local IP address. This is meant to be
+ * called while running on the GeForce NOW game seat to handle scenarios where the IP
+ * addressed is used for account security or other validation purposes or things like
+ * region specific localization or other UI.
+ */
+static void onGetClientIp(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         char const* clientIp = nullptr;
         GfnError err = GfnGetClientIpV4(&clientIp);
@@ -477,21 +762,23 @@ bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
             LOG(INFO) << "client ip: " << clientIp;
         }
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetString("clientIp", clientIp);
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
+        JsonWriter json(responseBuffer());
+        json.field("clientIp", clientIp);
+        json.field("errorMessage", GfnErrorToString(err));
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
 
-        return true;
-    }
-    /**
-     * Calls into GFN SDK to get the user's country code. This is meant to be
-     * called while running on the GeForce NOW game seat to determine the country where
-     * user is located
-     */
-    else if (command == GFN_SDK_GET_CLIENT_COUNTRY_CODE)
+/**
+ * Calls into GFN SDK to get the user's country code. This is meant to be
+ * called while running on the GeForce NOW game seat to determine the country where
+ * user is located
+ */
+static void onGetClientCountryCode(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         char clientCountryCode[3] = { 0 };
         GfnError err = GfnGetClientCountryCode(clientCountryCode, 3);
@@ -504,179 +791,249 @@ bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
             LOG(INFO) << "client country code: " << clientCountryCode;
         }
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetString("clientCountryCode", clientCountryCode);
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
+        JsonWriter json(responseBuffer());
+        json.field("clientCountryCode", clientCountryCode);
+        json.field("errorMessage", GfnErrorToString(err));
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
-        return true;
-    }
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
 
-    /**
-     * Calls into GFN SDK to get the user's language code. THis is meant to be
-     * called while running on the GeForce NOW game seat to determine the language
-     * used by the user.
-     */
-    else if (command == GFN_SDK_GET_CLIENT_LANGUAGE_CODE)
+/**
+ * Calls into GFN SDK to get the user's language code. THis is meant to be
+ * called while running on the GeForce NOW game seat to determine the language
+ * used by the user.
+ */
+static void onGetClientLanguageCode(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         const char* clientLanguageCode;
         GfnError err = GfnGetClientLanguageCode(&clientLanguageCode);
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
+        JsonWriter json(responseBuffer());
         if (err != GfnError::gfnSuccess)
         {
             LOG(ERROR) << "get client country code error: " << GfnErrorToString(err);
-            response_dict->SetString("clientLanguageCode", "");
-            response_dict->SetString("errorMessage", GfnErrorToString(err));
+            json.field("clientLanguageCode", "");
+            json.field("errorMessage", GfnErrorToString(err));
         }
         else
         {
             LOG(INFO) << "client country code: " << clientLanguageCode;
-            response_dict->SetString("clientLanguageCode", clientLanguageCode);
-            response_dict->SetString("errorMessage", "");
+            json.field("clientLanguageCode", clientLanguageCode);
+            json.field("errorMessage", "");
         }
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+        CefString response = json.finish();
+        respond(callback, response);
 
         if (err == GfnError::gfnSuccess)
         {
             GfnFree(&clientLanguageCode);
         }
-        return true;
+    });
+}
+
+struct RegisterPushParams
+{
+    std::optional<int> intervalMs;
+
+    static constexpr auto fields()
+    {
+        return std::make_tuple(CommandRouter::field("intervalMs", &RegisterPushParams::intervalMs));
     }
 
-    /**
-     * Registers for callback notifications during a streaming session.
-     */
-    else if (command == GFN_SDK_REGISTER_STREAM_STATUS_CALLBACK)
+    int interval() const
     {
-        s_registerStreamStatusCallback = callback;
+        return std::clamp(intervalMs.value_or(PUSH_INTERVAL_DEFAULT_MS), 0, PUSH_INTERVAL_MAX_MS);
+    }
+};
+
+/**
+ * Registers for callback notifications during a streaming session. Status changes are pushed
+ * at most once per "intervalMs" (default one frame), each message carries the latest status and
+ * every status since the previous message.
+ */
+static void onRegisterStreamStatusCallback(const CommandRouter::Query& query, RegisterPushParams params)
+{
+    s_streamStatusPush.attach(query.callback, params.interval());
 
-        GfnError err = GfnRegisterStreamStatusCallback(reinterpret_cast<StreamStatusCallbackSig>(&handleStreamStatusCallback), nullptr);
-        if (err != GfnError::gfnSuccess)
-        {
-            LOG(ERROR) << "Failed to register Stream Status Callback: " << GfnErrorToString(err);
-        }
-        return true;
+    GfnError err = GfnRegisterStreamStatusCallback(reinterpret_cast<StreamStatusCallbackSig>(&handleStreamStatusCallback), nullptr);
+    if (err != GfnError::gfnSuccess)
+    {
+        LOG(ERROR) << "Failed to register Stream Status Callback: " << GfnErrorToString(err);
     }
-    /**
-     * Requests a copy of the token data that was passed into customAuth as part of the call to one
-     * of the StartStream APIs. This call should only be made in the GFN cloud environment.
-     */
-    else if (command == GFN_SDK_REQUEST_ACCESS_TOKEN)
+}
+
+/**
+ * Requests a copy of the token data that was passed into customAuth as part of the call to one
+ * of the StartStream APIs. This call should only be made in the GFN cloud environment.
+ */
+static void onRequestAccessToken(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         char const* authData = nullptr;
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
+        JsonWriter json(responseBuffer());
         GfnError err = GfnGetAuthData(&authData);
-        response_dict->SetString("errorMessage", GfnErrorToString(err));
+        json.field("errorMessage", GfnErrorToString(err));
         if (err != GfnError::gfnSuccess)
         {
             LOG(ERROR) << "get authorization data error: " << GfnErrorToString(err);
-            response_dict->SetString("authData", "");
+            json.field("authData", "");
         }
         else
         {
-            response_dict->SetString("authData", authData);
+            json.field("authData", authData);
             GfnFree(&authData);
         }
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+        CefString response = json.finish();
+        respond(callback, response);
+    });
+}
 
-        return true;
-    }
-    else if (command == GET_TCP_PORT)
-    {
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetString("port", shared::g_activePort);
+static void onGetTcpPort(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    JsonWriter json(responseBuffer());
+    json.field("port", shared::g_activePort);
 
-        CefString response(DictToJson(response_dict));
-        callback->Success(response);
+    CefString response = json.finish();
+    query.callback->Success(response);
+}
 
-        return true;
-    }
-    else if (command == GET_CLIENT_INFO)
+static void onGetClientInfo(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    runOnWorker(query.callback, false, [callback = query.callback]()
     {
         LOG(INFO) << "Calling GfnGetClientInfo...";
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
+        JsonWriter json(responseBuffer());
         GfnClientInfo clientInfo = { 0 };
         GfnError error = GfnError::gfnSuccess;
         error = GfnGetClientInfo(&clientInfo);
         LOG(INFO) << "GfnGetClientInfo error result: " << error;
-        response_dict->SetString("errorMessage", GfnErrorToString(error));
+        json.field("errorMessage", GfnErrorToString(error));
         if (error != GfnError::gfnSuccess)
         {
             LOG(ERROR) << "get client info data error: " << GfnErrorToString(error);
-            response_dict->SetString("clientInfo", "");
+            json.field("clientInfo", "");
         }
         else
         {
-            response_dict->SetInt("apiVersion", clientInfo.version);
-            response_dict->SetString("country", clientInfo.country);
-            response_dict->SetString("ipV4", clientInfo.ipV4);
-            response_dict->SetString("locale", clientInfo.locale);
-            response_dict->SetInt("osType", clientInfo.osType);
+            json.field("apiVersion", clientInfo.version);
+            json.field("country", clientInfo.country);
+            json.field("ipV4", clientInfo.ipV4);
+            json.field("locale", clientInfo.locale);
+            json.field("osType", clientInfo.osType);
         }
-        CefString response(DictToJson(response_dict));
+        CefString response = json.finish();
         LOG(INFO) << "GfnGetClientInfo data: " << response.ToString();
-        callback->Success(response);
-        return true;
-    }
-    /**
-     * Registers for callback notifications for on-seat client info updates
-     */
-    else if (command == GFN_SDK_REGISTER_CLIENT_INFO_CALLBACK)
-    {
-        s_registerClientInfoCallback = callback;
+        respond(callback, response);
+    });
+}
 
-        GfnError err = GfnRegisterClientInfoCallback(reinterpret_cast<ClientInfoCallbackSig>(&handleClientInfoCallback), nullptr);
-        if (err != GfnError::gfnSuccess)
-        {
-            LOG(ERROR) << "Failed to register Client Info Callback: " << GfnErrorToString(err);
-        }
-        return true;
+/**
+ * Registers for callback notifications for on-seat client info updates. Updates are pushed at
+ * most once per "intervalMs" (default one frame) with the latest value of each field.
+ */
+static void onRegisterClientInfoCallback(const CommandRouter::Query& query, RegisterPushParams params)
+{
+    s_clientInfoPush.attach(query.callback, params.interval());
+
+    GfnError err = GfnRegisterClientInfoCallback(reinterpret_cast<ClientInfoCallbackSig>(&handleClientInfoCallback), nullptr);
+    if (err != GfnError::gfnSuccess)
+    {
+        LOG(ERROR) << "Failed to register Client Info Callback: " << GfnErrorToString(err);
     }
-    else if (command == GET_OVERRIDE_URI)
+}
+
+static void onGetOverrideUri(const CommandRouter::Query& query, CommandRouter::NoParams)
+{
+    int argc = 0;
+    LPWSTR* cmdLine = CommandLineToArgvW(GetCommandLineW(), &argc);
+    LPWSTR override_uri = L"";
+    for (int i = 0; i < argc; i++)
     {
-        int argc = 0;
-        LPWSTR* cmdLine = CommandLineToArgvW(GetCommandLineW(), &argc);
-        LPWSTR override_uri = L"";
-        for (int i = 0; i < argc; i++)
+        if (wcscmp(cmdLine[i], L"--override_uri") == 0)
         {
-            if (wcscmp(cmdLine[i], L"--override_uri") == 0)
+            if (i + 1 < argc)
             {
-                if (i + 1 < argc)
-                {
-                    override_uri = cmdLine[i + 1];
-                }
-                break;
+                override_uri = cmdLine[i + 1];
             }
+            break;
         }
+    }
+
+    JsonWriter json(responseBuffer());
+    json.field("overrideURI", override_uri);
+
+    CefString response = json.finish();
+    LOG(INFO) << "Override URI: " << response.ToString();
+    query.callback->Success(response);
+}
 
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetString("overrideURI", override_uri);
+static constexpr auto s_commands = CommandRouter::makeTable(std::array{
+    CommandRouter::command<&onInit>("GFN_SDK_INIT"),
+    CommandRouter::command<&onShutdown>("GFN_SDK_SHUTDOWN"),
+    CommandRouter::command<&onStreamAction>("GFN_SDK_STREAM_ACTION"),
+    CommandRouter::command<&onIsRunningInCloud>("GFN_SDK_IS_RUNNING_IN_CLOUD"),
+    CommandRouter::command<&onIsRunningInCloudSecure>("GFN_SDK_IS_RUNNING_IN_CLOUD_SECURE"),
+    CommandRouter::command<&onGetClientIp>("GFN_SDK_GET_CLIENT_IP"),
+    CommandRouter::command<&onGetClientCountryCode>("GFN_SDK_GET_CLIENT_COUNTRY_CODE"),
+    CommandRouter::command<&onGetClientLanguageCode>("GFN_SDK_GET_CLIENT_LANGUAGE_CODE"),
+    CommandRouter::command<&onRegisterStreamStatusCallback>("GFN_SDK_REGISTER_STREAM_STATUS_CALLBACK"),
+    CommandRouter::command<&onIsTitleAvailable>("GFN_SDK_IS_TITLE_AVAILABLE"),
+    CommandRouter::command<&onGetAvailableTitles>("GFN_SDK_GET_AVAILABLE_TITLES"),
+    CommandRouter::command<&onRequestAccessToken>("GFN_SDK_REQUEST_ACCESS_TOKEN"),
+    CommandRouter::command<&onGetTcpPort>("GET_TCP_PORT"),
+    CommandRouter::command<&onGetClientInfo>("GFN_SDK_GET_CLIENT_INFO"),
+    CommandRouter::command<&onRegisterClientInfoCallback>("GFN_SDK_REGISTER_CLIENT_INFO_CALLBACK"),
+    CommandRouter::command<&onGetOverrideUri>("GET_OVERRIDE_URI"),
+});
 
-        CefString response(DictToJson(response_dict));
-        LOG(INFO) << "Override URI: " << response.ToString();
-        callback->Success(response);
-        return true;
+bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    int64 query_id,
+    const CefString& request,
+    bool persistent,
+    CefRefPtr<CefMessageRouterBrowserSide::Callback> callback)
+{
+    CefRefPtr<CefValue> requestValue = CefParseJSON(request, JSON_PARSER_RFC);
+    if (!requestValue || requestValue->GetType() != VTYPE_DICTIONARY)
+    {
+        LOG(ERROR) << "Malformed query: " << request;
+        return false;
     }
-    LOG(ERROR) << "Unknown command value: " << command;
 
-    return false;
+    CefRefPtr<CefDictionaryValue> dict = requestValue->GetDictionary();
+    std::string command = dict->GetString("command").ToString();
+
+    if (!s_commands.dispatch(command, { browser, frame, query_id, persistent, callback }, dict))
+    {
+        LOG(ERROR) << "Unknown command value: " << command;
+        return false;
+    }
+    return true;
 }
 
 void __stdcall handleStreamStatusCallback(GfnStreamStatus status, void* context)
 {
-    if (s_registerStreamStatusCallback)
+    s_streamStatusPush.post([status](StreamStatusState& state, auto& counters)
     {
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        response_dict->SetString("status", GfnStreamStatusToString(status));
-
-        CefString response(DictToJson(response_dict));
-        s_registerStreamStatusCallback->Success(response);
-    }
+        if (state.count > 0 && state.history[state.count - 1] == status)
+        {
+            counters.merged++;
+            return;
+        }
+        if (state.count == STREAM_STATUS_HISTORY)
+        {
+            std::move(state.history + 1, state.history + state.count, state.history);
+            state.count--;
+            counters.dropped++;
+        }
+        state.history[state.count++] = status;
+    });
 }
 
 void __stdcall handleClientInfoCallback(GfnClientInfoUpdateData* pClientUpdate, void* context)
@@ -685,19 +1042,24 @@ void __stdcall handleClientInfoCallback(GfnClientInfoUpdateData* pClientUpdate,
     {
         return;
     }
-    if (s_registerClientInfoCallback)
+
+    switch (pClientUpdate->updateType)
+    {
+    case gfnOs:
     {
-        CefRefPtr<CefDictionaryValue> response_dict = CefDictionaryValue::Create();
-        switch (pClientUpdate->updateType)
+        GfnOsType os = pClientUpdate->data.osType;
+        s_clientInfoPush.post([os](ClientInfoState& state, auto& counters)
         {
-        case gfnOs:
-            response_dict->SetInt("os", pClientUpdate->data.osType);
-            break;
-        default:
-            return;
-        }
-
-        CefString response(DictToJson(response_dict));
-        s_registerClientInfoCallback->Success(response);
+            if (state.hasOs)
+            {
+                counters.merged++;
+            }
+            state.hasOs = true;
+            state.os = os;
+        });
+        break;
+    }
+    default:
+        return;
     }
 }
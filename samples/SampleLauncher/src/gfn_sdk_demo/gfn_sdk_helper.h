@@ -38,4 +38,7 @@ bool GfnSdkHelper(CefRefPtr<CefBrowser> browser,
                   bool persistent,
                   CefRefPtr<CefMessageRouterBrowserSide::Callback> callback);
 
+// Waits for queries still running on the SDK workers, then shuts the SDK down
+void GfnSdkHelperShutdown();
+
 #endif
\ No newline at end of file
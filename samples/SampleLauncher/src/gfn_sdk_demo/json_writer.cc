@@ -0,0 +1,247 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#include "gfn_sdk_demo/json_writer.h"
+
+#include <charconv>
+
+// Enough for a typical reply, so the buffer rarely has to grow at all
+static const size_t RESPONSE_BUFFER_RESERVE = 512;
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(std::string& buffer) :
+    m_out(buffer)
+{
+    m_out.clear();
+    m_out.push_back('{');
+}
+
+JsonWriter& JsonWriter::field(std::string_view key, bool value)
+{
+    writeKey(key);
+    m_out.append(value ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(std::string_view key, const char* value)
+{
+    return field(key, std::string_view(value != nullptr ? value : ""));
+}
+
+JsonWriter& JsonWriter::field(std::string_view key, std::string_view value)
+{
+    writeKey(key);
+    writeString(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(std::string_view key, std::wstring_view value)
+{
+    writeKey(key);
+    writeString(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(std::string_view key, const wchar_t* value)
+{
+    return field(key, std::wstring_view(value != nullptr ? value : L""));
+}
+
+JsonWriter& JsonWriter::beginObject(std::string_view key)
+{
+    writeKey(key);
+    m_out.push_back('{');
+    m_first = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    m_out.push_back('}');
+    m_first = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(std::string_view key)
+{
+    writeKey(key);
+    m_out.push_back('[');
+    m_first = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::element(std::string_view value)
+{
+    if (!m_first)
+    {
+        m_out.push_back(',');
+    }
+    m_first = false;
+    writeString(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    m_out.push_back(']');
+    m_first = false;
+    return *this;
+}
+
+CefString JsonWriter::finish()
+{
+    m_out.push_back('}');
+    return CefString(m_out);
+}
+
+void JsonWriter::writeKey(std::string_view key)
+{
+    if (!m_first)
+    {
+        m_out.push_back(',');
+    }
+    m_first = false;
+    writeString(key);
+    m_out.push_back(':');
+}
+
+void JsonWriter::writeString(std::string_view value)
+{
+    m_out.push_back('"');
+    appendEscaped(value);
+    m_out.push_back('"');
+}
+
+void JsonWriter::writeString(std::wstring_view value)
+{
+    // Converted to UTF-8 a chunk at a time on the stack. Only ASCII needs escaping, and no byte
+    // of a multi-byte sequence is ASCII, so chunk boundaries don't matter
+    char chunk[256];
+    size_t length = 0;
+
+    m_out.push_back('"');
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        unsigned long cp = static_cast<unsigned long>(value[i]);
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < value.size() &&
+            value[i + 1] >= 0xDC00 && value[i + 1] <= 0xDFFF)
+        {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<unsigned long>(value[i + 1]) - 0xDC00);
+            i++;
+        }
+        else if (cp >= 0xD800 && cp <= 0xDFFF)
+        {
+            // unpaired surrogate
+            cp = 0xFFFD;
+        }
+
+        if (cp < 0x80)
+        {
+            chunk[length++] = static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            chunk[length++] = static_cast<char>(0xC0 | (cp >> 6));
+            chunk[length++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            chunk[length++] = static_cast<char>(0xE0 | (cp >> 12));
+            chunk[length++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            chunk[length++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            chunk[length++] = static_cast<char>(0xF0 | (cp >> 18));
+            chunk[length++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            chunk[length++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            chunk[length++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+
+        if (length > sizeof(chunk) - 4)
+        {
+            appendEscaped(std::string_view(chunk, length));
+            length = 0;
+        }
+    }
+    appendEscaped(std::string_view(chunk, length));
+    m_out.push_back('"');
+}
+
+void JsonWriter::appendEscaped(std::string_view value)
+{
+    // Copy runs of characters that need no escaping in one go
+    size_t run = 0;
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        m_out.append(value.data() + run, i - run);
+        run = i + 1;
+
+        m_out.push_back('\\');
+        switch (c)
+        {
+        case '"': m_out.push_back('"'); break;
+        case '\\': m_out.push_back('\\'); break;
+        case '\b': m_out.push_back('b'); break;
+        case '\f': m_out.push_back('f'); break;
+        case '\n': m_out.push_back('n'); break;
+        case '\r': m_out.push_back('r'); break;
+        case '\t': m_out.push_back('t'); break;
+        default:
+            m_out.append("u00");
+            m_out.push_back(HEX_DIGITS[c >> 4]);
+            m_out.push_back(HEX_DIGITS[c & 0xF]);
+            break;
+        }
+    }
+    m_out.append(value.data() + run, value.size() - run);
+}
+
+void JsonWriter::writeInteger(long long value)
+{
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_out.append(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+std::string& responseBuffer()
+{
+    static thread_local std::string s_buffer = []()
+    {
+        std::string buffer;
+        buffer.reserve(RESPONSE_BUFFER_RESERVE);
+        return buffer;
+    }();
+    return s_buffer;
+}
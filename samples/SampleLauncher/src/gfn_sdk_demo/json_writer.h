@@ -0,0 +1,93 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#ifndef GFN_SDK_JSON_WRITER_H_
+#define GFN_SDK_JSON_WRITER_H_
+
+#include "include/cef_string.h"
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Writes a single JSON object straight into a caller-owned buffer. Keeping the buffer around
+// between responses (see responseBuffer()) means building a reply allocates nothing once the
+// buffer has grown to the largest reply, only handing the result to CEF copies it.
+//
+//     CefString response = JsonWriter(responseBuffer())
+//         .field("success", true)
+//         .field("errorMessage", message)
+//         .finish();
+class JsonWriter
+{
+public:
+    // Clears buffer and opens the outer object
+    explicit JsonWriter(std::string& buffer);
+
+    JsonWriter& field(std::string_view key, bool value);
+    JsonWriter& field(std::string_view key, const char* value);  // nullptr is written as ""
+    JsonWriter& field(std::string_view key, std::string_view value);
+    JsonWriter& field(std::string_view key, std::wstring_view value);  // UTF-16, converted to UTF-8
+    JsonWriter& field(std::string_view key, const wchar_t* value);     // nullptr is written as ""
+
+    // Integers and enums, enums are written as their numeric value
+    template <typename T, typename std::enable_if<(std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+        std::is_enum<T>::value, int>::type = 0>
+    JsonWriter& field(std::string_view key, T value)
+    {
+        writeKey(key);
+        writeInteger(static_cast<long long>(value));
+        return *this;
+    }
+
+    // Nested object, closed with endObject()
+    JsonWriter& beginObject(std::string_view key);
+    JsonWriter& endObject();
+
+    // Array of strings, filled with element() and closed with endArray()
+    JsonWriter& beginArray(std::string_view key);
+    JsonWriter& element(std::string_view value);
+    JsonWriter& endArray();
+
+    // Closes the outer object and returns the text
+    CefString finish();
+
+private:
+    void writeKey(std::string_view key);
+    void writeString(std::string_view value);
+    void writeString(std::wstring_view value);
+    void appendEscaped(std::string_view value);
+    void writeInteger(long long value);
+
+    std::string& m_out;
+    bool m_first = true;
+};
+
+// Per-thread buffer for JsonWriter, responses are built on the UI thread, the SDK workers and
+// the SDK's own callback threads
+std::string& responseBuffer();
+
+#endif
@@ -0,0 +1,157 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#include "gfn_sdk_demo/service_connection.h"
+
+#include <Windows.h>
+#include <thread>
+#include "include/base/cef_logging.h"
+
+static bool checkSampleServiceRunningStatus()
+{
+    WCHAR* serviceName = L"GfnSdkSampleService";
+
+    SC_HANDLE sch = OpenSCManager(NULL, NULL, SC_MANAGER_ENUMERATE_SERVICE);
+    if (sch == NULL)
+    {
+        LOG(INFO) << "OpenSCManager failed";
+        return false;
+    }
+
+    SC_HANDLE svc = OpenService(sch, serviceName, SERVICE_QUERY_STATUS);
+    if (svc == NULL)
+    {
+        LOG(INFO) << "OpenService failed";
+        CloseServiceHandle(sch);
+        return false;
+    }
+
+    bool serviceRunning = false;
+    SERVICE_STATUS_PROCESS stat;
+    DWORD needed = 0;
+    BOOL ret = QueryServiceStatusEx(svc, SC_STATUS_PROCESS_INFO,
+        (BYTE*)&stat, sizeof stat, &needed);
+    if (ret == TRUE)
+    {
+        if (stat.dwCurrentState == SERVICE_RUNNING)
+        {
+            serviceRunning = true;
+            LOG(INFO) << serviceName << " is running";
+        }
+        else
+        {
+            LOG(INFO) << serviceName << " is NOT running";
+        }
+    }
+    else
+    {
+        LOG(INFO) << "QueryServiceStatusEx failed";
+    }
+
+    CloseServiceHandle(svc);
+    CloseServiceHandle(sch);
+
+    return serviceRunning;
+}
+
+ServiceConnection& ServiceConnection::instance()
+{
+    // Never destroyed: the prefetch thread is detached and may still be connecting at exit, and
+    // the process tearing down closes the pipe anyway
+    static ServiceConnection* s_connection = new ServiceConnection();
+    return *s_connection;
+}
+
+void ServiceConnection::prefetch()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_prefetchStarted)
+    {
+        return;
+    }
+    m_prefetchStarted = true;
+
+    // Detached so a service that is slow to answer never holds up process exit
+    std::thread([this]()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_prefetched = query();
+        m_prefetchedAt = clock::now();
+    }).detach();
+}
+
+ServiceConnection::CloudCheck ServiceConnection::isRunningInCloudSecure()
+{
+    // Waits for a prefetch that is still connecting rather than opening a second connection
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_prefetched)
+    {
+        CloudCheck prefetched = std::move(*m_prefetched);
+        m_prefetched.reset();
+
+        // A prefetch that failed, for instance because the service wasn't up yet, is retried, and
+        // one the page took too long to ask for may no longer hold
+        if (prefetched.status == SampleService::status::success &&
+            clock::now() - m_prefetchedAt < PREFETCH_TTL)
+        {
+            return prefetched;
+        }
+    }
+    return query();
+}
+
+ServiceConnection::CloudCheck ServiceConnection::query()
+{
+    CloudCheck check;
+
+    // The first attempt and its retry share one call timeout
+    const clock::time_point deadline = clock::now() +
+        std::chrono::milliseconds(SampleService::ServiceClient::default_call_timeout_ms);
+
+    // Only look the service up while there is no connection, an open pipe means it is running
+    const bool wasConnected = m_client.isConnected();
+    check.serviceRunning = wasConnected || checkSampleServiceRunningStatus();
+    if (!check.serviceRunning)
+    {
+        return check;
+    }
+
+    std::tie(check.status, check.gfnStatus, check.value) = m_client.isRunningInCloudSecure();
+
+    // The service may have restarted since the connection was opened, the failed call dropped
+    // the stale pipe so try once more on a fresh one. A call that timed out already used up the
+    // time the caller was promised, so it isn't retried.
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+    if (check.status != SampleService::status::success && check.status != SampleService::status::timed_out &&
+        wasConnected && remaining.count() > 0)
+    {
+        std::tie(check.status, check.gfnStatus, check.value) =
+            m_client.isRunningInCloudSecure(static_cast<size_t>(remaining.count()));
+    }
+    return check;
+}
@@ -0,0 +1,82 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#ifndef GFN_SDK_SERVICE_CONNECTION_H_
+#define GFN_SDK_SERVICE_CONNECTION_H_
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include "client.h"
+
+// The launcher's connection to GfnSdkSampleService. It is opened once, in the background while
+// CEF starts up, and reused by every later query instead of connecting per query. The secure
+// cloud check is fetched as soon as the connection is up, so the page's first check is usually
+// answered without a round trip at all. The service runs several pipe instances, so holding this
+// one open for the launcher's lifetime doesn't keep other clients out.
+class ServiceConnection
+{
+public:
+    struct CloudCheck
+    {
+        bool serviceRunning = false;
+        SampleService::status status = SampleService::status::failed_to_create_pipe;
+        std::wstring gfnStatus;  // GfnError, as returned by the service
+        std::wstring value;      // GfnIsRunningInCloudAssurance, as returned by the service
+    };
+
+    static ServiceConnection& instance();
+
+    // Starts connecting and fetching the cloud check on a detached background thread. Only the
+    // first call does anything.
+    void prefetch();
+
+    // Hands out the prefetched result the first time it is asked for, as long as it is younger
+    // than PREFETCH_TTL, otherwise asks the service over the open connection. Blocks, so keep it
+    // off the UI thread.
+    CloudCheck isRunningInCloudSecure();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    // How long a prefetched cloud check may wait for the page to ask for it
+    static constexpr std::chrono::seconds PREFETCH_TTL{ 30 };
+
+    ServiceConnection() = default;
+
+    // Caller holds m_mutex
+    CloudCheck query();
+
+    std::mutex m_mutex;
+    SampleService::ServiceClient m_client;
+    bool m_prefetchStarted = false;
+    std::optional<CloudCheck> m_prefetched;
+    clock::time_point m_prefetchedAt;
+};
+
+#endif
@@ -37,6 +37,9 @@ public:
 	bool finalize() const;
 	bool has_error() const;
 
+	// size of the whole request, c_size_unknown when the buffer size was not given
+	size_t size() const { return static_cast<size_t>(m_maxsize); }
+
 private:
 	template <typename T>
 	traits::enable_if_t<traits::is_unspecified_v<T>, T>
@@ -0,0 +1,363 @@
+/*
+* Copyright (c) 2016-2021, NVIDIA CORPORATION.  All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto.  Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+#include "logger.h"
+#include <Windows.h>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#include "utils.h"
+
+using namespace SampleService;
+using namespace SampleService::Logging;
+
+// longer messages are truncated
+static constexpr size_t MESSAGE_CAPACITY = 240;
+// records per thread, a thread that logs faster than the writer drains loses records
+static constexpr size_t RING_CAPACITY = 128;
+// the writer wakes up at least this often, or earlier when a ring is half full
+static constexpr DWORD FLUSH_INTERVAL_MS = 100;
+
+namespace
+{
+	struct record
+	{
+		log_level level;
+		DWORD thread_id;
+		ULONGLONG timestamp; // FILETIME, UTC
+		const char* file;
+		int line;
+		size_t length;
+		char message[MESSAGE_CAPACITY];
+	};
+
+	// Single producer (the owning thread), single consumer (whoever holds the drain lock)
+	class RecordRing : public Utils::NonCopyable
+	{
+		std::array<record, RING_CAPACITY> m_slots;
+		std::atomic<size_t> m_head{ 0 };
+		std::atomic<size_t> m_tail{ 0 };
+		std::atomic<size_t> m_dropped{ 0 };
+		std::atomic<bool> m_retired{ false };
+
+	public:
+		record* claim()
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) == RING_CAPACITY)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			return &m_slots[head % RING_CAPACITY];
+		}
+
+		// returns true when the ring has become half full
+		bool publish()
+		{
+			const auto head = m_head.load(std::memory_order_relaxed) + 1;
+			m_head.store(head, std::memory_order_release);
+			return head - m_tail.load(std::memory_order_relaxed) == RING_CAPACITY / 2;
+		}
+
+		template <typename F>
+		void drain(F&& consume)
+		{
+			auto tail = m_tail.load(std::memory_order_relaxed);
+			const auto head = m_head.load(std::memory_order_acquire);
+			for (; tail != head; ++tail)
+			{
+				consume(m_slots[tail % RING_CAPACITY]);
+			}
+			m_tail.store(tail, std::memory_order_release);
+		}
+
+		size_t takeDropped() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+
+		void retire() { m_retired.store(true, std::memory_order_release); }
+
+		bool finished() const
+		{
+			return m_retired.load(std::memory_order_acquire) &&
+				m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+		}
+	};
+
+	// Formats into a fixed buffer, anything past its end is cut off
+	class record_buffer : public std::streambuf
+	{
+	public:
+		void reset(char* begin, size_t capacity)
+		{
+			setp(begin, begin + capacity);
+		}
+
+		size_t length() const
+		{
+			return static_cast<size_t>(pptr() - pbase());
+		}
+
+	protected:
+		int_type overflow(int_type) override
+		{
+			return traits_type::eof();
+		}
+	};
+
+	class Writer : public Utils::NonCopyable
+	{
+		std::mutex m_rings_mutex;
+		std::vector<std::shared_ptr<RecordRing>> m_rings;
+
+		std::mutex m_drain_mutex;
+		std::string m_batch;
+		std::ostream* m_out{ &std::cout };
+
+		Utils::Event m_wake{ false };
+		std::atomic<bool> m_running{ true };
+		std::thread m_thread;
+
+		void writerThread()
+		{
+			while (m_running.load(std::memory_order_acquire))
+			{
+				WaitForSingleObject(m_wake.handle(), FLUSH_INTERVAL_MS);
+				drainAll();
+			}
+			drainAll();
+		}
+
+		void append(const record& rec)
+		{
+			FILETIME utc_time{ static_cast<DWORD>(rec.timestamp), static_cast<DWORD>(rec.timestamp >> 32) };
+			FILETIME local_time{};
+			SYSTEMTIME st{};
+			FileTimeToLocalFileTime(&utc_time, &local_time);
+			FileTimeToSystemTime(&local_time, &st);
+
+			static const char* const level_names[] = { "trace", "debug", "info", "warning", "error" };
+			const auto level_index = static_cast<size_t>(rec.level);
+
+			const char* file = rec.file;
+			for (const char* p = rec.file; *p != '\0'; ++p)
+			{
+				if (*p == '\\' || *p == '/')
+				{
+					file = p + 1;
+				}
+			}
+
+			char prefix[128];
+			const int prefix_length = _snprintf_s(prefix, sizeof(prefix), _TRUNCATE,
+				"%04d-%02d-%02d %02d:%02d:%02d.%03d [%s] [%lu] %s:%d ",
+				st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds,
+				level_index < _countof(level_names) ? level_names[level_index] : "?",
+				rec.thread_id, file, rec.line);
+
+			if (prefix_length > 0)
+			{
+				m_batch.append(prefix, static_cast<size_t>(prefix_length));
+			}
+			m_batch.append(rec.message, rec.length);
+			m_batch.push_back('\n');
+		}
+
+	public:
+		Writer() :
+			m_thread(&Writer::writerThread, this)
+		{
+			m_batch.reserve(RING_CAPACITY * (MESSAGE_CAPACITY + 64));
+		}
+
+		~Writer()
+		{
+			m_running.store(false, std::memory_order_release);
+			m_wake.signal();
+			if (m_thread.joinable())
+			{
+				m_thread.join();
+			}
+		}
+
+		std::shared_ptr<RecordRing> registerThread()
+		{
+			auto ring = std::make_shared<RecordRing>();
+			std::lock_guard<std::mutex> lock(m_rings_mutex);
+			m_rings.push_back(ring);
+			return ring;
+		}
+
+		void wake()
+		{
+			m_wake.signal();
+		}
+
+		void drainAll()
+		{
+			std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+			drainLocked();
+		}
+
+		void setOutput(std::ostream* out)
+		{
+			std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+			drainLocked();
+			m_out = out != nullptr ? out : &std::cout;
+		}
+
+	private:
+		void drainLocked()
+		{
+			std::vector<std::shared_ptr<RecordRing>> rings;
+			{
+				std::lock_guard<std::mutex> lock(m_rings_mutex);
+				rings = m_rings;
+			}
+
+			m_batch.clear();
+			for (const auto& ring : rings)
+			{
+				ring->drain([this](const record& rec) { append(rec); });
+
+				const auto dropped = ring->takeDropped();
+				if (dropped != 0)
+				{
+					m_batch.append("Log ring overflow, dropped ").append(std::to_string(dropped)).append(" records\n");
+				}
+			}
+
+			if (!m_batch.empty())
+			{
+				m_out->write(m_batch.data(), static_cast<std::streamsize>(m_batch.size()));
+				m_out->flush();
+			}
+
+			// rings of exited threads go away once everything they logged is written
+			std::lock_guard<std::mutex> lock(m_rings_mutex);
+			for (auto it = m_rings.begin(); it != m_rings.end();)
+			{
+				it = (*it)->finished() ? m_rings.erase(it) : it + 1;
+			}
+		}
+	};
+
+	Writer& writer()
+	{
+		static Writer s_writer;
+		return s_writer;
+	}
+
+	struct thread_state
+	{
+		std::shared_ptr<RecordRing> ring;
+		record* current{ nullptr };
+		record scratch{}; // formatting target for records that are going to be dropped
+		record_buffer buffer;
+		std::ostream stream{ &buffer };
+		record_stream out{ stream };
+
+		thread_state() :
+			ring(writer().registerThread())
+		{}
+
+		~thread_state()
+		{
+			ring->retire();
+		}
+	};
+
+	thread_state& threadState()
+	{
+		static thread_local thread_state s_state;
+		return s_state;
+	}
+}
+
+record_stream& record_stream::operator<<(const wchar_t* value)
+{
+	return *this << std::wstring(value != nullptr ? value : L"");
+}
+
+record_stream& record_stream::operator<<(const std::wstring& value)
+{
+	if (value.empty())
+	{
+		return *this;
+	}
+
+	char converted[MESSAGE_CAPACITY];
+	const int length = WideCharToMultiByte(
+		CP_UTF8, 0, value.c_str(), static_cast<int>(value.size()),
+		converted, static_cast<int>(sizeof(converted)), nullptr, nullptr);
+
+	// a string longer than a whole record fails to convert, keep at least a marker
+	if (length > 0)
+	{
+		m_out.write(converted, length);
+	}
+	else
+	{
+		m_out << "<...>";
+	}
+	return *this;
+}
+
+record_stream& Logging::beginRecord()
+{
+	auto& state = threadState();
+	state.current = state.ring->claim();
+
+	auto* target = state.current != nullptr ? state.current : &state.scratch;
+	state.buffer.reset(target->message, MESSAGE_CAPACITY);
+	state.stream.clear();
+	return state.out;
+}
+
+void Logging::commitRecord(log_level level, const char* file, int line)
+{
+	auto& state = threadState();
+	if (state.current == nullptr)
+	{
+		return;
+	}
+
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+
+	auto& rec = *state.current;
+	rec.level = level;
+	rec.thread_id = GetCurrentThreadId();
+	rec.timestamp = (static_cast<ULONGLONG>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+	rec.file = file;
+	rec.line = line;
+	rec.length = state.buffer.length();
+	state.current = nullptr;
+
+	if (state.ring->publish() || level >= log_level::error)
+	{
+		writer().wake();
+	}
+}
+
+void Logging::flush()
+{
+	writer().drainAll();
+}
+
+void Logging::setOutput(std::ostream* out)
+{
+	writer().setOutput(out);
+}
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2016-2021, NVIDIA CORPORATION.  All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto.  Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+#pragma once
+#include <ostream>
+#include <string>
+
+// Records below this level are compiled out, see SampleService::Logging::log_level
+#ifndef SAMPLE_SERVICE_LOG_LEVEL
+#ifdef _DEBUG
+#define SAMPLE_SERVICE_LOG_LEVEL 0
+#else
+#define SAMPLE_SERVICE_LOG_LEVEL 2
+#endif
+#endif
+
+namespace SampleService
+{
+	// Asynchronous logger. The calling thread formats the record straight into its own
+	// lock-free ring, a background thread drains all rings and writes them to the output
+	// in batches, so a request never waits for the disk. When a ring is full the record
+	// is dropped and counted instead of blocking.
+	namespace Logging
+	{
+		enum class log_level : int
+		{
+			trace,
+			debug,
+			info,
+			warning,
+			error,
+
+			max_enum_value
+		};
+
+		constexpr bool isEnabled(log_level level)
+		{
+			return static_cast<int>(level) >= SAMPLE_SERVICE_LOG_LEVEL;
+		}
+
+		// Thin wrapper so wide strings end up in the log as UTF-8 instead of pointers
+		class record_stream
+		{
+			std::ostream& m_out;
+
+		public:
+			explicit record_stream(std::ostream& out) : m_out(out) {}
+
+			template <typename T>
+			record_stream& operator<<(const T& value)
+			{
+				m_out << value;
+				return *this;
+			}
+
+			record_stream& operator<<(const wchar_t* value);
+			record_stream& operator<<(const std::wstring& value);
+		};
+
+		// starts a record in the calling thread's ring, must be followed by commitRecord()
+		record_stream& beginRecord();
+		void commitRecord(log_level level, const char* file, int line);
+
+		// blocks until everything logged so far has been written
+		void flush();
+
+		// Writes everything logged so far to the current output, then switches to out, std::cout
+		// when null. The previous output isn't touched after this returns, so it can be closed.
+		void setOutput(std::ostream* out);
+	}
+}
+
+#define SVC_LOG(level, message) \
+	do \
+	{ \
+		if constexpr (::SampleService::Logging::isEnabled(level)) \
+		{ \
+			::SampleService::Logging::beginRecord() << message; \
+			::SampleService::Logging::commitRecord(level, __FILE__, __LINE__); \
+		} \
+	} while (false)
+
+#define SVC_LOG_TRACE(message) SVC_LOG(::SampleService::Logging::log_level::trace, message)
+#define SVC_LOG_DEBUG(message) SVC_LOG(::SampleService::Logging::log_level::debug, message)
+#define SVC_LOG_INFO(message) SVC_LOG(::SampleService::Logging::log_level::info, message)
+#define SVC_LOG_WARNING(message) SVC_LOG(::SampleService::Logging::log_level::warning, message)
+#define SVC_LOG_ERROR(message) SVC_LOG(::SampleService::Logging::log_level::error, message)
@@ -9,13 +9,16 @@
 */
 #include "lpc_pipe.h"
 #include <assert.h>
+#include <cstddef>
 #include <algorithm>
 #include <AclAPI.h>
-#include <iostream>
+#include "logger.h"
 
 using namespace SampleService;
 
 static const DWORD STATUS_PIPE_BROKEN = 0xc000014b;
+// NTSTATUS of a message-mode read that got only part of the message, ERROR_MORE_DATA once translated
+static const DWORD STATUS_PARTIAL_MESSAGE = 0x80000005;
 
 class SecurityAttributes
 {
@@ -36,7 +39,7 @@ public:
 		if (!AllocateAndInitializeSid(&sid_auth_world, 1,
 			SECURITY_WORLD_RID, 0, 0, 0, 0, 0, 0, 0, &m_sid))
 		{
-			std::cout << "Failed to initialized SID: " << GetLastError() << std::endl;
+			SVC_LOG_ERROR("Failed to initialized SID: " << GetLastError());
 			return false;
 		}
 
@@ -53,21 +56,21 @@ public:
 		const auto result = SetEntriesInAcl(1, &explicit_access, nullptr, &m_acl);
 		if (result != ERROR_SUCCESS)
 		{
-			std::cout << "Failed to set entries in ACL: " << result << std::endl;
+			SVC_LOG_ERROR("Failed to set entries in ACL: " << result);
 			freeFullAccess();
 			return false;
 		}
 
 		if (InitializeSecurityDescriptor(&descriptor, SECURITY_DESCRIPTOR_REVISION) != TRUE)
 		{
-			std::cout << "Failed to initialize security descriptor: " << GetLastError() << std::endl;
+			SVC_LOG_ERROR("Failed to initialize security descriptor: " << GetLastError());
 			freeFullAccess();
 			return false;
 		}
 
 		if (SetSecurityDescriptorDacl(&descriptor, true, m_acl, false) != TRUE)
 		{
-			std::cout << "Failed to set dacl to security descriptor: " << GetLastError() << std::endl;
+			SVC_LOG_ERROR("Failed to set dacl to security descriptor: " << GetLastError());
 			freeFullAccess();
 			return false;
 		}
@@ -110,10 +113,78 @@ private:
 struct transfered_pipe_message
 {
 	details::connection_control control;
+	uint32_t reserved;
+	ULONGLONG deadline; // GetTickCount64() based, Utils::Deadline::infinite if the caller waits forever
 	char payload[1];
 };
 
-static constexpr size_t CONTROL_SIZE = sizeof(transfered_pipe_message) - sizeof(char);
+static constexpr size_t CONTROL_SIZE = offsetof(transfered_pipe_message, payload);
+
+static void invokeCallback(
+	const std::function<t_incoming_message_cbk>& callback,
+	DeserializeIterator& request,
+	SerializeIterator& reply,
+	HANDLE pipe,
+	const Utils::Deadline& deadline)
+{
+	try
+	{
+		LPCPipeContext ctx(pipe, deadline);
+		callback(request, reply, ctx);
+	}
+	catch (const std::exception& e)
+	{
+		SVC_LOG_ERROR("Exception while process message in lpc callback: " << e.what());
+	}
+	catch (...)
+	{
+		SVC_LOG_ERROR("Unknown exception while process message in lpc callback");
+	}
+}
+
+// State of a request handed over to the executor. The job owns copies of everything
+// it touches, including its own pipe handle, so the listener may give up on it
+// (deadline passed, server stopping) without waiting for a stuck handler.
+struct pooled_request
+{
+	std::vector<char> request;
+	std::vector<char> reply;
+	unsigned long reply_size{ 0 };
+	HANDLE pipe{ INVALID_HANDLE_VALUE };
+	Utils::Deadline deadline;
+	std::function<t_incoming_message_cbk> callback;
+	Utils::Event done;
+	// set by whichever of the handler finishing and the listener giving up comes first
+	std::atomic<bool> released{ false };
+	std::atomic<size_t>* abandoned_jobs{ nullptr };
+
+	// the listener stops waiting, counted against the cap until the handler returns the worker
+	void abandon()
+	{
+		abandoned_jobs->fetch_add(1);
+		if (released.exchange(true))
+		{
+			abandoned_jobs->fetch_sub(1);
+		}
+	}
+
+	void finish()
+	{
+		if (released.exchange(true))
+		{
+			abandoned_jobs->fetch_sub(1);
+		}
+		done.signal();
+	}
+
+	~pooled_request()
+	{
+		if (pipe != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(pipe);
+		}
+	}
+};
 
 bool LPCPipeContext::impersonate()
 {
@@ -125,12 +196,12 @@ bool LPCPipeContext::impersonate()
 	const auto result = ImpersonateNamedPipeClient(m_pipe);
 	if (!result)
 	{
-		std::cout << "ImpersonateNamedPipeClient() failed with: " << GetLastError() << std::endl;
+		SVC_LOG_ERROR("ImpersonateNamedPipeClient() failed with: " << GetLastError());
 		return false;
 	}
 
 	m_impersonated = true;
-	std::cout << "Impersonation is enabled for " << std::this_thread::get_id() << std::endl;
+	SVC_LOG_DEBUG("Impersonation is enabled for " << std::this_thread::get_id());
 	return true;
 }
 
@@ -144,12 +215,12 @@ bool LPCPipeContext::revertToSelf()
 	const auto result = RevertToSelf();
 	if (!result)
 	{
-		std::cout << "RevertToSelf() failed with: " << GetLastError() << std::endl;
+		SVC_LOG_ERROR("RevertToSelf() failed with: " << GetLastError());
 		return false;
 	}
 
 	m_impersonated = false;
-	std::cout << "Impersonation is reverted for " << std::this_thread::get_id() << std::endl;
+	SVC_LOG_DEBUG("Impersonation is reverted for " << std::this_thread::get_id());
 	return true;
 }
 
@@ -161,7 +232,7 @@ void LPCPipeServer::checkFinishedListeners()
 	{
 		if (!listener->isConnected())
 		{
-			std::cout << "Found a finished listener: " << (void*)listener << std::endl;
+			SVC_LOG_DEBUG("Found a finished listener: " << (void*)listener);
 			listener->join();
 			delete listener;
 			listener = nullptr;
@@ -175,7 +246,7 @@ void LPCPipeServer::checkFinishedListeners()
 
 void LPCPipeServer::stopAllListeners()
 {
-	std::cout << "Stopping all listeners" << std::endl;
+	SVC_LOG_INFO("Stopping all listeners");
 	m_running = false;
 
 	for (auto& listener : m_listeners)
@@ -200,7 +271,7 @@ void LPCPipeServer::accepterThread()
 		{
 		case details::connection_result::failure:
 		case details::connection_result::interrupt:
-			std::cout << "Interrupt" << std::endl;
+			SVC_LOG_DEBUG("Interrupt");
 			m_running = false;
 			break;
 		case details::connection_result::busy:
@@ -213,7 +284,7 @@ void LPCPipeServer::accepterThread()
 			}
 			catch (const std::exception& e)
 			{
-				std::cout << "Exception when try to add listener: " << e.what() << std::endl;
+				SVC_LOG_ERROR("Exception when try to add listener: " << e.what());
 				CloseHandle(result.second);
 			}
 			break;
@@ -255,11 +326,11 @@ LPCPipeServer::accept_result LPCPipeServer::accept() const
 			return{ details::connection_result::busy, INVALID_HANDLE_VALUE };
 		}
 
-		std::cout << "CreateNamedPipeW() failed with: " << last_error << std::endl;
+		SVC_LOG_ERROR("CreateNamedPipeW() failed with: " << last_error);
 		return{ details::connection_result::failure, INVALID_HANDLE_VALUE };
 	}
 
-	std::cout << "Successfully created pipe named: " << m_name.c_str() << std::endl;
+	SVC_LOG_DEBUG("Successfully created pipe named: " << m_name);
 
 	auto result = ConnectNamedPipe(pipe, m_overlapped.get()) > 0;
 	last_error = GetLastError();
@@ -287,7 +358,7 @@ LPCPipeServer::accept_result LPCPipeServer::accept() const
 
 	if (!result)
 	{
-		std::cout << "ConnectNamedPipe() failed with: " << last_error << std::endl;
+		SVC_LOG_ERROR("ConnectNamedPipe() failed with: " << last_error);
 		return { details::connection_result::failure, INVALID_HANDLE_VALUE };
 	}
 
@@ -304,13 +375,46 @@ const std::function<t_incoming_message_cbk>& LPCPipeServer::callback() const
 	return m_incoming_message_callback;
 }
 
+void LPCPipeServer::setExecutor(ThreadPool& executor, std::function<t_execution_policy_cbk> policy)
+{
+	assert(!m_running);
+	m_executor = &executor;
+	m_execution_policy = std::move(policy);
+}
+
+ThreadPool* LPCPipeServer::executor() const
+{
+	return m_executor;
+}
+
+std::atomic<size_t>& LPCPipeServer::abandonedJobs() const
+{
+	return m_abandoned_jobs;
+}
+
+request_policy LPCPipeServer::executionPolicy(const void* request, size_t size) const
+{
+	if (!m_execution_policy)
+	{
+		return request_policy();
+	}
+
+	DeserializeIterator peek(request, size);
+	auto policy = m_execution_policy(peek);
+	if (m_executor == nullptr)
+	{
+		policy.mode = execution::inline_call;
+	}
+	return policy;
+}
+
 bool LPCPipeServer::start()
 {
 	m_overlapped.reset();
 
 	if (m_running)
 	{
-		std::cout << "Server is already running" << std::endl;
+		SVC_LOG_WARNING("Server is already running");
 		return true;
 	}
 
@@ -372,7 +476,7 @@ bool LPCPipeListener::initialize()
 	}
 	catch (std::exception& e)
 	{
-		std::cout << "Exception occurred: " << e.what() << std::endl;
+		SVC_LOG_ERROR("Exception occurred: " << e.what());
 		return false;
 	}
 
@@ -404,6 +508,7 @@ details::connection_control LPCPipeListener::receive()
 		{
 			// NOTE: actually it's not that remote side is disconnected, but
 			// the IO has been interrupted
+			m_overlapped.cancel(m_pipe);
 			return details::connection_control::remote_disconnected;
 		}
 
@@ -413,37 +518,71 @@ details::connection_control LPCPipeListener::receive()
 		{
 			return details::connection_control::remote_disconnected;;
 		}
+
+		if (ntstatus == STATUS_PARTIAL_MESSAGE)
+		{
+			// the rest of the message would be read as the next frame
+			SVC_LOG_WARNING("Dropping connection, request is larger than the pipe buffer");
+			return details::connection_control::remote_disconnected;
+		}
 	}
 	else if (last_error == ERROR_BROKEN_PIPE)
 	{
 		return details::connection_control::remote_disconnected;
 	}
+	else if (last_error == ERROR_MORE_DATA)
+	{
+		SVC_LOG_WARNING("Dropping connection, request is larger than the pipe buffer");
+		return details::connection_control::remote_disconnected;
+	}
 
 	if (bytes_read == 0)
 	{
-		std::cout << "ReadFile() failed with " << last_error << std::endl;
+		SVC_LOG_ERROR("ReadFile() failed with " << last_error);
 		return details::connection_control::keep_connection;
 	}
 
+	// the header holds the deadline, a frame that doesn't carry all of it would be served with
+	// whatever the previous request left in the buffer
+	if (bytes_read < CONTROL_SIZE)
+	{
+		SVC_LOG_WARNING("Dropping connection, request of " << bytes_read << " bytes is shorter than the header");
+		return details::connection_control::remote_disconnected;
+	}
+
 	if (request_buffer.control == details::connection_control::disconnect)
 	{
 		return details::connection_control::remote_disconnected;
 	}
 
-	DeserializeIterator request(&request_buffer.payload[0], bytes_read - CONTROL_SIZE);
+	// can't wrap, short frames were rejected above
+	const size_t request_size = bytes_read - CONTROL_SIZE;
+	const size_t reply_capacity = m_reply_buffer.size() - CONTROL_SIZE;
+	const auto policy = m_server.executionPolicy(&request_buffer.payload[0], request_size);
+	const Utils::Deadline caller_deadline(request_buffer.deadline);
+	// handlers see whichever runs out first, the caller's wait or the command's own budget
+	const Utils::Deadline deadline = policy.timeout_ms == INFINITE
+		? caller_deadline
+		: Utils::Deadline::earliest(caller_deadline, Utils::Deadline::fromNow(policy.timeout_ms));
 	unsigned long reply_size_ul = 0;
-	SerializeIterator reply(&reply_buffer.payload[0], m_reply_buffer.size() - CONTROL_SIZE, &reply_size_ul);
 
-	try 
+	if (policy.mode == execution::pooled)
 	{
-		LPCPipeContext ctx(m_pipe);
-		m_server.callback()(request, reply, ctx);
+		if (!dispatchToExecutor(&request_buffer.payload[0], request_size, deadline, &reply_buffer.payload[0], reply_capacity, reply_size_ul))
+		{
+			return details::connection_control::remote_disconnected;
+		}
 	}
-	catch (const std::exception& e)
+	else
 	{
-		std::cout << "Exception while process message in lpc callback: " << e.what() << std::endl;
+		DeserializeIterator request(&request_buffer.payload[0], request_size);
+		SerializeIterator reply(&reply_buffer.payload[0], reply_capacity, &reply_size_ul);
+		invokeCallback(m_server.callback(), request, reply, m_pipe, deadline);
 	}
 
+	reply_buffer.control = details::connection_control::keep_connection;
+	reply_buffer.deadline = request_buffer.deadline;
+
 	DWORD bytes_written = 0;
 	result = WriteFile(
 		m_pipe,                       // handle to pipe
@@ -456,16 +595,116 @@ details::connection_control LPCPipeListener::receive()
 
 	if (!result && last_error == ERROR_IO_PENDING)
 	{
-		m_overlapped.wait();
+		// The caller stops reading once its deadline passes, don't let a stuck peer pin this listener
+		switch (m_overlapped.waitFor(caller_deadline.remainingMs()))
+		{
+		case Utils::wait_result::timed_out:
+			SVC_LOG_WARNING("Reply was not consumed before the request deadline, dropping connection");
+			m_overlapped.cancel(m_pipe);
+			return details::connection_control::remote_disconnected;
+		case Utils::wait_result::interrupted:
+			m_overlapped.cancel(m_pipe);
+			return details::connection_control::remote_disconnected;
+		default:
+			break;
+		}
 	}
 
 	return details::connection_control::keep_connection;
 }
 
+bool LPCPipeListener::dispatchToExecutor(
+	const char* request,
+	size_t request_size,
+	const Utils::Deadline& deadline,
+	char* reply,
+	size_t reply_capacity,
+	unsigned long& reply_size)
+{
+	// A handler abandoned at its deadline keeps its worker until it returns. Once that many hold
+	// all but one worker, a new request would only queue behind them and time out, so it fails
+	// right away instead.
+	auto* executor = m_server.executor();
+	const size_t max_abandoned = executor->size() > 1 ? executor->size() - 1 : 1;
+	if (m_server.abandonedJobs().load() >= max_abandoned)
+	{
+		SVC_LOG_WARNING("Rejecting request, " << max_abandoned << " abandoned handlers still hold executor workers");
+		return false;
+	}
+
+	// nothing above the listener catches, an allocation failure must not take the service down
+	std::shared_ptr<pooled_request> job;
+	try
+	{
+		job = std::make_shared<pooled_request>();
+		job->request.assign(request, request + request_size);
+		job->reply.resize(reply_capacity);
+		job->callback = m_server.callback();
+		job->abandoned_jobs = &m_server.abandonedJobs();
+	}
+	catch (const std::exception& e)
+	{
+		SVC_LOG_ERROR("Failed to hand request over to the executor: " << e.what());
+		return false;
+	}
+	job->deadline = deadline;
+
+	// the handler may impersonate the client, give it a handle of its own
+	if (!DuplicateHandle(GetCurrentProcess(), m_pipe, GetCurrentProcess(), &job->pipe, 0, FALSE, DUPLICATE_SAME_ACCESS))
+	{
+		SVC_LOG_ERROR("DuplicateHandle() failed with: " << GetLastError());
+		job->pipe = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	const bool submitted = executor->submit([job]()
+	{
+		// the listener is waiting for this, however the handler leaves
+		struct finish_on_exit
+		{
+			pooled_request& job;
+			~finish_on_exit() { job.finish(); }
+		} finish{ *job };
+
+		DeserializeIterator request_it(job->request.data(), job->request.size());
+		SerializeIterator reply_it(job->reply.data(), job->reply.size(), &job->reply_size);
+		invokeCallback(job->callback, request_it, reply_it, job->pipe, job->deadline);
+	});
+
+	if (!submitted)
+	{
+		SVC_LOG_WARNING("Executor has stopped, dropping connection");
+		return false;
+	}
+
+	// Waiting here is deliberate. The protocol is strictly request then reply on a connection, a
+	// client sends its next request only after reading this reply, so there is no further I/O on
+	// the connection for the listener to do meanwhile. Concurrency comes from the pipe instances,
+	// each connection has a listener of its own. What the hand-over buys is that this wait ends at
+	// the deadline: a handler stuck in the SDK drops its connection instead of pinning the listener.
+
+	switch (m_overlapped.waitForEvent(job->done.handle(), deadline.remainingMs()))
+	{
+	case Utils::wait_result::completed:
+		break;
+	case Utils::wait_result::timed_out:
+		SVC_LOG_WARNING("Pooled handler did not finish before the request deadline, dropping connection");
+		job->abandon();
+		return false;
+	default:
+		job->abandon();
+		return false;
+	}
+
+	memcpy_s(reply, reply_capacity, job->reply.data(), job->reply_size);
+	reply_size = job->reply_size;
+	return true;
+}
+
 void LPCPipeListener::disconnect()
 {
 	assert(m_pipe != INVALID_HANDLE_VALUE);
-	std::cout << "Disconnecting client from: " << m_server.pipeName().c_str() << std::endl;
+	SVC_LOG_DEBUG("Disconnecting client from: " << m_server.pipeName());
 	FlushFileBuffers(m_pipe);
 	DisconnectNamedPipe(m_pipe);
 	CloseHandle(m_pipe);
@@ -474,20 +713,30 @@ void LPCPipeListener::disconnect()
 	m_overlapped.reset();
 }
 
-bool LPCPipeClient::internalSend(
+details::connection_result LPCPipeClient::internalSend(
 	const details::connection_control control,
 	const uint32_t size,
-	uint32_t& reply_size) const
+	uint32_t& reply_size,
+	const Utils::Deadline& deadline) const
 {
+	using namespace details;
+
 	auto& buffer = *(transfered_pipe_message*)m_request_buffer.data();
 
 	if (size > m_request_buffer.size() - CONTROL_SIZE)
 	{
-		std::cout << "size > m_request_buffer.size() - control_size" << std::endl;
-		return false;
+		SVC_LOG_ERROR("size > m_request_buffer.size() - control_size");
+		return connection_result::failure;
+	}
+
+	if (deadline.expired())
+	{
+		return connection_result::timed_out;
 	}
 
 	buffer.control = control;
+	buffer.reserved = 0;
+	buffer.deadline = deadline.tick();
 
 	DWORD bytes_written = 0;
 	auto result = WriteFile(
@@ -501,7 +750,17 @@ bool LPCPipeClient::internalSend(
 
 	if (!result && last_error == ERROR_IO_PENDING)
 	{
-		m_overlapped.wait();
+		switch (m_overlapped.waitFor(deadline.remainingMs()))
+		{
+		case Utils::wait_result::timed_out:
+			m_overlapped.cancel(m_pipe);
+			return connection_result::timed_out;
+		case Utils::wait_result::interrupted:
+			m_overlapped.cancel(m_pipe);
+			return connection_result::interrupt;
+		default:
+			break;
+		}
 		result = true;
 		bytes_written = (DWORD)m_overlapped.get()->InternalHigh;
 		last_error = GetLastError();
@@ -511,7 +770,7 @@ bool LPCPipeClient::internalSend(
 	{
 		assert(L"this shouldn't happen if it does the pipe is probably broken(closed), handle this case");
 		// and check the last_error here
-		return false;
+		return connection_result::failure;
 	}
 
 	DWORD bytes_read = 0;
@@ -526,20 +785,35 @@ bool LPCPipeClient::internalSend(
 
 	if (!result && last_error == ERROR_IO_PENDING)
 	{
-		m_overlapped.wait();
+		switch (m_overlapped.waitFor(deadline.remainingMs()))
+		{
+		case Utils::wait_result::timed_out:
+			m_overlapped.cancel(m_pipe);
+			return connection_result::timed_out;
+		case Utils::wait_result::interrupted:
+			m_overlapped.cancel(m_pipe);
+			return connection_result::interrupt;
+		default:
+			break;
+		}
 		result = true;
 		bytes_read = (DWORD)m_overlapped.get()->InternalHigh;
 		last_error = GetLastError();
 	}
 
-	reply_size = bytes_read - CONTROL_SIZE;
+	if (bytes_read < CONTROL_SIZE)
+	{
+		return connection_result::failure;
+	}
 
-	return true;
+	reply_size = static_cast<uint32_t>(bytes_read - CONTROL_SIZE);
+
+	return connection_result::success;
 }
 
-bool LPCPipeClient::send(uint32_t request_size, uint32_t& reply_size) const
+details::connection_result LPCPipeClient::send(uint32_t request_size, uint32_t& reply_size, const Utils::Deadline& deadline) const
 {
-	return internalSend(details::connection_control::keep_connection, request_size, reply_size);
+	return internalSend(details::connection_control::keep_connection, request_size, reply_size, deadline);
 }
 
 details::connection_result LPCPipeClient::internalConnect()
@@ -577,14 +851,14 @@ details::connection_result LPCPipeClient::internalConnect()
 
 	if (m_pipe == INVALID_HANDLE_VALUE)
 	{
-		std::cout << "CreateFileW() failed with " << last_error << std::endl;
+		SVC_LOG_WARNING("CreateFileW() failed with " << last_error);
 		return connection_result::failure;
 	}
 
 	DWORD mode = PIPE_READMODE_MESSAGE;
 	SetNamedPipeHandleState(m_pipe, &mode, NULL, NULL);
 
-	std::wcout << "Successfully connected pipe named: " << m_name << std::endl;
+	SVC_LOG_DEBUG("Successfully connected pipe named: " << m_name);
 	return connection_result::success;
 }
 
@@ -592,11 +866,11 @@ bool LPCPipeClient::connect(size_t _timeout, size_t refresh_rate)
 {
 	if (isConnected())
 	{
-		std::cout << "Pipe" << m_name.c_str() << " is already connected" << std::endl;
+		SVC_LOG_WARNING("Pipe " << m_name << " is already connected");
 		return false;
 	}
 
-	std::wcout << "Connecting to port: " << m_name << std::endl;
+	SVC_LOG_DEBUG("Connecting to port: " << m_name);
 
 	m_overlapped.reset();
 
@@ -629,7 +903,7 @@ bool LPCPipeClient::connect(size_t _timeout, size_t refresh_rate)
 		diff = std::chrono::duration_cast<ms>(time_now - time_started);
 	}
 
-	std::wcout << "Timed out while connecting to " << m_name << std::endl;
+	SVC_LOG_WARNING("Timed out while connecting to " << m_name);
 	return false;
 }
 
@@ -643,10 +917,10 @@ void LPCPipeClient::disconnect()
 	}
 }
 
-MessageSender LPCPipeClient::getSender()
+MessageSender LPCPipeClient::getSender(const Utils::Deadline& deadline)
 {
 	lock();
-	return MessageSender(*this);
+	return MessageSender(*this, deadline);
 }
 
 bool LPCPipeClient::isConnected() const
@@ -670,7 +944,7 @@ bool LPCPipeClient::initialize()
 	}
 	catch (std::exception& e)
 	{
-		std::cout << "Exception occurred: " << e.what() << std::endl;
+		SVC_LOG_ERROR("Exception occurred: " << e.what());
 		return false;
 	}
 
@@ -8,11 +8,13 @@
 * license agreement from NVIDIA CORPORATION is strictly prohibited.
 */
 #pragma once
+#include <atomic>
 #include <functional>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include "utils.h"
+#include "thread_pool.h"
 #include "serialize_iterator.h"
 #include "deserialize_iterator.h"
 
@@ -35,6 +37,7 @@ namespace SampleService
 			failure,
 			busy,
 			interrupt,
+			timed_out,
 
 			max_enum_value
 		};
@@ -62,9 +65,11 @@ namespace SampleService
 	{
 		HANDLE m_pipe;
 		bool m_impersonated{ false };
+		const Utils::Deadline m_deadline;
 	public:
-		LPCPipeContext(HANDLE pipe) :
-			m_pipe(pipe)
+		LPCPipeContext(HANDLE pipe, const Utils::Deadline& deadline = Utils::Deadline()) :
+			m_pipe(pipe),
+			m_deadline(deadline)
 		{
 		}
 
@@ -75,6 +80,11 @@ namespace SampleService
 
 		bool impersonate();
 		bool revertToSelf();
+
+		// deadline of the request as set by the caller
+		const Utils::Deadline& deadline() const { return m_deadline; }
+		// true when the caller has already given up waiting for the reply
+		bool expired() const { return m_deadline.expired(); }
 	};
 
 	typedef void (t_incoming_message_cbk)(
@@ -82,6 +92,22 @@ namespace SampleService
 		SerializeIterator& reply,
 		LPCPipeContext& ctx);
 
+	enum class execution
+	{
+		inline_call, // run on the connection's listener thread, for cheap requests
+		pooled,      // run on the server executor, the listener waits for the reply until the deadline
+	};
+
+	struct request_policy
+	{
+		execution mode{ execution::inline_call };
+		// server side budget for the request, on top of the deadline the caller sent
+		DWORD timeout_ms{ INFINITE };
+	};
+
+	// decides where and how long a request runs, gets its own iterator over the request payload
+	typedef request_policy (t_execution_policy_cbk)(DeserializeIterator& request);
+
 	static constexpr size_t DEFAULT_PIPE_BUFFER_SIZE = 32 * 1024;
 
 	class LPCPipeListener;
@@ -96,6 +122,9 @@ namespace SampleService
 		const bool m_allow_non_admin;
 		std::vector<LPCPipeListener*> m_listeners;
 		mutable std::mutex m_stopping_mutex;
+		ThreadPool* m_executor{ nullptr };
+		std::function<t_execution_policy_cbk> m_execution_policy;
+		mutable std::atomic<size_t> m_abandoned_jobs{ 0 };
 
 		void accepterThread();
 
@@ -122,6 +151,16 @@ namespace SampleService
 
 		const std::function<t_incoming_message_cbk>& callback() const;
 
+		// Must be called before start(). Without an executor every request runs inline.
+		void setExecutor(ThreadPool& executor, std::function<t_execution_policy_cbk> policy);
+
+		ThreadPool* executor() const;
+
+		// pooled handlers still holding a worker after their listener stopped waiting for them
+		std::atomic<size_t>& abandonedJobs() const;
+
+		request_policy executionPolicy(const void* request, size_t size) const;
+
 		bool start();
 
 		void stop();
@@ -141,6 +180,13 @@ namespace SampleService
 		const LPCPipeServer& m_server;
 
 		details::connection_control receive();
+		bool dispatchToExecutor(
+			const char* request,
+			size_t request_size,
+			const Utils::Deadline& deadline,
+			char* reply,
+			size_t reply_capacity,
+			unsigned long& reply_size);
 		void listenerThread();
 
 		bool initialize();
@@ -189,11 +235,15 @@ namespace SampleService
 
 	private:
 
-		bool internalSend(details::connection_control control, uint32_t size, uint32_t& reply_size) const;
+		details::connection_result internalSend(
+			details::connection_control control,
+			uint32_t size,
+			uint32_t& reply_size,
+			const Utils::Deadline& deadline) const;
 
 		details::connection_result internalConnect();
 
-		bool send(uint32_t request_size, uint32_t& reply_size) const;
+		details::connection_result send(uint32_t request_size, uint32_t& reply_size, const Utils::Deadline& deadline) const;
 
 		void lock()
 		{ 
@@ -224,7 +274,7 @@ namespace SampleService
 
 		bool isConnected() const;
 
-		MessageSender getSender();
+		MessageSender getSender(const Utils::Deadline& deadline = Utils::Deadline());
 
 		friend class MessageSender;
 
@@ -234,6 +284,8 @@ namespace SampleService
 	class MessageSender
 	{
 		LPCPipeClient& m_transport;
+		const Utils::Deadline m_deadline;
+		mutable bool m_timed_out{ false };
 
 	public:
 		MessageSender(const MessageSender&) = delete;
@@ -242,7 +294,9 @@ namespace SampleService
 		MessageSender(MessageSender&&) noexcept;
 		MessageSender& operator=(MessageSender&&) = delete;
 
-		MessageSender(LPCPipeClient& transport) : m_transport(transport)
+		MessageSender(LPCPipeClient& transport, const Utils::Deadline& deadline) :
+			m_transport(transport),
+			m_deadline(deadline)
 		{}
 		~MessageSender()
 		{ 
@@ -261,13 +315,32 @@ namespace SampleService
 			details::serialize_impl(it, args...);
 
 			uint32_t reply_size = 0;
-			if (!m_transport.send(message_size, reply_size))
+			const auto result = m_transport.send(message_size, reply_size, m_deadline);
+			if (result != details::connection_result::success)
 			{
+				if (result == details::connection_result::timed_out)
+				{
+					// a late reply may still arrive on this pipe instance,
+					// so drop the connection and let the next call reconnect
+					m_timed_out = true;
+					m_transport.disconnect();
+				}
+				else if (result == details::connection_result::failure)
+				{
+					// most likely the server went away, a client kept open across calls
+					// would otherwise keep failing on the dead pipe
+					m_transport.disconnect();
+				}
 				return DeserializeIterator(nullptr, 0);
 			}
 
 			return DeserializeIterator(bufs.first, reply_size);
 		}
+
+		bool timedOut() const
+		{
+			return m_timed_out;
+		}
 	};
 
 	template<typename ... ARGS>
@@ -329,6 +329,31 @@ public:
 		return{ m_mem + control_block_size, *max_buf_size, real_buf_size, m_realsize };
 	}
 
+	// everything written so far including the argc cell, empty after an overflow
+	memory_view written() const
+	{
+		if (m_write_error || *m_realsize > m_maxsize)
+		{
+			return{ nullptr, 0UL };
+		}
+		return{ m_argc, static_cast<unsigned long>(*m_realsize) };
+	}
+
+	// replaces the content with an image previously taken with written()
+	bool assign(const memory_view& image)
+	{
+		if (image.size() < cell_size || image.size() > m_maxsize)
+		{
+			return false;
+		}
+
+		memcpy_s(m_argc, static_cast<size_t>(m_maxsize), image.mem(), image.size());
+		m_mem = reinterpret_cast<char*>(m_argc) + image.size();
+		*m_realsize = image.size();
+		m_write_error = false;
+		return true;
+	}
+
 private:
 	char* m_mem;
 	cell_type* m_argc;
@@ -0,0 +1,251 @@
+/*
+* Copyright (c) 2016-2021, NVIDIA CORPORATION.  All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto.  Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+#include "thread_pool.h"
+#include "logger.h"
+#include <chrono>
+
+using namespace SampleService;
+
+// index of the pool worker running on this thread, used to keep nested submissions local
+static thread_local const ThreadPool* t_owner_pool = nullptr;
+static thread_local size_t t_worker_index = 0;
+
+// how many injected tasks a worker moves into its own deque at once, so others have something to steal
+static constexpr size_t INJECTION_BATCH_SIZE = 16;
+// a worker that sees pending work it can't take yet yields this many times before it parks
+static constexpr size_t PENDING_SPIN_ROUNDS = 64;
+// and parks this long at a time, unless a submission wakes it first
+static constexpr std::chrono::milliseconds PENDING_BACKOFF{ 1 };
+
+ThreadPool::ThreadPool(const config& cfg)
+{
+	auto threads = cfg.threads;
+	if (threads == 0)
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+	if (threads == 0)
+	{
+		threads = 2;
+	}
+
+	m_workers.reserve(threads);
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_workers.emplace_back(std::make_unique<worker>());
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		auto& w = *m_workers[i];
+		w.thread = std::thread(&ThreadPool::workerThread, this, i);
+
+		if (!cfg.affinity_masks.empty())
+		{
+			const auto mask = cfg.affinity_masks[i % cfg.affinity_masks.size()];
+			if (mask != 0 && SetThreadAffinityMask(w.thread.native_handle(), mask) == 0)
+			{
+				SVC_LOG_ERROR("SetThreadAffinityMask() failed with: " << GetLastError());
+			}
+		}
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+bool ThreadPool::submit(task fn)
+{
+	// counted before the check, a worker doesn't exit while m_pending is non-zero, so a task that
+	// got past the check always runs
+	m_pending.fetch_add(1);
+	if (!m_running)
+	{
+		m_pending.fetch_sub(1);
+		return false;
+	}
+
+	try
+	{
+		if (t_owner_pool == this)
+		{
+			auto& w = *m_workers[t_worker_index];
+			std::lock_guard<std::mutex> lock(w.mutex);
+			w.tasks.push_back(std::move(fn));
+		}
+		else
+		{
+			auto* n = new details::MpscQueue::node;
+			n->task = std::move(fn);
+			m_injection.push(n);
+		}
+	}
+	catch (...)
+	{
+		// nothing was queued, don't leave stop() waiting for it
+		m_pending.fetch_sub(1);
+		throw;
+	}
+
+	wakeOne();
+	return true;
+}
+
+void ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_park_mutex);
+		m_running = false;
+	}
+	m_park_cv.notify_all();
+
+	for (auto& w : m_workers)
+	{
+		if (w->thread.joinable())
+		{
+			w->thread.join();
+		}
+	}
+}
+
+void ThreadPool::wakeOne()
+{
+	// take the lock so a worker that just checked m_pending can't miss the notification
+	{
+		std::lock_guard<std::mutex> lock(m_park_mutex);
+	}
+	m_park_cv.notify_one();
+}
+
+void ThreadPool::workerThread(size_t index)
+{
+	t_owner_pool = this;
+	t_worker_index = index;
+
+	size_t missed_rounds = 0;
+	for (;;)
+	{
+		task fn;
+		if (popLocal(index, fn) || drainInjection(index, fn) || steal(index, fn))
+		{
+			missed_rounds = 0;
+			m_pending.fetch_sub(1, std::memory_order_acq_rel);
+			try
+			{
+				fn();
+			}
+			catch (const std::exception& e)
+			{
+				SVC_LOG_ERROR("Exception while running pooled task: " << e.what());
+			}
+			catch (...)
+			{
+				SVC_LOG_ERROR("Unknown exception while running pooled task");
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_park_mutex);
+		const bool pending = m_pending.load(std::memory_order_acquire) > 0;
+		if (!m_running && !pending)
+		{
+			break;
+		}
+
+		if (!pending)
+		{
+			missed_rounds = 0;
+			m_park_cv.wait(lock, [this]() {
+				return !m_running || m_pending.load(std::memory_order_acquire) > 0;
+			});
+		}
+		else if (++missed_rounds <= PENDING_SPIN_ROUNDS)
+		{
+			// another worker holds the drain flag or a push is half linked, both clear up quickly
+			lock.unlock();
+			std::this_thread::yield();
+		}
+		else
+		{
+			m_park_cv.wait_for(lock, PENDING_BACKOFF);
+		}
+	}
+
+	t_owner_pool = nullptr;
+}
+
+bool ThreadPool::popLocal(size_t index, task& fn)
+{
+	auto& w = *m_workers[index];
+	std::lock_guard<std::mutex> lock(w.mutex);
+	if (w.tasks.empty())
+	{
+		return false;
+	}
+
+	// LIFO for the owner keeps recently touched data in cache
+	fn = std::move(w.tasks.back());
+	w.tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::drainInjection(size_t index, task& fn)
+{
+	if (m_draining.exchange(true, std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	auto* first = m_injection.pop();
+	if (first != nullptr)
+	{
+		fn = std::move(first->task);
+		delete first;
+
+		auto& w = *m_workers[index];
+		for (size_t i = 0; i < INJECTION_BATCH_SIZE; ++i)
+		{
+			auto* n = m_injection.pop();
+			if (n == nullptr)
+			{
+				break;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(w.mutex);
+				w.tasks.push_front(std::move(n->task));
+			}
+			delete n;
+		}
+	}
+
+	m_draining.store(false, std::memory_order_release);
+	return first != nullptr;
+}
+
+bool ThreadPool::steal(size_t index, task& fn)
+{
+	const auto count = m_workers.size();
+	for (size_t i = 1; i < count; ++i)
+	{
+		auto& victim = *m_workers[(index + i) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			// FIFO for thieves takes the oldest work
+			fn = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
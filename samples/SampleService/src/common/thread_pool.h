@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2016-2021, NVIDIA CORPORATION.  All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto.  Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils.h"
+
+namespace SampleService
+{
+	namespace details
+	{
+		// Intrusive multi-producer single-consumer queue (D. Vyukov).
+		// push() is wait-free and may be called from any thread,
+		// pop() must only be called by one consumer at a time.
+		class MpscQueue : public Utils::NonCopyable
+		{
+		public:
+			struct node
+			{
+				std::atomic<node*> next{ nullptr };
+				std::function<void()> task;
+			};
+
+			MpscQueue() :
+				m_head(&m_stub),
+				m_tail(&m_stub)
+			{}
+
+			~MpscQueue()
+			{
+				while (auto* n = pop())
+				{
+					delete n;
+				}
+			}
+
+			void push(node* n)
+			{
+				n->next.store(nullptr, std::memory_order_relaxed);
+				node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+				prev->next.store(n, std::memory_order_release);
+			}
+
+			// returns nullptr when the queue is empty or a producer is in the middle of a push
+			node* pop()
+			{
+				node* tail = m_tail;
+				node* next = tail->next.load(std::memory_order_acquire);
+
+				if (tail == &m_stub)
+				{
+					if (next == nullptr)
+					{
+						return nullptr;
+					}
+					m_tail = next;
+					tail = next;
+					next = next->next.load(std::memory_order_acquire);
+				}
+
+				if (next != nullptr)
+				{
+					m_tail = next;
+					return tail;
+				}
+
+				if (tail != m_head.load(std::memory_order_acquire))
+				{
+					return nullptr;
+				}
+
+				push(&m_stub);
+
+				next = tail->next.load(std::memory_order_acquire);
+				if (next != nullptr)
+				{
+					m_tail = next;
+					return tail;
+				}
+				return nullptr;
+			}
+
+		private:
+			std::atomic<node*> m_head;
+			node* m_tail;
+			node m_stub;
+		};
+	}
+
+	// Work-stealing pool used to run command handlers away from the pipe I/O threads.
+	// External submissions land in a lock-free MPSC queue, whichever idle worker wins the
+	// drain flag moves them into its own deque, and the other workers steal from there.
+	class ThreadPool : public Utils::NonCopyable
+	{
+	public:
+		using task = std::function<void()>;
+
+		struct config
+		{
+			// 0 - one worker per hardware thread
+			size_t threads = 0;
+			// optional per-worker affinity masks, worker N uses masks[N % masks.size()]
+			std::vector<DWORD_PTR> affinity_masks;
+		};
+
+		ThreadPool() : ThreadPool(config()) {}
+		explicit ThreadPool(const config& cfg);
+		~ThreadPool();
+
+		// false once stop() has been called, the task is dropped without running
+		bool submit(task fn);
+		// runs what was submitted before it, then joins the workers
+		void stop();
+
+		size_t size() const { return m_workers.size(); }
+
+	private:
+		struct worker
+		{
+			std::thread thread;
+			std::mutex mutex;
+			std::deque<task> tasks;
+		};
+
+		std::vector<std::unique_ptr<worker>> m_workers;
+		details::MpscQueue m_injection;
+		std::atomic<bool> m_draining{ false };
+		std::atomic<size_t> m_pending{ 0 };
+		std::atomic<bool> m_running{ true };
+		std::mutex m_park_mutex;
+		std::condition_variable m_park_cv;
+
+		void workerThread(size_t index);
+
+		bool popLocal(size_t index, task& fn);
+		bool drainInjection(size_t index, task& fn);
+		bool steal(size_t index, task& fn);
+		void wakeOne();
+	};
+}
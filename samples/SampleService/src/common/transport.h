@@ -68,22 +68,31 @@ namespace SampleService
 			}
 		}
 
+		// timeout bounds the whole call: connecting, sending the request and waiting for the reply.
+		// The deadline travels with the request, so the server can skip work nobody waits for anymore.
 		template <typename ... RETVALS, typename ... ARGS>
 		std::tuple<status, RETVALS...> send_impl(LPCPipeClient& pipe, size_t timeout, command cmd, const ARGS&... args)
 		{
 			std::tuple<status, RETVALS...> ret;
+			const auto deadline = Utils::Deadline::fromNow(timeout);
 
 			if (!pipe.isConnected())
 			{
-				if (!pipe.connect(timeout))
+				if (!pipe.connect(deadline.remainingMs()))
 				{
-					std::get<0>(ret) = status::failed_to_create_pipe;
+					std::get<0>(ret) = deadline.expired() ? status::timed_out : status::failed_to_create_pipe;
 					return ret;
 				}
 			}
 
-			const auto sender = pipe.getSender();
+			const auto sender = pipe.getSender(deadline);
 			DeserializeIterator deserializer = sender.send(cmd, args...);
+			if (sender.timedOut())
+			{
+				std::get<0>(ret) = status::timed_out;
+				return ret;
+			}
+
 			deserializer_to_tuple_check_finalize(deserializer, ret);
 			return ret;
 		}
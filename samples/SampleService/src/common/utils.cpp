@@ -44,14 +44,54 @@ void InterruptableOverlapped::interrupt() const
 }
 
 bool InterruptableOverlapped::wait() const
+{
+	return waitFor(INFINITE) == wait_result::completed;
+}
+
+wait_result InterruptableOverlapped::waitFor(DWORD timeout_ms) const
 {
 	const auto wait_status = WaitForMultipleObjects(
 		2,				// we have only two events:
 		&m_events[0],	// one for message another for the cancel event
 		false,			// wait for any of them
-		INFINITE);
+		timeout_ms);
+
+	switch (wait_status)
+	{
+	case WAIT_OBJECT_0:
+		return wait_result::completed;
+	case WAIT_TIMEOUT:
+		return wait_result::timed_out;
+	default:
+		return wait_result::interrupted;
+	}
+}
 
-	return wait_status == WAIT_OBJECT_0;
+wait_result InterruptableOverlapped::waitForEvent(HANDLE event, DWORD timeout_ms) const
+{
+	const HANDLE events[2] = { event, m_cancel_event };
+	const auto wait_status = WaitForMultipleObjects(2, &events[0], false, timeout_ms);
+
+	switch (wait_status)
+	{
+	case WAIT_OBJECT_0:
+		return wait_result::completed;
+	case WAIT_TIMEOUT:
+		return wait_result::timed_out;
+	default:
+		return wait_result::interrupted;
+	}
+}
+
+void InterruptableOverlapped::cancel(HANDLE file) const
+{
+	// The OVERLAPPED structure must stay untouched until the kernel is done with it,
+	// so wait for the cancelled operation to actually complete before returning
+	if (CancelIoEx(file, get()) || GetLastError() != ERROR_NOT_FOUND)
+	{
+		DWORD transferred = 0;
+		GetOverlappedResult(file, get(), &transferred, TRUE);
+	}
 }
 
 void InterruptableOverlapped::reset() const
@@ -60,6 +100,31 @@ void InterruptableOverlapped::reset() const
 	ResetEvent(m_cancel_event);
 }
 
+Deadline Deadline::fromNow(size_t timeout_ms)
+{
+	if (timeout_ms >= INFINITE)
+	{
+		return Deadline();
+	}
+
+	return Deadline(GetTickCount64() + timeout_ms);
+}
+
+bool Deadline::expired() const
+{
+	return !isInfinite() && GetTickCount64() >= m_expires_at;
+}
+
+DWORD Deadline::remainingMs() const
+{
+	if (isInfinite())
+	{
+		return INFINITE;
+	}
+
+	const auto now = GetTickCount64();
+	return now >= m_expires_at ? 0 : static_cast<DWORD>(m_expires_at - now);
+}
 
 void Event::createEvent(bool manual_reset)
 {
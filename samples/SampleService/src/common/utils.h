@@ -38,12 +38,55 @@ namespace SampleService
 			};
 
 			operator bool() const { return m_event_object != nullptr; }
+			HANDLE handle() const { return m_event_object; }
 			void signal() const;
 			void wait() const;
 			bool waitAlertable() const;
 			void reset() const;
 		};
 
+		// Point in time expressed in GetTickCount64() ticks. The tick counter is
+		// shared by all processes on the machine, so a deadline can be handed over
+		// a local pipe as is.
+		class Deadline
+		{
+			ULONGLONG m_expires_at;
+
+		public:
+			static constexpr ULONGLONG infinite = 0;
+
+			Deadline() : m_expires_at(infinite) {}
+			explicit Deadline(ULONGLONG expires_at) : m_expires_at(expires_at) {}
+
+			static Deadline fromNow(size_t timeout_ms);
+
+			// the stricter of the two, any finite deadline wins over an infinite one
+			static Deadline earliest(const Deadline& a, const Deadline& b)
+			{
+				if (a.isInfinite())
+				{
+					return b;
+				}
+				if (b.isInfinite())
+				{
+					return a;
+				}
+				return a.m_expires_at < b.m_expires_at ? a : b;
+			}
+
+			ULONGLONG tick() const { return m_expires_at; }
+			bool isInfinite() const { return m_expires_at == infinite; }
+			bool expired() const;
+			DWORD remainingMs() const;
+		};
+
+		enum class wait_result
+		{
+			completed,
+			interrupted,
+			timed_out
+		};
+
 		class InterruptableOverlapped
 		{
 			OVERLAPPED m_overlapped;
@@ -60,6 +103,10 @@ namespace SampleService
 			OVERLAPPED* get() const { return const_cast<OVERLAPPED*>(&m_overlapped); }
 			void interrupt() const;
 			bool wait() const;
+			wait_result waitFor(DWORD timeout_ms) const;
+			// waits for an arbitrary event while still honoring interrupt()
+			wait_result waitForEvent(HANDLE event, DWORD timeout_ms) const;
+			void cancel(HANDLE file) const;
 			void reset() const;
 		};
 
@@ -18,19 +18,23 @@
 namespace SampleService
 {
 	using namespace Transport;
-	static const size_t connect_timeout_ms = 10 * 1000; // 10 seconds
 
 	ServiceClient::ServiceClient()
 		: m_pipe(interface_port_name)
 	{}
 
-	std::tuple<status, std::wstring> ServiceClient::create(const std::wstring& name)
+	std::tuple<status, std::wstring> ServiceClient::create(const std::wstring& name, size_t timeout_ms)
 	{
-		return send_impl<std::wstring>(m_pipe, connect_timeout_ms, command::create, name);
+		return send_impl<std::wstring>(m_pipe, timeout_ms, command::create, name);
 	}
 
-	std::tuple<status, std::wstring, std::wstring> ServiceClient::isRunningInCloudSecure()
+	std::tuple<status, std::wstring, std::wstring> ServiceClient::isRunningInCloudSecure(size_t timeout_ms)
 	{
-		return send_impl<std::wstring, std::wstring>(m_pipe, connect_timeout_ms, command::isRunningInCloudSecure);
+		return send_impl<std::wstring, std::wstring>(m_pipe, timeout_ms, command::isRunningInCloudSecure);
+	}
+
+	bool ServiceClient::isConnected() const
+	{
+		return m_pipe.isConnected();
 	}
 }
@@ -17,11 +17,17 @@ namespace SampleService
 	class ServiceClient
 	{
 	public:
+		// Bounds connect + request + reply of a single call
+		static constexpr size_t default_call_timeout_ms = 10 * 1000; // 10 seconds
+
 		ServiceClient();
 
-		std::tuple<status, std::wstring> create(const std::wstring& name);
+		std::tuple<status, std::wstring> create(const std::wstring& name, size_t timeout_ms = default_call_timeout_ms);
+
+		std::tuple<status, std::wstring, std::wstring> isRunningInCloudSecure(size_t timeout_ms = default_call_timeout_ms);
 
-		std::tuple<status, std::wstring, std::wstring> isRunningInCloudSecure();
+		// The pipe is opened by the first call and stays open for the ones after it
+		bool isConnected() const;
 
 	private:
 		LPCPipeClient m_pipe;
@@ -9,14 +9,68 @@
 */
 #include "server.h"
 #include <cassert>
+#include <chrono>
 #include <sstream>
-#include <iostream>
+#include <logger.h>
 #include "GfnRuntimeSdk_Wrapper.h"
+#include "GfnSdk_SecureLoadLibrary.h"
 
 namespace SampleService
 {
-	ServiceServer::ServiceServer()
-		: m_pipe(
+	// Clients such as the launcher keep their connection open, and a listener serves one connection
+	// until it closes, so leave room for the launcher, the game and a few more at the same time
+	static constexpr size_t MAX_PIPE_INSTANCES = 8;
+
+	constexpr ServiceServer::command_table ServiceServer::buildCommandTable()
+	{
+		command_table table{};
+		auto at = [&table](command cmd) -> command_traits& { return table[static_cast<size_t>(cmd)]; };
+
+		at(command::create) = {
+			&ServiceServer::createHandler,
+			execution_policy::inline_call,
+			0 /* not cacheable */,
+			4 * 1024,
+			1000 };
+		// signature check of the cloud library is expensive, keep it off the I/O thread and
+		// answer repeated queries from memory, the environment does not change under a running service.
+		// Only answers are cached, a failed check is retried by the next query. Clients asking at
+		// the same time wait for the check that is already running and take its cached answer
+		at(command::isRunningInCloudSecure) = {
+			&ServiceServer::isRunningInCloudRequestHandler,
+			execution_policy::exclusive,
+			5 * 1000,
+			256,
+			10 * 1000 };
+
+		return table;
+	}
+
+	constexpr bool ServiceServer::isComplete(const command_table& table)
+	{
+		for (const auto& entry : table)
+		{
+			if (entry.handler == nullptr || entry.max_payload == 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	constexpr ServiceServer::command_table ServiceServer::s_commands = ServiceServer::buildCommandTable();
+
+	const ServiceServer::command_traits* ServiceServer::lookup(command cmd)
+	{
+		static_assert(isComplete(s_commands), "every command needs an entry in buildCommandTable()");
+
+		const auto index = static_cast<size_t>(cmd);
+		return index < s_commands.size() ? &s_commands[index] : nullptr;
+	}
+
+	ServiceServer::ServiceServer(const ThreadPool::config& executor_config)
+		: m_executor(executor_config)
+		, m_pipe(
 			interface_port_name,
 			std::bind(
 				&ServiceServer::receiver,
@@ -25,49 +79,163 @@ namespace SampleService
 				std::placeholders::_2,
 				std::placeholders::_3),
 			true /* allow non-admin users */,
-			1 /* max instances */ )
+			MAX_PIPE_INSTANCES)
+	{
+		m_pipe.setExecutor(
+			m_executor,
+			std::bind(&ServiceServer::executionPolicy, this, std::placeholders::_1));
+	}
+
+	ServiceServer::~ServiceServer()
+	{
+		// stop accepting requests first, then let the handlers that are still running finish
+		// while the server is alive
+		m_pipe.stop();
+		m_executor.stop();
+	}
+
+	request_policy ServiceServer::executionPolicy(DeserializeIterator& request) const
+	{
+		const auto* traits = lookup(request.get<command>());
+		if (traits == nullptr)
+		{
+			// command_not_found reply is cheap
+			return request_policy();
+		}
+
+		request_policy policy;
+		policy.mode = traits->policy == execution_policy::inline_call ? execution::inline_call : execution::pooled;
+		policy.timeout_ms = traits->timeout_ms;
+		return policy;
+	}
+
+	bool ServiceServer::lockExclusive(std::unique_lock<std::timed_mutex>& lock, const LPCPipeContext& ctx)
+	{
+		const auto remaining_ms = ctx.deadline().remainingMs();
+		if (remaining_ms == INFINITE)
+		{
+			lock.lock();
+			return true;
+		}
+		return lock.try_lock_for(std::chrono::milliseconds(remaining_ms));
+	}
+
+	bool ServiceServer::replyFromCache(command cmd, SerializeIterator& reply)
 	{
-		registerCommands();
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		const auto& cached = m_reply_cache[static_cast<size_t>(cmd)];
+		if (cached.image.empty() || GetTickCount64() >= cached.expires_at)
+		{
+			return false;
+		}
+		return reply.assign(memory_view(cached.image.data(), cached.image.size()));
+	}
+
+	void ServiceServer::storeInCache(command cmd, const command_traits& traits, const SerializeIterator& reply)
+	{
+		const auto image = reply.written();
+		if (image.size() == 0)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		auto& cached = m_reply_cache[static_cast<size_t>(cmd)];
+		cached.image.assign(image.mem(), image.mem() + image.size());
+		cached.expires_at = GetTickCount64() + traits.cache_ttl_ms;
 	}
 
 	void ServiceServer::receiver(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& ctx)
 	{
 		const auto cmd = request.get<command>();
-		const auto handler = m_root_commands.find(cmd);
+		const auto* traits = lookup(cmd);
 
 		auto* status = reply.reserve(status::failed_to_process_command);
-		if (handler == std::end(m_root_commands))
+		if (traits == nullptr)
 		{
 			*status = status::command_not_found;
 			return;
 		}
 
+		if (request.size() > traits->max_payload)
+		{
+			SVC_LOG_WARNING("Rejecting command, request of " << request.size() << " bytes is over the limit");
+			*status = status::invalid_request;
+			return;
+		}
+
+		if (ctx.expired())
+		{
+			SVC_LOG_WARNING("Skipping command, the caller's deadline has already passed");
+			*status = status::timed_out;
+			return;
+		}
+
+		// cacheable commands take no arguments, a request carrying any goes on to the handler and fails there
+		const bool cached_command = traits->cache_ttl_ms != 0 && request.finalize();
+		if (cached_command && replyFromCache(cmd, reply))
+		{
+			return;
+		}
+
+		bool cacheable = false;
 		try
 		{
-			*status = m_root_commands[cmd](request, reply, ctx);
+			std::unique_lock<std::timed_mutex> exclusive(m_exclusive_mutex, std::defer_lock);
+			if (traits->policy == execution_policy::exclusive)
+			{
+				if (!lockExclusive(exclusive, ctx))
+				{
+					SVC_LOG_WARNING("Skipping command, another exclusive command held on past the caller's deadline");
+					*status = status::timed_out;
+					return;
+				}
+
+				// the command that held the lock may just have cached the answer
+				if (cached_command && replyFromCache(cmd, reply))
+				{
+					return;
+				}
+			}
+
+			const auto result = (this->*traits->handler)(request, reply, ctx);
+			*status = result.code;
+			cacheable = result.cacheable;
 		}
 		catch (const std::exception& e)
 		{
-			std::cout << "Failed to process command " <<  " exception: " << e.what() << std::endl;
+			SVC_LOG_ERROR("Failed to process command " <<  " exception: " << e.what());
 			*status = status::failed_to_process_command;
 		}
+
+		if (traits->cache_ttl_ms != 0 && cacheable && *status == status::success)
+		{
+			storeInCache(cmd, *traits, reply);
+		}
 	}
 
 	status ServiceServer::start()
 	{
 		try {
+			// The service verifies the SDK libraries once and records the result for the launcher
+			// and games, which only read it
+			if (!gfnSetPersistentVerificationCache(gfnVerificationCacheReadWrite))
+			{
+				SVC_LOG_WARNING("Not sharing library verification results: " << GetLastError());
+			}
+
 			// Initialize Geforce NOW Runtime SDK using the C calling convention.
 			GfnRuntimeError err = GfnInitializeSdk(gfnDefaultLanguage);
 			if (err != gfnSuccess)
 			{
-				std::cout << "Error initializing the sdk: " << err << std::endl;
+				SVC_LOG_ERROR("Error initializing the sdk: " << err);
 			}
 
 			return m_pipe.start() ? status::success : status::failed_to_start_service;
 		}
 		catch (const std::exception& e)
 		{
-			std::cout << "Failed to start, exception occurred: " << e.what() << std::endl;
+			SVC_LOG_ERROR("Failed to start, exception occurred: " << e.what());
 			return status::failed_to_start_service;
 		}
 	}
@@ -77,13 +245,13 @@ namespace SampleService
 		return{ status::success, name + L"_out" };
 	}
 
-	status ServiceServer::createHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& /*ctx*/)
+	ServiceServer::handler_result ServiceServer::createHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& /*ctx*/)
 	{
 		const auto name = request.get<std::wstring>();
 
 		if (!request.finalize())
 		{
-			std::cout << "Failed to deserialize request @ create_handler" << std::endl;
+			SVC_LOG_ERROR("Failed to deserialize request @ create_handler");
 			return status::deserialization_error;
 		}
 
@@ -92,38 +260,31 @@ namespace SampleService
 		return result;
 	}
 
-	std::tuple<status, std::wstring, std::wstring> ServiceServer::isRunningInCloudSecure()
+	std::tuple<status, GfnError, std::wstring> ServiceServer::isRunningInCloudSecure()
 	{
 		GfnIsRunningInCloudAssurance assurance = GfnIsRunningInCloudAssurance::gfnNotCloud;
 		GfnError err = GfnIsRunningInCloudSecure(&assurance);
 		if (err != GfnError::gfnSuccess)
 		{
-			std::cout << "Failed to get if running in cloud. Error: " << err << std::endl;
-			return{ status::success, std::to_wstring(err), L"Failed to get if running in cloud.Error: " + err};
+			SVC_LOG_ERROR("Failed to get if running in cloud. Error: " << err);
+			return{ status::success, err, L"Failed to get if running in cloud.Error: " + err};
 		}
-		std::cout << "GfnIsRunningInCloudSecure assurance " << assurance << "\n";
+		SVC_LOG_INFO("GfnIsRunningInCloudSecure assurance " << assurance);
 
-		return{ status::success, std::to_wstring(err), std::to_wstring(assurance)};
+		return{ status::success, err, std::to_wstring(assurance)};
 	}
 
-	status ServiceServer::isRunningInCloudRequestHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& /*ctx*/)
+	ServiceServer::handler_result ServiceServer::isRunningInCloudRequestHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& /*ctx*/)
 	{
 		if (!request.finalize())
 		{
-			std::cout << "Failed to deserialize request @ handleisRunningInCloudRequest" << std::endl;
+			SVC_LOG_ERROR("Failed to deserialize request @ handleisRunningInCloudRequest");
 			return status::deserialization_error;
 		}
 		
 		const auto& [result, gfnerror, response] = isRunningInCloudSecure();
-		reply.put(gfnerror);
+		reply.put(std::to_wstring(gfnerror));
 		reply.put(response);
-		return result;
-	}
-
-	void ServiceServer::registerCommands()
-	{
-		namespace p = std::placeholders;
-		m_root_commands.emplace(command::create, std::bind(&ServiceServer::createHandler, this, p::_1, p::_2, p::_3));
-		m_root_commands.emplace(command::isRunningInCloudSecure, std::bind(&ServiceServer::isRunningInCloudRequestHandler, this, p::_1, p::_2, p::_3));
+		return { result, gfnerror == GfnError::gfnSuccess };
 	}
 }
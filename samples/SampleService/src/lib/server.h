@@ -10,46 +10,98 @@
 #pragma once
 
 #include <lpc_pipe.h>
-#include <functional>
-#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <vector>
 #include "status.h"
 #include "command.h"
 #include "port_name.h"
+#include "GfnRuntimeSdk_Wrapper.h"
 
 namespace SampleService
 {
+	enum class execution_policy
+	{
+		inline_call, // cheap, runs on the listener thread
+		pooled,      // runs on the executor
+		exclusive,   // runs on the executor, never concurrently with another exclusive command
+	};
+
 	class ServiceServer : public Utils::NonCopyable
 	{
-		typedef status(t_handler)(
+		// what a handler reports back besides its reply
+		struct handler_result
+		{
+			handler_result(status code, bool cacheable = true) : code(code), cacheable(cacheable) {}
+
+			status code;
+			// false keeps a successful reply out of the cache, e.g. when it carries a transient error
+			bool cacheable;
+		};
+
+		typedef handler_result(ServiceServer::*t_handler)(
 			DeserializeIterator& request,
 			SerializeIterator& reply,
 			LPCPipeContext& ctx);
 
-		using dispatch_table = std::unordered_map<command, std::function<t_handler>>;
+		struct command_traits
+		{
+			t_handler handler;
+			execution_policy policy;
+			// replies of argument-less commands can be served from memory for this long, 0 - never
+			DWORD cache_ttl_ms;
+			// whole serialized request, larger ones are rejected before the handler runs
+			size_t max_payload;
+			// server side budget, the handler sees the earlier of this and the caller's deadline
+			DWORD timeout_ms;
+		};
+
+		// indexed by command, one slot per enumerator
+		using command_table = std::array<command_traits, static_cast<size_t>(command::max_enum_value)>;
+
+		static const command_table s_commands;
+		static constexpr command_table buildCommandTable();
+		static constexpr bool isComplete(const command_table& table);
+		static const command_traits* lookup(command cmd);
+
+		struct cached_reply
+		{
+			std::vector<char> image;
+			ULONGLONG expires_at{ 0 };
+		};
 
 		///////////////////////////////////////////////
+		// declared before m_pipe, listeners may still hand work over while the pipe shuts down
+		ThreadPool m_executor;
 		LPCPipeServer m_pipe;
-		dispatch_table m_root_commands;
+		std::timed_mutex m_exclusive_mutex;
+		std::mutex m_cache_mutex;
+		std::array<cached_reply, static_cast<size_t>(command::max_enum_value)> m_reply_cache;
+
+		bool lockExclusive(std::unique_lock<std::timed_mutex>& lock, const LPCPipeContext& ctx);
+		bool replyFromCache(command cmd, SerializeIterator& reply);
+		void storeInCache(command cmd, const command_traits& traits, const SerializeIterator& reply);
 
 		void receiver(
 			DeserializeIterator& request,
 			SerializeIterator& reply,
 			LPCPipeContext& ctx);
 
+		request_policy executionPolicy(DeserializeIterator& request) const;
+
 		///////////////////////////////////////////////
 		// command handlers
-		status createHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& ctx);
+		handler_result createHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& ctx);
 
 		std::tuple<status, std::wstring> create(const std::wstring& name);
 
-		status isRunningInCloudRequestHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& ctx);
-
-		std::tuple<status, std::wstring, std::wstring> isRunningInCloudSecure();
+		handler_result isRunningInCloudRequestHandler(DeserializeIterator& request, SerializeIterator& reply, LPCPipeContext& ctx);
 
-		void registerCommands();
+		std::tuple<status, GfnError, std::wstring> isRunningInCloudSecure();
 
 	public:
-		ServiceServer();
+		explicit ServiceServer(const ThreadPool::config& executor_config = ThreadPool::config());
+		~ServiceServer();
 		status start();
 	};
 }
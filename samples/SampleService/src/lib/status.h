@@ -30,6 +30,7 @@ namespace SampleService
 		help_requested,
 		failed_to_start_service,
 		failed_to_process_command,
+		timed_out,
 
 		max_enum_value
 	};
@@ -50,6 +51,7 @@ namespace SampleService
 			NV_CASE_RETURN_ENUM_STRING(status::help_requested);
 			NV_CASE_RETURN_ENUM_STRING(status::failed_to_start_service);
 			NV_CASE_RETURN_ENUM_STRING(status::failed_to_process_command);
+			NV_CASE_RETURN_ENUM_STRING(status::timed_out);
 			NV_CASE_RETURN_ENUM_STRING(status::max_enum_value);
 		}
 		return L"Unknown enumeration. Add me to enumPrinter";
@@ -17,6 +17,7 @@
 #include <fstream>
 #include "service.h"
 #include "utils.h"
+#include "logger.h"
 
 namespace SampleService
 {
@@ -27,7 +28,6 @@ namespace SampleService
 		static std::wstring g_service_name;
 		static service_run g_run;
 		static service_stop g_stop;
-		static std::streambuf *g_coutOriginalBuffer;
 
 		static uint32_t reportStatus(uint32_t current_status, uint32_t exit_code = NO_ERROR)
 		{
@@ -49,7 +49,7 @@ namespace SampleService
 			if (!SetServiceStatus(g_service_status_handle, &g_service_status))
 			{
 				const uint32_t result = GetLastError();
-				std::cout << "Failed to set service status, error: " << result << std::endl;
+				SVC_LOG_ERROR("Failed to set service status, error: " << result);
 				return result;
 			}
 
@@ -78,9 +78,8 @@ namespace SampleService
 				const bool wait_for_finish = dwControl == SERVICE_CONTROL_SHUTDOWN;
 				assert(g_stop);
 				g_stop(wait_for_finish);
-				std::cout << "Service Stopping" << std::endl;
-				//Restore cout's original buffer back.
-				std::cout.rdbuf(g_coutOriginalBuffer);
+				SVC_LOG_INFO("Service Stopping");
+				Logging::flush();
 			}
 			else
 			{
@@ -98,7 +97,7 @@ namespace SampleService
 			auto hr = SHGetKnownFolderPath(FOLDERID_ProgramData, KF_FLAG_DEFAULT, NULL, &programDataPath);
 			if (FAILED(hr))
 			{
-				std::cout << "Could not get path to local app data folder" << std::endl;
+				SVC_LOG_ERROR("Could not get path to local app data folder");
 				return;
 			}
 
@@ -109,24 +108,23 @@ namespace SampleService
 			int createDirResult = SHCreateDirectoryExW(NULL, pathSS.str().c_str(), NULL);
 			if (createDirResult != ERROR_SUCCESS && createDirResult != ERROR_FILE_EXISTS && createDirResult != ERROR_ALREADY_EXISTS)
 			{
-				std::cout << "Could not create logging directory" << std::endl;
+				SVC_LOG_ERROR("Could not create logging directory");
 				return;
 			}
 
 			pathSS << "\\GfnSdkSampleService.log";
 
-			// To write to a file using cout, first save the std::cout buffer and then assign it to log file
-			g_coutOriginalBuffer = std::cout.rdbuf();
 			std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
 			std::ofstream out(converter.to_bytes(pathSS.str()).c_str());
-			//Write to log through std::cout 
-    		std::cout.rdbuf(out.rdbuf());
+			// Only the log writer thread writes the file, it lets go of it before the file is closed
+			Logging::setOutput(&out);
 
 			int result = NO_ERROR;
 			g_service_status_handle = RegisterServiceCtrlHandlerExW(g_service_name.c_str(), serviceControl, NULL);
 			if (g_service_status_handle == nullptr)
 			{
-				std::cout << "Failed to register service control handler, error: " << GetLastError() << std::endl;
+				SVC_LOG_ERROR("Failed to register service control handler, error: " << GetLastError());
+				Logging::setOutput(nullptr);
 				return;
 			}
 			result = initializeService();
@@ -141,6 +139,9 @@ namespace SampleService
 				result = g_run();
 			}
 			reportStatus(SERVICE_STOPPED, result);
+
+			// the log file is closed on return, don't let the writer touch it afterwards
+			Logging::setOutput(nullptr);
 		}
 
 		uint32_t run(const std::wstring& service_name, service_run&& run, service_stop&& stop)
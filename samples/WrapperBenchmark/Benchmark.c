@@ -0,0 +1,130 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Benchmark.h"
+#include "MockRuntimeSdk.h"
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <dlfcn.h>
+#endif
+
+#define BENCHMARK_SAMPLES           51
+#define BENCHMARK_SAMPLE_TARGET_NS  1000000ull
+
+static int CompareDoubles(const void* a, const void* b)
+{
+    double lhs = *(const double*)a;
+    double rhs = *(const double*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static unsigned long long TimeIterations(BenchmarkBodyFn body, void* pContext, unsigned int iterations)
+{
+    unsigned long long start = gfnMockNowNs();
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        body(pContext);
+    }
+    return gfnMockNowNs() - start;
+}
+
+void BenchmarkRun(const char* name, BenchmarkBodyFn body, void* pContext, unsigned int maxIterations, BenchmarkResult* result)
+{
+    double perCall[BENCHMARK_SAMPLES];
+
+    // Warm up caches and branch predictors, then double the batch until a sample is long enough to time reliably
+    unsigned int iterations = 1;
+    TimeIterations(body, pContext, iterations);
+    while (TimeIterations(body, pContext, iterations) < BENCHMARK_SAMPLE_TARGET_NS &&
+        iterations < 0x40000000u && (maxIterations == 0 || iterations * 2 <= maxIterations))
+    {
+        iterations *= 2;
+    }
+
+    for (unsigned int sample = 0; sample < BENCHMARK_SAMPLES; ++sample)
+    {
+        perCall[sample] = (double)TimeIterations(body, pContext, iterations) / iterations;
+    }
+    qsort(perCall, BENCHMARK_SAMPLES, sizeof(perCall[0]), CompareDoubles);
+
+    result->name = name;
+    result->iterations = iterations;
+    result->samples = BENCHMARK_SAMPLES;
+    result->minNs = perCall[0];
+    result->medianNs = perCall[BENCHMARK_SAMPLES / 2];
+    result->p99Ns = perCall[(BENCHMARK_SAMPLES * 99) / 100];
+}
+
+void BenchmarkPrintHeader(void)
+{
+    printf("%-48s %10s %10s %10s %10s %12s\n", "benchmark", "calls", "min ns", "median ns", "p99 ns", "overhead ns");
+}
+
+void BenchmarkPrint(const BenchmarkResult* result, const BenchmarkResult* baseline)
+{
+    printf("%-48s %10u %10.1f %10.1f %10.1f", result->name, result->iterations, result->minNs, result->medianNs, result->p99Ns);
+    if (baseline != NULL)
+    {
+        printf(" %12.1f", result->medianNs - baseline->medianNs);
+    }
+    printf("\n");
+}
+
+BenchmarkModule BenchmarkLoadModule(const char* path)
+{
+#ifdef _WIN32
+    return (BenchmarkModule)LoadLibraryA(path);
+#else
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+void* BenchmarkGetSymbol(BenchmarkModule module, const char* name)
+{
+#ifdef _WIN32
+    return (void*)GetProcAddress((HMODULE)module, name);
+#else
+    return dlsym(module, name);
+#endif
+}
+
+void BenchmarkFreeModule(BenchmarkModule module)
+{
+    if (module == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    FreeLibrary((HMODULE)module);
+#else
+    dlclose(module);
+#endif
+}
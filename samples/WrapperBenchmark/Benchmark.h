@@ -0,0 +1,71 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+// Minimal micro-benchmark harness used to measure the per-call overhead of the wrapper.
+// Each benchmark is calibrated so one sample takes about a millisecond, then a series of
+// samples is taken and the per-call minimum, median and 99th percentile are reported.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /// One call of the operation under test
+    typedef void(*BenchmarkBodyFn)(void* pContext);
+
+    typedef struct BenchmarkResult
+    {
+        const char* name;
+        unsigned int iterations;    ///< Calls per sample
+        unsigned int samples;
+        double minNs;               ///< Per call
+        double medianNs;            ///< Per call
+        double p99Ns;               ///< Per call
+    } BenchmarkResult;
+
+    /// Runs body repeatedly and fills result. A non-zero maxIterations caps the calls per sample,
+    /// for operations that accumulate state with every call.
+    void BenchmarkRun(const char* name, BenchmarkBodyFn body, void* pContext, unsigned int maxIterations, BenchmarkResult* result);
+
+    void BenchmarkPrintHeader(void);
+    /// Prints one result, with the difference to baseline when one is given
+    void BenchmarkPrint(const BenchmarkResult* result, const BenchmarkResult* baseline);
+
+    /// Thin portability layer over LoadLibrary/GetProcAddress and dlopen/dlsym
+    typedef void* BenchmarkModule;
+    BenchmarkModule BenchmarkLoadModule(const char* path);
+    void* BenchmarkGetSymbol(BenchmarkModule module, const char* name);
+    void BenchmarkFreeModule(BenchmarkModule module);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // BENCHMARK_H
@@ -0,0 +1,476 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+// Measures the per-call overhead the wrapper adds on top of the runtime library exports.
+// The stand-in libraries from MockRuntimeSdk.c take the place of the signed NVIDIA libraries,
+// so results only describe the wrapper and the calling machine, not GeForce NOW itself.
+// It also checks every image digest backend the processor supports against known SHA-256
+// answers and each other, then measures their throughput on a buffer and optionally a file.
+//
+// Usage: WrapperBenchmark [-latency <us>] [-client <GfnRuntimeSdk path>] [-cloud <GFN path>]
+//                         [-digest-size <MiB>] [-digest-file <path>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "Benchmark.h"
+#include "MockRuntimeSdk.h"
+#include "GfnSdk_ImageDigest.h"
+#ifdef _WIN32
+#include "GfnRuntimeSdk_Wrapper.h"
+#endif
+
+#ifndef GFN_MOCK_CLIENT_LIBRARY
+#   define GFN_MOCK_CLIENT_LIBRARY "GfnRuntimeSdk.dll"
+#endif
+#ifndef GFN_MOCK_CLOUD_LIBRARY
+#   define GFN_MOCK_CLOUD_LIBRARY "GFN.dll"
+#endif
+
+typedef GfnRuntimeError(*gfnGetClientInfoFn)(GfnClientInfo* clientInfo);
+typedef bool(*gfnIsTitleAvailableFn)(const char* platformAppId);
+
+typedef struct BenchmarkContext
+{
+    BenchmarkModule cloudModule;
+    gfnGetClientInfoFn GetClientInfo;
+    gfnIsTitleAvailableFn IsTitleAvailable;
+    gfnMockInvokeClientInfoCallbackFn InvokeClientInfoCallback;
+    const char* clientPath;
+    GfnClientInfo clientInfo;
+    volatile unsigned long long sink;    // keeps results observable so calls are not optimized away
+} BenchmarkContext;
+
+static const char* g_titleId = "mock_title_1";
+
+static void LookupGetClientInfo(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)(size_t)BenchmarkGetSymbol(context->cloudModule, "gfnGetClientInfo");
+}
+
+static void DirectGetClientInfo(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)context->GetClientInfo(&context->clientInfo);
+}
+
+static void DirectIsTitleAvailable(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += context->IsTitleAvailable(g_titleId);
+}
+
+#ifdef _WIN32
+static GfnApplicationCallbackResult GFN_CALLBACK OnClientInfoUpdate(GfnClientInfoUpdateData* pUpdate, const void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)pUpdate->data.osType;
+    return crCallbackSuccess;
+}
+
+static void WrapperGetClientInfo(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)GfnGetClientInfo(&context->clientInfo);
+}
+
+static void WrapperIsTitleAvailable(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    bool isAvailable = false;
+    GfnIsTitleAvailable(g_titleId, &isAvailable);
+    context->sink += isAvailable;
+}
+
+static void WrapperIsRunningInCloud(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    bool isCloud = false;
+    GfnIsRunningInCloud(&isCloud);
+    context->sink += isCloud;
+}
+
+static void WrapperIsRunningInCloudSecure(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    GfnIsRunningInCloudAssurance assurance = gfnNotCloud;
+    GfnIsRunningInCloudSecure(&assurance);
+    context->sink += (unsigned long long)assurance;
+}
+
+static void WrapperRegisterClientInfoCallback(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)GfnRegisterClientInfoCallback(OnClientInfoUpdate, context);
+}
+
+static void WrapperClientInfoDelivery(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->InvokeClientInfoCallback();
+}
+
+static void WrapperInitializeShutdown(void* pContext)
+{
+    BenchmarkContext* context = (BenchmarkContext*)pContext;
+    context->sink += (unsigned long long)GfnInitializeSdkFromPath(gfnDefaultLanguage, context->clientPath);
+    GfnShutdownSdk();
+}
+
+// LoadLibrary expects backslashes, cmake hands out paths with forward slashes
+static void ToNativePath(char* path)
+{
+    for (; *path != '\0'; ++path)
+    {
+        if (*path == '/')
+        {
+            *path = '\\';
+        }
+    }
+}
+#endif
+
+typedef struct DigestContext
+{
+    const unsigned char* data;
+    uint64_t size;
+    const char* path;
+    GfnDigestBackend backend;
+    volatile unsigned int sink;
+} DigestContext;
+
+static const struct
+{
+    GfnDigestBackend backend;
+    const char* name;
+} g_digestBackends[] =
+{
+    { gfnDigestBackendScalar, "scalar" },
+    { gfnDigestBackendAvx2, "avx2" },
+    { gfnDigestBackendShaNi, "sha-ni" },
+};
+
+// FIPS 180-2 examples
+static const struct
+{
+    const char* message;
+    const char* digest;
+} g_sha256Vectors[] =
+{
+    { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+};
+
+static void DigestBuffer(void* pContext)
+{
+    DigestContext* context = (DigestContext*)pContext;
+    GfnImageDigest digest;
+    gfnDigestImage(context->data, context->size, context->backend, &digest);
+    context->sink += digest.bytes[0];
+}
+
+static void DigestFile(void* pContext)
+{
+    DigestContext* context = (DigestContext*)pContext;
+    GfnImageDigest digest;
+    gfnDigestImagePathA(context->path, context->backend, &digest);
+    context->sink += digest.bytes[0];
+}
+
+static void FormatDigest(const unsigned char* digest, char* text)
+{
+    for (int i = 0; i < GFN_SHA256_DIGEST_SIZE; ++i)
+    {
+        snprintf(text + 2 * i, 3, "%02x", digest[i]);
+    }
+}
+
+// Every supported backend must reproduce the known answers, and the image digests of the scalar
+// code for sizes around the block, chunk and lane boundaries
+static bool CheckDigestBackends(const unsigned char* data, uint64_t dataSize)
+{
+    static const uint64_t chunk = GFN_IMAGE_DIGEST_CHUNK_SIZE;
+    const uint64_t sizes[] = { 0, 1, 55, 56, 63, 64, 65, chunk - 1, chunk, chunk + 1,
+        8 * chunk - 1, 8 * chunk, 8 * chunk + 1, 9 * chunk + 5, 16 * chunk, 17 * chunk + 3, dataSize };
+    bool passed = true;
+
+    for (size_t b = 0; b < sizeof(g_digestBackends) / sizeof(g_digestBackends[0]); ++b)
+    {
+        GfnDigestBackend backend = g_digestBackends[b].backend;
+        if (!gfnIsDigestBackendSupported(backend))
+        {
+            printf("%-48s not supported by this processor\n", g_digestBackends[b].name);
+            continue;
+        }
+
+        unsigned int failures = 0;
+        for (size_t v = 0; v < sizeof(g_sha256Vectors) / sizeof(g_sha256Vectors[0]); ++v)
+        {
+            unsigned char digest[GFN_SHA256_DIGEST_SIZE];
+            char text[2 * GFN_SHA256_DIGEST_SIZE + 1];
+            gfnSha256(g_sha256Vectors[v].message, strlen(g_sha256Vectors[v].message), backend, digest);
+            FormatDigest(digest, text);
+            failures += strcmp(text, g_sha256Vectors[v].digest) != 0;
+        }
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+        {
+            GfnImageDigest expected;
+            GfnImageDigest actual;
+            uint64_t size = sizes[i] < dataSize ? sizes[i] : dataSize;
+            gfnDigestImage(data, size, gfnDigestBackendScalar, &expected);
+            gfnDigestImage(data, size, backend, &actual);
+            failures += memcmp(&expected, &actual, sizeof(expected)) != 0;
+        }
+
+        printf("%-48s %s\n", g_digestBackends[b].name, failures == 0 ? "passed" : "FAILED");
+        passed = passed && failures == 0;
+    }
+    return passed;
+}
+
+static uint64_t GetFileSize64(const char* path)
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    return _stat64(path, &info) == 0 ? (uint64_t)info.st_size : 0;
+#else
+    struct stat info;
+    return stat(path, &info) == 0 ? (uint64_t)info.st_size : 0;
+#endif
+}
+
+static void PrintThroughput(const BenchmarkResult* result, uint64_t bytes)
+{
+    printf("%-48s %10.0f MB/s\n", "", (double)bytes / result->medianNs * 1000.0);
+}
+
+static bool RunDigestBenchmarks(unsigned int sizeMiB, const char* filePath)
+{
+    DigestContext context;
+    memset(&context, 0, sizeof(context));
+    context.size = (uint64_t)sizeMiB * 1024 * 1024;
+    unsigned char* data = (unsigned char*)malloc((size_t)context.size + 1);
+    if (data == NULL)
+    {
+        printf("Unable to allocate %u MiB for the digest benchmarks\n", sizeMiB);
+        return false;
+    }
+
+    // Incompressible, so nothing can shortcut the work
+    unsigned int x = 0x9E3779B9u;
+    for (uint64_t i = 0; i < context.size; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (unsigned char)x;
+    }
+    context.data = data;
+
+    printf("\nImage digest self-check\n");
+    if (!CheckDigestBackends(data, context.size))
+    {
+        free(data);
+        return false;
+    }
+
+    printf("\n");
+    BenchmarkPrintHeader();
+    for (size_t b = 0; b < sizeof(g_digestBackends) / sizeof(g_digestBackends[0]); ++b)
+    {
+        if (!gfnIsDigestBackendSupported(g_digestBackends[b].backend))
+        {
+            continue;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "image digest %u MiB (%s)", sizeMiB, g_digestBackends[b].name);
+        context.backend = g_digestBackends[b].backend;
+
+        BenchmarkResult result;
+        BenchmarkRun(name, DigestBuffer, &context, 0, &result);
+        BenchmarkPrint(&result, NULL);
+        PrintThroughput(&result, context.size);
+    }
+
+    if (filePath != NULL)
+    {
+        GfnImageDigest digest;
+        context.path = filePath;
+        context.backend = gfnDigestBackendAuto;
+        if (!gfnDigestImagePathA(filePath, context.backend, &digest))
+        {
+            printf("Unable to map %s\n", filePath);
+        }
+        else
+        {
+            // Includes opening and mapping the file, the page cache is warm after the first call
+            BenchmarkResult result;
+            BenchmarkRun("image digest of file (auto)", DigestFile, &context, 0, &result);
+            BenchmarkPrint(&result, NULL);
+            PrintThroughput(&result, GetFileSize64(filePath));
+        }
+    }
+
+    free(data);
+    return true;
+}
+
+static bool ConfigureMock(BenchmarkModule module, const GfnMockConfig* config)
+{
+    gfnMockConfigureFn configure = (gfnMockConfigureFn)BenchmarkGetSymbol(module, "gfnMockConfigure");
+    if (configure == NULL)
+    {
+        return false;
+    }
+    configure(config);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    char clientPath[1024] = GFN_MOCK_CLIENT_LIBRARY;
+    char cloudPath[1024] = GFN_MOCK_CLOUD_LIBRARY;
+    GfnMockConfig config = { 0, 0, gfnSuccess, gfnSuccess, true, true };
+    unsigned int digestSizeMiB = 16;
+    const char* digestFile = NULL;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-latency") == 0)
+        {
+            config.callLatencyUs = (unsigned int)strtol(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-client") == 0)
+        {
+            snprintf(clientPath, sizeof(clientPath), "%s", argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "-cloud") == 0)
+        {
+            snprintf(cloudPath, sizeof(cloudPath), "%s", argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "-digest-size") == 0)
+        {
+            digestSizeMiB = (unsigned int)strtol(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-digest-file") == 0)
+        {
+            digestFile = argv[i + 1];
+        }
+        else
+        {
+            printf("Usage: %s [-latency <us>] [-client <GfnRuntimeSdk path>] [-cloud <GFN path>]"
+                " [-digest-size <MiB>] [-digest-file <path>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    ToNativePath(clientPath);
+    ToNativePath(cloudPath);
+#endif
+
+    // Holding our own reference keeps the wrapper from unloading the libraries between
+    // init/shutdown cycles, so that benchmark measures the wrapper rather than the OS loader
+    BenchmarkContext context;
+    memset(&context, 0, sizeof(context));
+    context.clientPath = clientPath;
+    BenchmarkModule clientModule = BenchmarkLoadModule(clientPath);
+    context.cloudModule = BenchmarkLoadModule(cloudPath);
+    if (clientModule == NULL || context.cloudModule == NULL)
+    {
+        printf("Unable to load the stand-in libraries:\n    %s\n    %s\n", clientPath, cloudPath);
+        return 1;
+    }
+
+    context.GetClientInfo = (gfnGetClientInfoFn)BenchmarkGetSymbol(context.cloudModule, "gfnGetClientInfo");
+    context.IsTitleAvailable = (gfnIsTitleAvailableFn)BenchmarkGetSymbol(context.cloudModule, "gfnIsTitleAvailable");
+    context.InvokeClientInfoCallback = (gfnMockInvokeClientInfoCallbackFn)BenchmarkGetSymbol(context.cloudModule, "gfnMockInvokeClientInfoCallback");
+    gfnMockGetCallCountFn getCallCount = (gfnMockGetCallCountFn)BenchmarkGetSymbol(context.cloudModule, "gfnMockGetCallCount");
+    if (!ConfigureMock(clientModule, &config) || !ConfigureMock(context.cloudModule, &config) ||
+        context.GetClientInfo == NULL || context.IsTitleAvailable == NULL ||
+        context.InvokeClientInfoCallback == NULL || getCallCount == NULL)
+    {
+        printf("The libraries are missing mock exports, is %s a stand-in library?\n", cloudPath);
+        return 1;
+    }
+
+    printf("Mock call latency: %u us\n\n", config.callLatencyUs);
+    BenchmarkPrintHeader();
+
+    BenchmarkResult lookup;
+    BenchmarkResult directClientInfo;
+    BenchmarkResult directTitleAvailable;
+    BenchmarkRun("symbol lookup (gfnGetClientInfo)", LookupGetClientInfo, &context, 0, &lookup);
+    BenchmarkPrint(&lookup, NULL);
+    BenchmarkRun("direct gfnGetClientInfo", DirectGetClientInfo, &context, 0, &directClientInfo);
+    BenchmarkPrint(&directClientInfo, NULL);
+    BenchmarkRun("direct gfnIsTitleAvailable", DirectIsTitleAvailable, &context, 0, &directTitleAvailable);
+    BenchmarkPrint(&directTitleAvailable, NULL);
+
+#ifdef _WIN32
+    // Only honored by wrapper builds with GFN_SDK_ALLOW_UNSIGNED_LIBRARY
+    SetEnvironmentVariableA("GFN_SDK_CLOUD_LIBRARY_PATH", cloudPath);
+
+    GfnRuntimeError err = GfnInitializeSdkFromPath(gfnDefaultLanguage, clientPath);
+    if (GFNSDK_FAILED(err))
+    {
+        printf("Error initializing the sdk against the stand-in libraries: %d\n", err);
+        return 1;
+    }
+
+    BenchmarkResult result;
+    BenchmarkRun("GfnGetClientInfo", WrapperGetClientInfo, &context, 0, &result);
+    BenchmarkPrint(&result, &directClientInfo);
+    BenchmarkRun("GfnIsTitleAvailable", WrapperIsTitleAvailable, &context, 0, &result);
+    BenchmarkPrint(&result, &directTitleAvailable);
+    BenchmarkRun("GfnIsRunningInCloud", WrapperIsRunningInCloud, &context, 0, &result);
+    BenchmarkPrint(&result, NULL);
+    BenchmarkRun("GfnIsRunningInCloudSecure", WrapperIsRunningInCloudSecure, &context, 0, &result);
+    BenchmarkPrint(&result, NULL);
+    // Every registration allocates a context inside the wrapper, keep the number of calls bounded
+    BenchmarkRun("GfnRegisterClientInfoCallback", WrapperRegisterClientInfoCallback, &context, 4096, &result);
+    BenchmarkPrint(&result, NULL);
+    BenchmarkRun("client info callback delivery", WrapperClientInfoDelivery, &context, 0, &result);
+    BenchmarkPrint(&result, NULL);
+
+    GfnShutdownSdk();
+    BenchmarkRun("GfnInitializeSdkFromPath + GfnShutdownSdk", WrapperInitializeShutdown, &context, 0, &result);
+    BenchmarkPrint(&result, NULL);
+#else
+    printf("\nThe wrapper is only available on Windows, only the library baselines were measured\n");
+#endif
+
+    printf("\nCalls served by the cloud stand-in: %llu\n", getCallCount());
+
+    BenchmarkFreeModule(context.cloudModule);
+    BenchmarkFreeModule(clientModule);
+
+    return RunDigestBenchmarks(digestSizeMiB, digestFile) ? 0 : 1;
+}
@@ -0,0 +1,388 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+#include <stdlib.h>
+#include <string.h>
+#include "MockRuntimeSdk.h"
+
+#ifdef _WIN32
+#   define MOCK_INCREMENT(counter) InterlockedIncrement64(counter)
+#else
+#   define MOCK_INCREMENT(counter) __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED)
+#endif
+
+// The cloud library calls back with (status, data, context), the wrapper registers trampolines of this shape
+typedef void (GFN_CALLBACK* GfnMockCloudCallback)(int status, void* pData, void* pContext);
+
+static GfnMockConfig s_config = { 0, 0, gfnSuccess, gfnSuccess, true, true };
+static bool s_configured = false;
+static volatile long long s_callCount = 0;
+
+static void* s_clientInfoCallback = NULL;
+static void* s_clientInfoContext = NULL;
+
+static void mockSpin(unsigned int latencyUs)
+{
+    if (latencyUs == 0)
+    {
+        return;
+    }
+
+    // Sleep granularity is far too coarse for microsecond latencies, so busy wait instead
+    unsigned long long deadline = gfnMockNowNs() + (unsigned long long)latencyUs * 1000ull;
+    while (gfnMockNowNs() < deadline)
+    {
+    }
+}
+
+static void mockEnter(void)
+{
+    MOCK_INCREMENT(&s_callCount);
+    mockSpin(s_config.callLatencyUs);
+}
+
+static unsigned int mockReadEnvironment(const char* name, unsigned int defaultValue)
+{
+    const char* value = getenv(name);
+    return (value != NULL && value[0] != '\0') ? (unsigned int)strtol(value, NULL, 10) : defaultValue;
+}
+
+static GfnRuntimeError mockInitialize(void)
+{
+    if (!s_configured)
+    {
+        s_config.callLatencyUs = mockReadEnvironment("GFN_MOCK_CALL_LATENCY_US", s_config.callLatencyUs);
+        s_config.initLatencyUs = mockReadEnvironment("GFN_MOCK_INIT_LATENCY_US", s_config.initLatencyUs);
+        s_config.callResult = (GfnRuntimeError)(int)mockReadEnvironment("GFN_MOCK_CALL_RESULT", (unsigned int)s_config.callResult);
+        s_config.runningInCloud = mockReadEnvironment("GFN_MOCK_NOT_CLOUD", 0) == 0;
+        s_configured = true;
+    }
+
+    mockEnter();
+    mockSpin(s_config.initLatencyUs);
+    return s_config.initResult;
+}
+
+void NVGFNSDKApi gfnMockConfigure(const GfnMockConfig* config)
+{
+    if (config != NULL)
+    {
+        s_config = *config;
+        s_configured = true;
+    }
+}
+
+unsigned long long NVGFNSDKApi gfnMockGetCallCount(void)
+{
+    return (unsigned long long)s_callCount;
+}
+
+void NVGFNSDKApi gfnMockInvokeClientInfoCallback(void)
+{
+    GfnMockCloudCallback callback = (GfnMockCloudCallback)s_clientInfoCallback;
+    if (callback == NULL)
+    {
+        return;
+    }
+
+    GfnClientInfoUpdateData update;
+    update.version = GfnClientInfoVersion;
+    update.updateType = gfnOs;
+    update.data.osType = gfnWindows;
+    callback(gfnSuccess, &update, s_clientInfoContext);
+}
+
+// Client library entry points
+
+GfnRuntimeError NVGFNSDKApi gfnInitializeRuntimeSdk(GfnDisplayLanguage displayLanguage)
+{
+    (void)displayLanguage;
+    return mockInitialize();
+}
+
+void NVGFNSDKApi gfnShutdownRuntimeSdk(void)
+{
+    mockEnter();
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterStreamStatusCallback(StreamStatusCallbackSig streamStatusCallback, void* pUserContext)
+{
+    (void)streamStatusCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnStartStream(StartStreamInput* pStartStreamInput, StartStreamResponse* response)
+{
+    (void)pStartStreamInput;
+    mockEnter();
+    if (response != NULL)
+    {
+        response->downloaded = false;
+    }
+    return s_config.callResult;
+}
+
+void NVGFNSDKApi gfnStartStreamAsync(const StartStreamInput* pStartStreamInput, StartStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+{
+    (void)pStartStreamInput;
+    (void)timeoutMs;
+    mockEnter();
+    if (cb != NULL)
+    {
+        StartStreamResponse response = { false };
+        cb(s_config.callResult, &response, context);
+    }
+}
+
+GfnRuntimeError NVGFNSDKApi gfnStopStream(void)
+{
+    mockEnter();
+    return s_config.callResult;
+}
+
+void NVGFNSDKApi gfnStopStreamAsync(StopStreamCallbackSig cb, void* context, unsigned int timeoutMs)
+{
+    (void)timeoutMs;
+    mockEnter();
+    if (cb != NULL)
+    {
+        cb(s_config.callResult, context);
+    }
+}
+
+GfnRuntimeError NVGFNSDKApi gfnTitleExited(const char* pchPlatformId, const char* pchPlatformAppId)
+{
+    (void)pchPlatformId;
+    (void)pchPlatformAppId;
+    mockEnter();
+    return s_config.callResult;
+}
+
+// Cloud library entry points
+
+NVGFNSDK_EXPORT GfnRuntimeError NVGFNSDKApi gfnInitializeRuntimeSdk3(char* strLibVersion)
+{
+    (void)strLibVersion;
+    return mockInitialize();
+}
+
+NVGFNSDK_EXPORT void NVGFNSDKApi gfnShutdownRuntimeSdk2(void)
+{
+    mockEnter();
+    s_clientInfoCallback = NULL;
+    s_clientInfoContext = NULL;
+}
+
+NVGFNSDK_EXPORT bool NVGFNSDKApi gfnIsInitialized(void)
+{
+    return s_configured;
+}
+
+bool NVGFNSDKApi gfnIsRunningInCloud(void)
+{
+    mockEnter();
+    return s_config.runningInCloud;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnIsRunningInCloudSecure(GfnIsRunningInCloudAssurance* assurance)
+{
+    mockEnter();
+    if (assurance != NULL)
+    {
+        *assurance = s_config.runningInCloud ? gfnIsCloudLowAssurance : gfnNotCloud;
+    }
+    return s_config.callResult;
+}
+
+bool NVGFNSDKApi gfnIsTitleAvailable(const char* pchPlatformAppId)
+{
+    (void)pchPlatformAppId;
+    mockEnter();
+    return s_config.titleAvailable;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetTitlesAvailable(const char** ppchPlatformAppIds)
+{
+    mockEnter();
+    if (ppchPlatformAppIds != NULL)
+    {
+        *ppchPlatformAppIds = "mock_title_1,mock_title_2";
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnSetupTitle(const char* pchPlatformAppId)
+{
+    (void)pchPlatformAppId;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetClientIp(const char** ppchClientIp)
+{
+    mockEnter();
+    if (ppchClientIp != NULL)
+    {
+        *ppchClientIp = "192.168.0.1";
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetClientLanguageCode(const char** ppchLanguageCode)
+{
+    mockEnter();
+    if (ppchLanguageCode != NULL)
+    {
+        *ppchLanguageCode = "en-US";
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetClientCountryCode(char* pchCountryCode, unsigned int length)
+{
+    mockEnter();
+    if (pchCountryCode != NULL && length >= CC_SIZE)
+    {
+        pchCountryCode[0] = 'U';
+        pchCountryCode[1] = 'S';
+        pchCountryCode[2] = '\0';
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError gfnGetClientInfo(GfnClientInfo* clientInfo)
+{
+    mockEnter();
+    if (clientInfo != NULL)
+    {
+        clientInfo->osType = gfnWindows;
+        memcpy(clientInfo->ipV4, "192.168.0.1", sizeof("192.168.0.1"));
+        memcpy(clientInfo->country, "US", sizeof("US"));
+        memcpy(clientInfo->locale, "en-US", sizeof("en-US"));
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetCustomData(const char** ppchCustomData)
+{
+    mockEnter();
+    if (ppchCustomData != NULL)
+    {
+        *ppchCustomData = "mock custom data";
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnGetAuthData(const char** ppchAuthData)
+{
+    mockEnter();
+    if (ppchAuthData != NULL)
+    {
+        *ppchAuthData = "mock auth data";
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnFree(const char** ppchData)
+{
+    mockEnter();
+    // Everything handed out above is static, there is nothing to release
+    if (ppchData != NULL)
+    {
+        *ppchData = NULL;
+    }
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnAppReady(bool success, const char* status)
+{
+    (void)success;
+    (void)status;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnSetActionZone(GfnActionType type, unsigned int id, GfnRect* zone)
+{
+    (void)type;
+    (void)id;
+    (void)zone;
+    mockEnter();
+    return s_config.callResult;
+}
+
+// The wrapper registers its own trampolines, which the cloud library calls with (status, data, context)
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterExitCallback(ExitCallbackSig exitCallback, void* pUserContext)
+{
+    (void)exitCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterPauseCallback(PauseCallbackSig pauseCallback, void* pUserContext)
+{
+    (void)pauseCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterInstallCallback(InstallCallbackSig installCallback, void* pUserContext)
+{
+    (void)installCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterSaveCallback(SaveCallbackSig saveCallback, void* pUserContext)
+{
+    (void)saveCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterSessionInitCallback(SessionInitCallbackSig sessionInitCallback, void* pUserContext)
+{
+    (void)sessionInitCallback;
+    (void)pUserContext;
+    mockEnter();
+    return s_config.callResult;
+}
+
+GfnRuntimeError NVGFNSDKApi gfnRegisterClientInfoCallback(ClientInfoCallbackSig clientInfoCallback, void* pUserContext)
+{
+    mockEnter();
+    s_clientInfoCallback = (void*)clientInfoCallback;
+    s_clientInfoContext = pUserContext;
+    return s_config.callResult;
+}
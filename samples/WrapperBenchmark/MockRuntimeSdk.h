@@ -0,0 +1,100 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2021 NVIDIA Corporation. All rights reserved.
+
+// Stand-in for GfnRuntimeSdk.dll and GFN.dll that exports the same gfn* entry points with
+// configurable latency and results. It lets the wrapper be exercised and measured on machines
+// without the signed NVIDIA libraries. It is not an emulation of GeForce NOW behavior: every
+// call simply spins for the configured time and returns the configured result.
+//
+// The same source is built twice, as the client library (GfnRuntimeSdk) and as the cloud
+// library (GFN), since the wrapper loads the two from different paths.
+
+#ifndef MOCK_RUNTIME_SDK_H
+#define MOCK_RUNTIME_SDK_H
+
+#include "GfnRuntimeSdk_CAPI.h"
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /// @brief Behavior of the mocked entry points, applied with gfnMockConfigure
+    typedef struct GfnMockConfig
+    {
+        unsigned int callLatencyUs;     ///< Busy wait inside every mocked API, in microseconds
+        unsigned int initLatencyUs;     ///< Additional busy wait inside the initialize entry points
+        GfnRuntimeError initResult;     ///< Returned by the initialize entry points
+        GfnRuntimeError callResult;     ///< Returned by every other API that returns GfnRuntimeError
+        bool runningInCloud;            ///< Returned by gfnIsRunningInCloud
+        bool titleAvailable;            ///< Returned by gfnIsTitleAvailable
+    } GfnMockConfig;
+
+    /// Default configuration: no latency, every call succeeds, running in the cloud.
+    /// It can also be set through the environment for callers that cannot reach gfnMockConfigure:
+    /// GFN_MOCK_CALL_LATENCY_US, GFN_MOCK_INIT_LATENCY_US, GFN_MOCK_CALL_RESULT, GFN_MOCK_NOT_CLOUD.
+    typedef void(*gfnMockConfigureFn)(const GfnMockConfig* config);
+    /// Number of gfn* calls the library has served, to check a benchmark really reached it
+    typedef unsigned long long(*gfnMockGetCallCountFn)(void);
+    /// Synchronously calls the registered client info callback the way the cloud library does
+    typedef void(*gfnMockInvokeClientInfoCallbackFn)(void);
+
+    NVGFNSDK_EXPORT void NVGFNSDKApi gfnMockConfigure(const GfnMockConfig* config);
+    NVGFNSDK_EXPORT unsigned long long NVGFNSDKApi gfnMockGetCallCount(void);
+    NVGFNSDK_EXPORT void NVGFNSDKApi gfnMockInvokeClientInfoCallback(void);
+
+    /// Monotonic time in nanoseconds, shared by the mock and the benchmark
+    static inline unsigned long long gfnMockNowNs(void)
+    {
+#ifdef _WIN32
+        static LARGE_INTEGER s_frequency;
+        LARGE_INTEGER counter;
+        if (s_frequency.QuadPart == 0)
+        {
+            QueryPerformanceFrequency(&s_frequency);
+        }
+        QueryPerformanceCounter(&counter);
+        return (unsigned long long)(counter.QuadPart / s_frequency.QuadPart) * 1000000000ull +
+            (unsigned long long)(counter.QuadPart % s_frequency.QuadPart) * 1000000000ull / (unsigned long long)s_frequency.QuadPart;
+#else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#endif
+    }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // MOCK_RUNTIME_SDK_H